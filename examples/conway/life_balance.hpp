@@ -0,0 +1,207 @@
+/**
+ * @file life_balance.hpp
+ * @brief Dynamic load balancing of the mpi_life decomposition
+ *
+ * The nodes of the cluster do not run at the same speed (node01 runs the full
+ * desktop OS, the others the Lite image), and with equal tiles the slowest
+ * process sets the pace. Every process measures the time it spends updating
+ * cells; periodically the times are shared and the row and/or column
+ * boundaries of the process grid are moved so each slice gets a share of the
+ * board proportional to its speed. Cells then migrate to their new owners,
+ * which are the neighbors as long as a boundary does not move past a whole
+ * slice.
+ */
+
+#ifndef LIFE_BALANCE_HPP
+#define LIFE_BALANCE_HPP
+
+#include <mpi.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "life_decomp.hpp"
+
+/**
+ * @brief Load imbalance of a set of times: how much the slowest exceeds the mean
+ * @param times Time of every process
+ * @return max / mean - 1 (0 when perfectly balanced)
+ */
+inline double imbalance(const std::vector<double> &times) {
+    double worst = 0, sum = 0;
+    for (double t : times) {
+        worst = std::max(worst, t);
+        sum += t;
+    }
+    return sum > 0 ? worst * times.size() / sum - 1 : 0;
+}
+
+/**
+ * @brief Collects the compute time of every process
+ * @param tile Local tile (collective over tile.comm)
+ * @param time Time of this process
+ * @return Times indexed by rank
+ */
+inline std::vector<double> gatherTimes(const Tile &tile, double time) {
+    std::vector<double> times(tile.size);
+    MPI_Allgather(&time, 1, MPI_DOUBLE, times.data(), 1, MPI_DOUBLE, tile.comm);
+    return times;
+}
+
+/**
+ * @brief Splits n items into slices whose sizes are inversely proportional to their cost
+ * @param n Number of items (rows or columns)
+ * @param cost Time per item of every slice
+ * @param min_size Smallest slice allowed (p * min_size <= n)
+ * @return First item of every slice, then n
+ */
+inline std::vector<int> proportionalBounds(int n, const std::vector<double> &cost, int min_size) {
+    const int p = static_cast<int>(cost.size());
+    double total = 0;
+    for (double c : cost)
+        total += 1 / c;
+
+    std::vector<int> bounds(p + 1, 0);
+    double acc = 0;
+    for (int i = 0; i < p; ++i) {
+        acc += 1 / cost[i];
+        bounds[i + 1] = static_cast<int>(std::lround(n * acc / total));
+    }
+    bounds[p] = n;
+    for (int i = 1; i < p; ++i)
+        bounds[i] = std::max(bounds[i], bounds[i - 1] + min_size);
+    for (int i = p - 1; i > 0; --i)
+        bounds[i] = std::min(bounds[i], bounds[i + 1] - min_size);
+    return bounds;
+}
+
+/// Outcome of planRebalance
+struct Rebalance {
+    std::vector<int> row_bounds, col_bounds;  ///< New boundaries
+    bool moved = false;    ///< Whether any boundary changed
+    double before = 0;     ///< Measured imbalance
+    double after = 0;      ///< Imbalance predicted with the new boundaries
+};
+
+/**
+ * @brief Chooses new slice boundaries from the compute time of every process
+ *
+ * The time of a process is modeled as proportional to its cells. Each
+ * process row gets rows in proportion to the speed of its slowest member,
+ * and likewise for columns. Moving rows, columns or both are predicted with
+ * the model and the one with the fastest slowest process is kept; nothing
+ * moves unless that gains at least 3%.
+ * @param tile Local tile (collective over tile.comm)
+ * @param time Compute time per generation of this process
+ * @param min_rows Fewest rows a tile may keep
+ * @param min_cols Fewest columns a tile may keep
+ */
+inline Rebalance planRebalance(const Tile &tile, double time, int min_rows, int min_cols) {
+    std::vector<double> times = gatherTimes(tile, time);
+
+    std::vector<int> row_of(tile.size), col_of(tile.size);
+    std::vector<double> row_cost(tile.dims[0], 0), col_cost(tile.dims[1], 0);
+    for (int r = 0; r < tile.size; ++r) {
+        int coords[2];
+        MPI_Cart_coords(tile.comm, r, 2, coords);
+        row_of[r] = coords[0];
+        col_of[r] = coords[1];
+        int h = tile.row_bounds[coords[0] + 1] - tile.row_bounds[coords[0]];
+        int w = tile.col_bounds[coords[1] + 1] - tile.col_bounds[coords[1]];
+        row_cost[coords[0]] = std::max(row_cost[coords[0]], times[r] / h);
+        col_cost[coords[1]] = std::max(col_cost[coords[1]], times[r] / w);
+    }
+
+    Rebalance best;
+    best.row_bounds = tile.row_bounds;
+    best.col_bounds = tile.col_bounds;
+    best.before = best.after = imbalance(times);
+    if (*std::min_element(times.begin(), times.end()) <= 0)
+        return best;
+    const double slowest = *std::max_element(times.begin(), times.end());
+
+    std::vector<int> rows = proportionalBounds(tile.rows, row_cost, min_rows);
+    std::vector<int> cols = proportionalBounds(tile.cols, col_cost, min_cols);
+    double best_max = slowest;
+    for (int option = 0; option < 3; ++option) {
+        const std::vector<int> &rb = option == 1 ? tile.row_bounds : rows;
+        const std::vector<int> &cb = option == 0 ? tile.col_bounds : cols;
+        std::vector<double> predicted(tile.size);
+        for (int r = 0; r < tile.size; ++r) {
+            int i = row_of[r], j = col_of[r];
+            predicted[r] = times[r] * (rb[i + 1] - rb[i]) / (tile.row_bounds[i + 1] - tile.row_bounds[i])
+                                    * (cb[j + 1] - cb[j]) / (tile.col_bounds[j + 1] - tile.col_bounds[j]);
+        }
+        double predicted_max = *std::max_element(predicted.begin(), predicted.end());
+        if (predicted_max < 0.97 * best_max) {
+            best_max = predicted_max;
+            best.row_bounds = rb;
+            best.col_bounds = cb;
+            best.after = imbalance(predicted);
+            best.moved = true;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Moves the active cells of a grid to their owners in a new decomposition
+ *
+ * Every process sends the part of its old tile that falls in each new tile,
+ * one byte per cell, with a single MPI_Alltoallv; the counts are known on
+ * both sides from the boundaries, so no count exchange is needed.
+ * @param from Grid of the old tile
+ * @param old_tile Old decomposition
+ * @param to Grid of the new tile (ghost frame left untouched)
+ * @param new_tile New decomposition (same communicator)
+ */
+template <typename G>
+void migrateCells(const G &from, const Tile &old_tile, G &to, const Tile &new_tile) {
+    struct Box { int r0, r1, c0, c1; };
+    auto box = [](const Tile &t, int rank) {
+        int coords[2], row0, nrows, col0, ncols;
+        MPI_Cart_coords(t.comm, rank, 2, coords);
+        tileExtent(t, coords, row0, nrows, col0, ncols);
+        return Box{row0, row0 + nrows, col0, col0 + ncols};
+    };
+    auto overlap = [](const Box &a, const Box &b) {
+        return Box{std::max(a.r0, b.r0), std::min(a.r1, b.r1), std::max(a.c0, b.c0), std::min(a.c1, b.c1)};
+    };
+    auto cells = [](const Box &b) { return b.r1 > b.r0 && b.c1 > b.c0 ? (b.r1 - b.r0) * (b.c1 - b.c0) : 0; };
+
+    const int size = old_tile.size;
+    const Box mine_old = box(old_tile, old_tile.rank), mine_new = box(new_tile, new_tile.rank);
+    std::vector<int> send_counts(size), send_displs(size), recv_counts(size), recv_displs(size);
+    std::vector<uint8_t> send;
+    int total = 0;
+    for (int r = 0; r < size; ++r) {
+        Box out = overlap(mine_old, box(new_tile, r));
+        send_displs[r] = static_cast<int>(send.size());
+        send_counts[r] = cells(out);
+        if (send_counts[r] > 0)
+            for (int i = out.r0; i < out.r1; ++i)
+                for (int j = out.c0; j < out.c1; ++j)
+                    send.push_back(static_cast<uint8_t>(
+                        from.get(from.halo + i - mine_old.r0, from.halo + j - mine_old.c0)));
+        recv_displs[r] = total;
+        recv_counts[r] = cells(overlap(box(old_tile, r), mine_new));
+        total += recv_counts[r];
+    }
+
+    std::vector<uint8_t> recv(total);
+    MPI_Alltoallv(send.data(), send_counts.data(), send_displs.data(), MPI_BYTE,
+                  recv.data(), recv_counts.data(), recv_displs.data(), MPI_BYTE, new_tile.comm);
+
+    for (int r = 0; r < size; ++r) {
+        if (recv_counts[r] == 0)
+            continue;
+        Box in = overlap(box(old_tile, r), mine_new);
+        const uint8_t *p = recv.data() + recv_displs[r];
+        for (int i = in.r0; i < in.r1; ++i)
+            for (int j = in.c0; j < in.c1; ++j)
+                to.set(to.halo + i - mine_new.r0, to.halo + j - mine_new.c0, *p++);
+    }
+}
+
+#endif
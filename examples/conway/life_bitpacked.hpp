@@ -0,0 +1,266 @@
+/**
+ * @file life_bitpacked.hpp
+ * @brief Bit-packed grid backend for mpi_life (64 cells per uint64_t)
+ *
+ * Each local row is stored as a run of 64-bit words inside one contiguous
+ * row-major buffer, 64 cells per word. Ghost columns are plain bits next to
+ * the active ones, so the kernel never computes a modulo, and halos are
+ * packed into dense bit streams before they travel.
+ *
+ * The next generation is computed with bit-sliced adders: the eight neighbor
+ * bitboards of a word are summed with full/half adders, which evaluates 64
+ * cells per logical operation. The kernel is written once over a generic word
+ * type and instantiated with GCC vector types, which the compiler lowers to
+ * NEON on the Raspberry Pi and to SSE2/AVX2 on x86.
+ */
+
+#ifndef LIFE_BITPACKED_HPP
+#define LIFE_BITPACKED_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "life_grid.hpp"
+
+/// Number of 64-bit lanes processed per SIMD step
+#if defined(__AVX2__)
+constexpr int BIT_LANES = 4;
+#else
+constexpr int BIT_LANES = 2;
+#endif
+
+/// SIMD vector of BIT_LANES 64-bit words (NEON / SSE2 / AVX2 depending on target)
+typedef uint64_t BitVec __attribute__((vector_size(8 * BIT_LANES)));
+
+/**
+ * @brief Local tile with one bit per cell and a ghost frame
+ *
+ * Uses the same stored coordinates as Grid: active rows are
+ * [halo, halo + rows) and active columns [halo, halo + cols). Stored column j
+ * is bit 64 + j of the row, so word 0 and the last word of every row are
+ * always-zero guards and the kernel can read one word past any cell word.
+ */
+struct BitGrid {
+    int rows = 0;    ///< Active local rows
+    int cols = 0;    ///< Active local columns
+    int halo = 0;    ///< Width of the ghost frame
+    int stride = 0;  ///< Words per stored row, guards included
+    std::vector<uint64_t, DefaultInitAllocator<uint64_t>> cells;
+
+    BitGrid() = default;
+    /// Allocates the tile; with zero = false the caller must zeroRows() every stored row
+    BitGrid(int rows_, int cols_, int halo_, bool zero = true)
+        : rows(rows_), cols(cols_), halo(halo_), stride((cols_ + 2 * halo_ + 63) / 64 + 2),
+          cells(static_cast<size_t>(rows_ + 2 * halo_) * stride) {
+        if (zero)
+            zeroRows(0, rows + 2 * halo);
+    }
+
+    /// Clears stored rows [i0, i1), guard words included
+    void zeroRows(int i0, int i1) {
+        std::fill(cells.begin() + static_cast<size_t>(i0) * stride, cells.begin() + static_cast<size_t>(i1) * stride, 0);
+    }
+
+    uint64_t *row(int i) { return &cells[static_cast<size_t>(i) * stride]; }
+    const uint64_t *row(int i) const { return &cells[static_cast<size_t>(i) * stride]; }
+
+    int get(int i, int j) const { return (row(i)[(64 + j) / 64] >> (j % 64)) & 1; }
+    void set(int i, int j, int v) {
+        uint64_t bit = uint64_t(1) << (j % 64);
+        if (v) row(i)[(64 + j) / 64] |= bit;
+        else   row(i)[(64 + j) / 64] &= ~bit;
+    }
+
+    void swap(BitGrid &other) { cells.swap(other.cells); }
+};
+
+/**
+ * @brief Initializes the active cells with random 0s and 1s
+ *
+ * Draws rand() in the same order as the int backend, so both engines start
+ * from the same board for a given seed.
+ * @param grid The grid to initialize
+ */
+inline void initGrid(BitGrid &grid) {
+    for (int i = grid.halo; i < grid.halo + grid.rows; ++i)
+        for (int j = grid.halo; j < grid.halo + grid.cols; ++j)
+            grid.set(i, j, rand() % 2);
+}
+
+/**
+ * @brief Reads 64 bits starting at an arbitrary bit offset
+ * @param src Source words
+ * @param bit Bit offset
+ * @return The bits, lowest offset in bit 0
+ */
+inline uint64_t readBits(const uint64_t *src, size_t bit) {
+    size_t w = bit / 64;
+    unsigned s = bit % 64;
+    return s ? (src[w] >> s) | (src[w + 1] << (64 - s)) : src[w];
+}
+
+/**
+ * @brief Writes the low n bits of v at an arbitrary bit offset
+ * @param dst Destination words
+ * @param bit Bit offset
+ * @param v Bits to write
+ * @param n Number of bits (1..64)
+ */
+inline void writeBits(uint64_t *dst, size_t bit, uint64_t v, unsigned n) {
+    uint64_t mask = (n == 64) ? ~uint64_t(0) : (uint64_t(1) << n) - 1;
+    size_t w = bit / 64;
+    unsigned s = bit % 64;
+    v &= mask;
+    dst[w] = (dst[w] & ~(mask << s)) | (v << s);
+    if (s + n > 64)
+        dst[w + 1] = (dst[w + 1] & ~(mask >> (64 - s))) | (v >> (64 - s));
+}
+
+/**
+ * @brief Copies n bits between two arbitrary bit offsets
+ *
+ * The source must be readable up to the word following its last bit.
+ * @param dst Destination words
+ * @param dst_bit Destination bit offset
+ * @param src Source words
+ * @param src_bit Source bit offset
+ * @param n Number of bits
+ */
+inline void copyBits(uint64_t *dst, size_t dst_bit, const uint64_t *src, size_t src_bit, size_t n) {
+    while (n > 0) {
+        unsigned chunk = n < 64 ? static_cast<unsigned>(n) : 64;
+        writeBits(dst, dst_bit, readBits(src, src_bit), chunk);
+        dst_bit += chunk;
+        src_bit += chunk;
+        n -= chunk;
+    }
+}
+
+/// Loads W consecutive words (unaligned)
+template <typename W>
+inline W loadWords(const uint64_t *p) {
+    W v;
+    std::memcpy(&v, p, sizeof(W));
+    return v;
+}
+
+/// Stores W consecutive words (unaligned)
+template <typename W>
+inline void storeWords(uint64_t *p, W v) { std::memcpy(p, &v, sizeof(W)); }
+
+/**
+ * @brief Computes the next state of the sizeof(W) / 8 words at mid
+ *
+ * Sums the eight shifted neighbor bitboards with a tree of bit-sliced full
+ * adders and applies B3/S23: a cell is alive next if its count is 3, or if
+ * it is 2 and the cell is alive.
+ * @param up Row above, pointing at the first word to compute
+ * @param mid Current row
+ * @param down Row below
+ * @return Next state of the words
+ */
+template <typename W>
+inline W lifeWord(const uint64_t *up, const uint64_t *mid, const uint64_t *down) {
+    W a = loadWords<W>(up), m = loadWords<W>(mid), b = loadWords<W>(down);
+    W aw = (a << 1) | (loadWords<W>(up - 1) >> 63),   ae = (a >> 1) | (loadWords<W>(up + 1) << 63);
+    W mw = (m << 1) | (loadWords<W>(mid - 1) >> 63),  me = (m >> 1) | (loadWords<W>(mid + 1) << 63);
+    W bw = (b << 1) | (loadWords<W>(down - 1) >> 63), be = (b >> 1) | (loadWords<W>(down + 1) << 63);
+
+    // Column of three above, two beside and three below: weight-1 sums and carries
+    W s0 = aw ^ a ^ ae,   c0 = (aw & a) | (ae & (aw ^ a));
+    W s1 = bw ^ b ^ be,   c1 = (bw & b) | (be & (bw ^ b));
+    W s2 = mw ^ me,       c2 = mw & me;
+
+    W ones = s0 ^ s1 ^ s2;
+    W c3 = (s0 & s1) | (s2 & (s0 ^ s1));
+
+    // Four weight-2 carries: twos bit and "four or more" flag
+    W t = c0 ^ c1 ^ c2;
+    W c4 = (c0 & c1) | (c2 & (c0 ^ c1));
+    W twos = t ^ c3;
+    W fours = c4 | (t & c3);
+
+    return ~fours & twos & (ones | m);
+}
+
+/**
+ * @brief Applies Conway's rules to a rectangle of the grid
+ *
+ * Works on whole words, so cells sharing a word with the rectangle are
+ * recomputed too; they get their correct value whenever their neighbors are
+ * valid, which keeps overlapping passes harmless.
+ * @param current The current grid
+ * @param next The updated grid
+ * @param r0 First stored row
+ * @param r1 One past the last stored row
+ * @param c0 First stored column
+ * @param c1 One past the last stored column
+ */
+inline void updateGrid(const BitGrid &current, BitGrid &next, int r0, int r1, int c0, int c1) {
+    if (c1 <= c0)
+        return;
+    const int w0 = (64 + c0) / 64;
+    const int w1 = (64 + c1 - 1) / 64 + 1;
+
+    for (int i = r0; i < r1; ++i) {
+        const uint64_t *up = current.row(i - 1), *mid = current.row(i), *down = current.row(i + 1);
+        uint64_t *out = next.row(i);
+        int w = w0;
+        for (; w + BIT_LANES <= w1; w += BIT_LANES)
+            storeWords(out + w, lifeWord<BitVec>(up + w, mid + w, down + w));
+        for (; w < w1; ++w)
+            out[w] = lifeWord<uint64_t>(up + w, mid + w, down + w);
+    }
+}
+
+/**
+ * @brief Like updateGrid, and reports whether any cell differs from what next held
+ *
+ * Only the bits of the rectangle are compared; the other bits of its first
+ * and last words are rewritten as in updateGrid but do not count.
+ * @param current The current grid
+ * @param next The updated grid
+ * @param r0 First stored row
+ * @param r1 One past the last stored row
+ * @param c0 First stored column
+ * @param c1 One past the last stored column
+ * @return true if a cell of the rectangle changed in next
+ */
+inline bool updateGridChanged(const BitGrid &current, BitGrid &next, int r0, int r1, int c0, int c1) {
+    if (c1 <= c0)
+        return false;
+    const int w0 = (64 + c0) / 64;
+    const int w1 = (64 + c1 - 1) / 64 + 1;
+    const uint64_t first = ~uint64_t(0) << ((64 + c0) % 64);
+    const uint64_t last = ~uint64_t(0) >> (63 - (64 + c1 - 1) % 64);
+
+    uint64_t diff = 0;
+    BitVec vdiff = {};
+    for (int i = r0; i < r1; ++i) {
+        const uint64_t *up = current.row(i - 1), *mid = current.row(i), *down = current.row(i + 1);
+        uint64_t *out = next.row(i);
+        auto word = [&](int w, uint64_t mask) {
+            uint64_t v = lifeWord<uint64_t>(up + w, mid + w, down + w);
+            diff |= (v ^ out[w]) & mask;
+            out[w] = v;
+        };
+
+        word(w0, w1 - w0 == 1 ? first & last : first);
+        int w = w0 + 1;
+        for (; w + BIT_LANES <= w1 - 1; w += BIT_LANES) {
+            BitVec v = lifeWord<BitVec>(up + w, mid + w, down + w);
+            vdiff |= v ^ loadWords<BitVec>(out + w);
+            storeWords(out + w, v);
+        }
+        for (; w < w1 - 1; ++w)
+            word(w, ~uint64_t(0));
+        if (w1 - w0 > 1)
+            word(w1 - 1, last);
+    }
+    for (int k = 0; k < BIT_LANES; ++k)
+        diff |= vdiff[k];
+    return diff != 0;
+}
+
+#endif
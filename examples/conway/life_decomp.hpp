@@ -0,0 +1,180 @@
+/**
+ * @file life_decomp.hpp
+ * @brief 2D block decomposition of the mpi_life board
+ *
+ * The board is split into rectangular tiles over a periodic Cartesian process
+ * grid (MPI_Cart_create), so the board is a torus in both directions. Rows
+ * and columns that do not divide evenly are spread one by one over the first
+ * process rows/columns, which lets mpi_life run on any rank count.
+ */
+
+#ifndef LIFE_DECOMP_HPP
+#define LIFE_DECOMP_HPP
+
+#include <mpi.h>
+#include <algorithm>
+#include <vector>
+
+/// Neighbor directions as (row offset, column offset); the opposite of d is 7 - d
+const int DIRS[8][2] = {{-1, -1}, {-1, 0}, {-1, 1},
+                        { 0, -1},          { 0, 1},
+                        { 1, -1}, { 1, 0}, { 1, 1}};
+
+/**
+ * @brief First index of block i when n items are split into p blocks
+ *
+ * The first n % p blocks get one extra item.
+ */
+inline int blockStart(int n, int p, int i) { return i * (n / p) + std::min(i, n % p); }
+
+/// Slice holding item x, given the first item of every slice plus the total
+inline int sliceOwner(const std::vector<int> &bounds, int x) {
+    return static_cast<int>(std::upper_bound(bounds.begin(), bounds.end(), x) - bounds.begin()) - 1;
+}
+
+/**
+ * @brief Local tile of the board owned by this process
+ */
+struct Tile {
+    MPI_Comm comm = MPI_COMM_NULL;  ///< Periodic 2D Cartesian communicator
+    int rank = 0;                   ///< Rank in comm
+    int size = 1;                   ///< Number of processes
+    int dims[2] = {1, 1};           ///< Process grid (rows, columns)
+    int coords[2] = {0, 0};         ///< Position of this process in the grid
+    int rows = 0, cols = 0;         ///< Global board size
+    int row0 = 0, col0 = 0;         ///< Global position of the first local cell
+    int local_rows = 0;             ///< Rows owned by this process
+    int local_cols = 0;             ///< Columns owned by this process
+    int neighbors[8];               ///< Neighbor ranks, indexed like DIRS
+    std::vector<int> row_bounds;    ///< First row of every process row, then the board rows
+    std::vector<int> col_bounds;    ///< First column of every process column, then the board columns
+};
+
+/**
+ * @brief Rectangle of a local grid in stored coordinates
+ */
+struct Region {
+    int r0, nr;  ///< First stored row and row count
+    int c0, nc;  ///< First stored column and column count
+};
+
+/**
+ * @brief Chooses the process grid that minimizes the halo perimeter per tile
+ * @param size Number of processes
+ * @param rows Board rows
+ * @param cols Board columns
+ * @param dims Output process grid (rows, columns)
+ * @return false if the board is too small to give every process a cell
+ */
+inline bool chooseProcessGrid(int size, int rows, int cols, int dims[2]) {
+    double best = -1;
+    for (int py = 1; py <= size; ++py) {
+        if (size % py != 0) continue;
+        int px = size / py;
+        if (py > rows || px > cols) continue;
+        double perimeter = static_cast<double>(rows) / py + static_cast<double>(cols) / px;
+        if (best < 0 || perimeter < best) {
+            best = perimeter;
+            dims[0] = py;
+            dims[1] = px;
+        }
+    }
+    return best >= 0;
+}
+
+/**
+ * @brief Computes the board rectangle owned by the process at given coordinates
+ * @param tile Any tile of the decomposition
+ * @param coords Process grid coordinates
+ * @param row0 First global row
+ * @param nrows Number of rows
+ * @param col0 First global column
+ * @param ncols Number of columns
+ */
+inline void tileExtent(const Tile &tile, const int coords[2], int &row0, int &nrows, int &col0, int &ncols) {
+    row0 = tile.row_bounds[coords[0]];
+    nrows = tile.row_bounds[coords[0] + 1] - row0;
+    col0 = tile.col_bounds[coords[1]];
+    ncols = tile.col_bounds[coords[1] + 1] - col0;
+}
+
+/**
+ * @brief Moves the slice boundaries of the decomposition and updates the local extent
+ * @param tile Local tile
+ * @param row_bounds First row of every process row, then the board rows
+ * @param col_bounds First column of every process column, then the board columns
+ */
+inline void setBounds(Tile &tile, const std::vector<int> &row_bounds, const std::vector<int> &col_bounds) {
+    tile.row_bounds = row_bounds;
+    tile.col_bounds = col_bounds;
+    tileExtent(tile, tile.coords, tile.row0, tile.local_rows, tile.col0, tile.local_cols);
+}
+
+/**
+ * @brief Creates the periodic Cartesian communicator and the local tile
+ * @param comm Parent communicator
+ * @param rows Board rows
+ * @param cols Board columns
+ * @param dims Process grid from chooseProcessGrid
+ * @return The local tile
+ */
+inline Tile makeTile(MPI_Comm comm, int rows, int cols, const int dims[2]) {
+    Tile tile;
+    int periods[2] = {1, 1};
+    tile.dims[0] = dims[0];
+    tile.dims[1] = dims[1];
+    MPI_Cart_create(comm, 2, tile.dims, periods, 1, &tile.comm);
+    MPI_Comm_rank(tile.comm, &tile.rank);
+    MPI_Comm_size(tile.comm, &tile.size);
+    MPI_Cart_coords(tile.comm, tile.rank, 2, tile.coords);
+
+    tile.rows = rows;
+    tile.cols = cols;
+    std::vector<int> row_bounds(dims[0] + 1), col_bounds(dims[1] + 1);
+    for (int i = 0; i <= dims[0]; ++i)
+        row_bounds[i] = blockStart(rows, dims[0], i);
+    for (int j = 0; j <= dims[1]; ++j)
+        col_bounds[j] = blockStart(cols, dims[1], j);
+    setBounds(tile, row_bounds, col_bounds);
+
+    // Periodic dimensions let MPI_Cart_rank wrap out-of-range coordinates
+    for (int d = 0; d < 8; ++d) {
+        int nc[2] = {tile.coords[0] + DIRS[d][0], tile.coords[1] + DIRS[d][1]};
+        MPI_Cart_rank(tile.comm, nc, &tile.neighbors[d]);
+    }
+    return tile;
+}
+
+/**
+ * @brief Active cells sent to the neighbor in direction d
+ * @param rows Active local rows
+ * @param cols Active local columns
+ * @param h Halo width
+ * @param d Direction index
+ */
+inline Region sendRegion(int rows, int cols, int h, int d) {
+    Region r;
+    r.r0 = DIRS[d][0] > 0 ? rows : h;
+    r.nr = DIRS[d][0] == 0 ? rows : h;
+    r.c0 = DIRS[d][1] > 0 ? cols : h;
+    r.nc = DIRS[d][1] == 0 ? cols : h;
+    return r;
+}
+
+/**
+ * @brief Ghost cells filled by the neighbor in direction d
+ * @param rows Active local rows
+ * @param cols Active local columns
+ * @param h Halo width
+ * @param d Direction index
+ */
+inline Region ghostRegion(int rows, int cols, int h, int d) {
+    Region r;
+    r.r0 = DIRS[d][0] < 0 ? 0 : DIRS[d][0] == 0 ? h : h + rows;
+    r.nr = DIRS[d][0] == 0 ? rows : h;
+    r.c0 = DIRS[d][1] < 0 ? 0 : DIRS[d][1] == 0 ? h : h + cols;
+    r.nc = DIRS[d][1] == 0 ? cols : h;
+    return r;
+}
+
+#endif
@@ -0,0 +1,465 @@
+/**
+ * @file life_ensemble.hpp
+ * @brief Ensemble mode of mpi_life: many small independent boards
+ *
+ * Parameter sweeps (rules, seeds, densities) run hundreds of small boards.
+ * Splitting each one over the cluster would spend more time in halos than in
+ * cells, so in this mode every board is simulated whole by a single thread
+ * and nothing communicates within a board.
+ *
+ * Boards are handed out by a work queue: a counter on rank 0 that every
+ * process advances with MPI_Fetch_and_op, one chunk at a time, and a local
+ * queue feeding the threads of the process. Faster nodes simply take more
+ * boards. Each board stops as soon as its state repeats (the rest of the run
+ * is then known), and its statistics are appended to a CSV file with
+ * MPI_File_write_shared as soon as it finishes.
+ *
+ * Batch files have one line per group of boards, '#' starts a comment:
+ *
+ *     rows cols generations [rule [density [seed [copies]]]]
+ *
+ * The rule is written B.../S... (default B3/S23), density is the share of
+ * live cells of the random initial board (default 0.5) and copies repeats
+ * the line with seeds seed, seed + 1, ... (default seed 1, 1 copy).
+ */
+
+#ifndef LIFE_ENSEMBLE_HPP
+#define LIFE_ENSEMBLE_HPP
+
+#include <mpi.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "life_bitpacked.hpp"
+#include "life_threads.hpp"
+
+/// One board of the ensemble
+struct EnsembleJob {
+    int id = 0;               ///< Position in the batch
+    int rows = 0, cols = 0;   ///< Board size (a torus)
+    long gens = 0;            ///< Generations to simulate
+    std::string rule;         ///< Rule as written in the batch
+    uint16_t birth = 0;       ///< Bit n set: a dead cell with n neighbors is born
+    uint16_t survive = 0;     ///< Bit n set: a live cell with n neighbors survives
+    double density = 0.5;     ///< Share of live cells of the initial board
+    uint64_t seed = 1;        ///< Seed of the initial board
+};
+
+/**
+ * @brief Parses a rule written B.../S... (e.g. B3/S23, B36/S23, b2/s)
+ * @param text Rule
+ * @param birth Neighbor counts that give birth, one bit per count
+ * @param survive Neighbor counts that keep a cell alive
+ * @return false if the rule is malformed
+ */
+inline bool parseRule(const std::string &text, uint16_t &birth, uint16_t &survive) {
+    size_t slash = text.find('/');
+    if (slash == std::string::npos || slash == 0 || slash + 1 >= text.size() ||
+        (text[0] != 'B' && text[0] != 'b') || (text[slash + 1] != 'S' && text[slash + 1] != 's'))
+        return false;
+    birth = survive = 0;
+    for (size_t i = 1; i < text.size(); ++i) {
+        if (i == slash || i == slash + 1)
+            continue;
+        if (text[i] < '0' || text[i] > '8')
+            return false;
+        (i < slash ? birth : survive) |= static_cast<uint16_t>(1u << (text[i] - '0'));
+    }
+    return true;
+}
+
+/**
+ * @brief Expands a batch description into its boards
+ * @param text Contents of the batch file
+ * @param jobs Boards, in order
+ * @param error Set to the reason and line when parsing fails
+ * @return false if a line is malformed
+ */
+inline bool parseBatch(const std::string &text, std::vector<EnsembleJob> &jobs, std::string &error) {
+    std::istringstream in(text);
+    std::string line;
+    int number = 0;
+    jobs.clear();
+    while (std::getline(in, line)) {
+        ++number;
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        EnsembleJob job;
+        long copies = 1;
+        if (!(fields >> job.rows))
+            continue;
+        job.rule = "B3/S23";
+        fields >> job.cols >> job.gens;
+        if (!fields || job.rows < 1 || job.cols < 1 || job.gens < 0) {
+            error = "línea " + std::to_string(number) + ": se esperaba 'filas columnas generaciones'";
+            return false;
+        }
+        std::string extra;
+        if (fields >> job.rule) {
+            if (fields >> job.density && fields >> job.seed)
+                fields >> copies;
+        }
+        if (!parseRule(job.rule, job.birth, job.survive) || job.density < 0 || job.density > 1 || copies < 1 ||
+            (fields.clear(), fields >> extra)) {
+            error = "línea " + std::to_string(number) + ": regla, densidad o copias inválidas";
+            return false;
+        }
+        for (long k = 0; k < copies; ++k) {
+            jobs.push_back(job);
+            jobs.back().id = static_cast<int>(jobs.size()) - 1;
+            jobs.back().seed = job.seed + k;
+        }
+    }
+    if (jobs.empty()) {
+        error = "no describe ningún tablero";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Computes the next state of the sizeof(W) / 8 words at mid under any B/S rule
+ *
+ * Same adder tree as lifeWord, carried one bit further to get the whole
+ * neighbor count (0..8) as four bit planes; each count then selects the
+ * birth or survival mask.
+ * @param up Row above, pointing at the first word to compute
+ * @param mid Current row
+ * @param down Row below
+ * @param born Per neighbor count, all ones if a dead cell is born
+ * @param stay Per neighbor count, all ones if a live cell survives
+ * @return Next state of the words
+ */
+template <typename W>
+inline W ruleWord(const uint64_t *up, const uint64_t *mid, const uint64_t *down, const uint64_t born[9],
+                  const uint64_t stay[9]) {
+    W a = loadWords<W>(up), m = loadWords<W>(mid), b = loadWords<W>(down);
+    W aw = (a << 1) | (loadWords<W>(up - 1) >> 63),   ae = (a >> 1) | (loadWords<W>(up + 1) << 63);
+    W mw = (m << 1) | (loadWords<W>(mid - 1) >> 63),  me = (m >> 1) | (loadWords<W>(mid + 1) << 63);
+    W bw = (b << 1) | (loadWords<W>(down - 1) >> 63), be = (b >> 1) | (loadWords<W>(down + 1) << 63);
+
+    W s0 = aw ^ a ^ ae,   c0 = (aw & a) | (ae & (aw ^ a));
+    W s1 = bw ^ b ^ be,   c1 = (bw & b) | (be & (bw ^ b));
+    W s2 = mw ^ me,       c2 = mw & me;
+    W ones = s0 ^ s1 ^ s2;
+    W c3 = (s0 & s1) | (s2 & (s0 ^ s1));
+    W t = c0 ^ c1 ^ c2;
+    W c4 = (c0 & c1) | (c2 & (c0 ^ c1));
+    W twos = t ^ c3;
+    W c5 = t & c3;
+    W fours = c4 ^ c5, eights = c4 & c5;
+
+    W next = m & 0;
+    for (int n = 0; n <= 8; ++n) {
+        if (!born[n] && !stay[n])
+            continue;
+        W eq = (n & 1 ? ones : ~ones) & (n & 2 ? twos : ~twos) & (n & 4 ? fours : ~fours) & (n & 8 ? eights : ~eights);
+        next |= eq & ((m & stay[n]) | (~m & born[n]));
+    }
+    return next;
+}
+
+/// Statistics of one finished board
+struct EnsembleResult {
+    long simulated = 0;       ///< Generations actually computed (fewer once a cycle is found)
+    long population = 0;      ///< Live cells after the requested generations
+    long min_population = 0, max_population = 0;
+    long period = 0;          ///< Period of the cycle reached (0: none found)
+    long transient = 0;       ///< First generation of the cycle
+    double seconds = 0;
+};
+
+/**
+ * @brief A whole board on a torus, stepped by one thread
+ *
+ * Uses a BitGrid with a one-cell ghost frame that the board fills from its
+ * own opposite edges before every generation.
+ */
+class EnsembleBoard {
+public:
+    explicit EnsembleBoard(const EnsembleJob &job)
+        : job_(job), current_(job.rows, job.cols, 1), next_(job.rows, job.cols, 1),
+          last_word_((64 + job.cols) / 64 + 1) {
+        for (int n = 0; n <= 8; ++n) {
+            born_[n] = (job.birth >> n) & 1 ? ~uint64_t(0) : 0;
+            stay_[n] = (job.survive >> n) & 1 ? ~uint64_t(0) : 0;
+        }
+        // Active columns are stored bits [65, 65 + cols)
+        masks_.assign(last_word_, 0);
+        for (int w = 1; w < last_word_; ++w)
+            for (int bit = 0; bit < 64; ++bit) {
+                int c = 64 * w + bit - 64;
+                if (c >= 1 && c <= job.cols)
+                    masks_[w] |= uint64_t(1) << bit;
+            }
+        std::mt19937_64 rng(job.seed);
+        std::bernoulli_distribution alive(job.density);
+        for (int i = 1; i <= job.rows; ++i)
+            for (int j = 1; j <= job.cols; ++j)
+                current_.set(i, j, alive(rng));
+    }
+
+    /// Advances one generation
+    void step() {
+        wrap(current_);
+        for (int i = 1; i <= job_.rows; ++i) {
+            const uint64_t *up = current_.row(i - 1), *mid = current_.row(i), *down = current_.row(i + 1);
+            uint64_t *out = next_.row(i);
+            int w = 1;
+            for (; w + BIT_LANES <= last_word_; w += BIT_LANES)
+                storeWords(out + w, ruleWord<BitVec>(up + w, mid + w, down + w, born_, stay_));
+            for (; w < last_word_; ++w)
+                out[w] = ruleWord<uint64_t>(up + w, mid + w, down + w, born_, stay_);
+        }
+        current_.swap(next_);
+    }
+
+    /**
+     * @brief Counts the live cells and hashes the board in one pass
+     * @param hash Set to two independent 64-bit digests of the active cells
+     * @return Live cells
+     */
+    long population(uint64_t hash[2]) const {
+        long live = 0;
+        uint64_t h = 0x9E3779B97F4A7C15ULL, k = 0x2545F4914F6CDD1DULL;
+        for (int i = 1; i <= job_.rows; ++i) {
+            const uint64_t *row = current_.row(i);
+            for (int w = 1; w < last_word_; ++w) {
+                uint64_t v = row[w] & masks_[w];
+                live += __builtin_popcountll(v);
+                h = (h ^ v) * 0xFF51AFD7ED558CCDULL;
+                h ^= h >> 32;
+                k = (k + v + (k << 6)) * 0xC4CEB9FE1A85EC53ULL;
+                k ^= k >> 29;
+            }
+        }
+        hash[0] = h;
+        hash[1] = k;
+        return live;
+    }
+
+    /**
+     * @brief Runs the board, stopping early once a state repeats
+     *
+     * A state counts as repeated when both digests and the population match
+     * an earlier generation; a collision of the first digest alone only adds
+     * another entry to its bucket.
+     *
+     * @return Statistics of the board
+     */
+    EnsembleResult run() {
+        auto t0 = std::chrono::steady_clock::now();
+        EnsembleResult result;
+        std::vector<long> pops;
+        std::vector<uint64_t> checks;  // second digest of every generation
+        std::unordered_multimap<uint64_t, long> seen;
+        for (long g = 0;; ++g) {
+            uint64_t hash[2];
+            pops.push_back(population(hash));
+            checks.push_back(hash[1]);
+            auto range = seen.equal_range(hash[0]);
+            auto found = std::find_if(range.first, range.second, [&](const std::pair<const uint64_t, long> &e) {
+                return pops[e.second] == pops[g] && checks[e.second] == hash[1];
+            });
+            if (found != range.second) {
+                result.transient = found->second;
+                result.period = g - result.transient;
+                break;
+            }
+            seen.emplace(hash[0], g);
+            if (g == job_.gens)
+                break;
+            step();
+            ++result.simulated;
+        }
+        long last = job_.gens;
+        if (result.period > 0)
+            last = result.transient + (job_.gens - result.transient) % result.period;
+        result.population = pops[last];
+        result.min_population = *std::min_element(pops.begin(), pops.end());
+        result.max_population = *std::max_element(pops.begin(), pops.end());
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        return result;
+    }
+
+private:
+    /// Copies the opposite edges of the board into its ghost frame
+    static void wrap(BitGrid &g) {
+        for (int i = 1; i <= g.rows; ++i) {
+            g.set(i, 0, g.get(i, g.cols));
+            g.set(i, g.cols + 1, g.get(i, 1));
+        }
+        std::copy(g.row(g.rows), g.row(g.rows) + g.stride, g.row(0));
+        std::copy(g.row(1), g.row(1) + g.stride, g.row(g.rows + 1));
+    }
+
+    EnsembleJob job_;
+    BitGrid current_, next_;
+    int last_word_;                ///< One past the last word holding active cells
+    std::vector<uint64_t> masks_;  ///< Active bits of every word of a row
+    uint64_t born_[9], stay_[9];
+};
+
+/**
+ * @brief Shared counter of boards handed out, kept on rank 0
+ *
+ * Every process takes the next chunk with MPI_Fetch_and_op inside a
+ * passive-target epoch, so rank 0 does not run any dispatch loop.
+ */
+class WorkQueue {
+public:
+    /// Creates the counter (collective over comm)
+    explicit WorkQueue(MPI_Comm comm) {
+        int rank;
+        MPI_Comm_rank(comm, &rank);
+        MPI_Win_allocate(rank == 0 ? sizeof(long) : 0, sizeof(long), MPI_INFO_NULL, comm, &counter_, &win_);
+        if (rank == 0)
+            *counter_ = 0;
+        MPI_Barrier(comm);
+        MPI_Win_lock_all(0, win_);
+    }
+
+    ~WorkQueue() {
+        MPI_Win_unlock_all(win_);
+        MPI_Win_free(&win_);
+    }
+
+    WorkQueue(const WorkQueue &) = delete;
+    WorkQueue &operator=(const WorkQueue &) = delete;
+
+    /**
+     * @brief Takes the next n items
+     * @return Index of the first one; past the end once the work is over
+     */
+    long take(long n) {
+        long first;
+        MPI_Fetch_and_op(&n, &first, MPI_LONG, 0, 0, MPI_SUM, win_);
+        MPI_Win_flush(0, win_);
+        return first;
+    }
+
+private:
+    long *counter_;
+    MPI_Win win_;
+};
+
+/// Work done by one process in runEnsemble
+struct EnsembleStats {
+    long boards = 0;        ///< Boards finished
+    long periodic = 0;      ///< Boards that reached a cycle
+    long extinct = 0;       ///< Boards that died out
+    double cells = 0;       ///< Cell updates computed
+    double busy = 0;        ///< Thread time spent on boards, in seconds
+};
+
+/**
+ * @brief Runs every board of the batch over all processes and threads
+ *
+ * Thread 0 of each process is the only one that calls MPI: it keeps the
+ * local queue stocked from the shared counter and flushes the finished
+ * results to the CSV file between its own boards.
+ * @param comm Processes taking part (collective)
+ * @param pool Threads of this process
+ * @param jobs Boards of the batch (the same on every process)
+ * @param path CSV file that receives one line per board
+ * @param stats Work done by this process
+ * @return false if the file could not be opened
+ */
+inline bool runEnsemble(MPI_Comm comm, ThreadPool &pool, const std::vector<EnsembleJob> &jobs,
+                        const std::string &path, EnsembleStats &stats) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    MPI_File fh;
+    if (MPI_File_open(comm, path.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+        return false;
+    MPI_File_set_size(fh, 0);
+    if (rank == 0) {
+        const char header[] = "id,filas,columnas,regla,densidad,semilla,generaciones,simuladas,"
+                              "poblacion,poblacion_min,poblacion_max,periodo,transitorio,ms,rank,hilo\n";
+        MPI_File_write_shared(fh, header, static_cast<int>(strlen(header)), MPI_CHAR, MPI_STATUS_IGNORE);
+    }
+    MPI_Barrier(comm);
+
+    WorkQueue queue(comm);
+    const long total = static_cast<long>(jobs.size());
+    const long chunk = pool.size();
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<long> local;
+    bool exhausted = false;
+    std::string outbox;
+
+    auto flush = [&] {
+        std::string lines;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            lines.swap(outbox);
+        }
+        if (!lines.empty())
+            MPI_File_write_shared(fh, lines.data(), static_cast<int>(lines.size()), MPI_CHAR, MPI_STATUS_IGNORE);
+    };
+
+    pool.run([&](int t) {
+        for (;;) {
+            long index;
+            if (t == 0) {
+                flush();
+                std::unique_lock<std::mutex> lock(mutex);
+                if (!exhausted && static_cast<long>(local.size()) < chunk) {
+                    lock.unlock();
+                    long first = queue.take(chunk);
+                    lock.lock();
+                    for (long k = first; k < std::min(first + chunk, total); ++k)
+                        local.push_back(k);
+                    exhausted = first + chunk >= total;
+                    ready.notify_all();
+                }
+                if (local.empty()) {
+                    if (exhausted)
+                        return;
+                    continue;
+                }
+                index = local.front();
+                local.pop_front();
+            } else {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [&] { return !local.empty() || exhausted; });
+                if (local.empty())
+                    return;
+                index = local.front();
+                local.pop_front();
+            }
+
+            const EnsembleJob &job = jobs[index];
+            EnsembleResult r = EnsembleBoard(job).run();
+            char line[256];
+            snprintf(line, sizeof(line), "%d,%d,%d,%s,%g,%llu,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%.3f,%d,%d\n", job.id,
+                     job.rows, job.cols, job.rule.c_str(), job.density, static_cast<unsigned long long>(job.seed),
+                     job.gens, r.simulated, r.population, r.min_population, r.max_population, r.period,
+                     r.transient, r.seconds * 1e3, rank, t);
+            std::lock_guard<std::mutex> lock(mutex);
+            outbox += line;
+            stats.boards += 1;
+            stats.periodic += r.period > 0;
+            stats.extinct += r.population == 0;
+            stats.cells += static_cast<double>(job.rows) * job.cols * r.simulated;
+            stats.busy += r.seconds;
+        }
+    });
+    flush();
+    MPI_File_close(&fh);
+    return true;
+}
+
+#endif
@@ -0,0 +1,145 @@
+/**
+ * @file life_grid.hpp
+ * @brief Default grid backend for mpi_life: one int per cell
+ *
+ * The local tile is stored in one contiguous row-major buffer surrounded by a
+ * ghost frame of width `halo`, so column halos can be described with
+ * MPI_Type_vector and no neighbor lookup needs a modulo. Cells are addressed
+ * in stored coordinates: active rows are [halo, halo + rows) and active
+ * columns [halo, halo + cols).
+ */
+
+#ifndef LIFE_GRID_HPP
+#define LIFE_GRID_HPP
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Allocator that leaves new elements uninitialized
+ *
+ * Lets a grid be allocated without touching its pages, so each thread can
+ * fault in (first touch) the rows it will later update.
+ */
+template <typename T>
+struct DefaultInitAllocator : std::allocator<T> {
+    template <typename U>
+    struct rebind { using other = DefaultInitAllocator<U>; };
+
+    DefaultInitAllocator() = default;
+    template <typename U>
+    DefaultInitAllocator(const DefaultInitAllocator<U> &) {}
+
+    template <typename U>
+    void construct(U *p) { ::new (static_cast<void *>(p)) U; }
+    template <typename U, typename... Args>
+    void construct(U *p, Args &&...args) { ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...); }
+};
+
+/**
+ * @brief Local tile of int cells with a ghost frame
+ */
+struct Grid {
+    int rows = 0;  ///< Active local rows
+    int cols = 0;  ///< Active local columns
+    int halo = 0;  ///< Width of the ghost frame
+    int ld = 0;    ///< Ints per stored row (cols + 2 * halo)
+    std::vector<int, DefaultInitAllocator<int>> cells;
+
+    Grid() = default;
+    /// Allocates the tile; with zero = false the caller must zeroRows() every stored row
+    Grid(int rows_, int cols_, int halo_, bool zero = true)
+        : rows(rows_), cols(cols_), halo(halo_), ld(cols_ + 2 * halo_),
+          cells(static_cast<size_t>(rows_ + 2 * halo_) * ld) {
+        if (zero)
+            zeroRows(0, rows + 2 * halo);
+    }
+
+    /// Clears stored rows [i0, i1)
+    void zeroRows(int i0, int i1) {
+        std::fill(cells.begin() + static_cast<size_t>(i0) * ld, cells.begin() + static_cast<size_t>(i1) * ld, 0);
+    }
+
+    int *at(int i, int j) { return &cells[static_cast<size_t>(i) * ld + j]; }
+    const int *at(int i, int j) const { return &cells[static_cast<size_t>(i) * ld + j]; }
+
+    int get(int i, int j) const { return *at(i, j); }
+    void set(int i, int j, int v) { *at(i, j) = v; }
+
+    void swap(Grid &other) { cells.swap(other.cells); }
+};
+
+/**
+ * @brief Initializes the active cells with random 0s and 1s
+ * @param grid The grid to initialize
+ */
+inline void initGrid(Grid &grid) {
+    for (int i = grid.halo; i < grid.halo + grid.rows; ++i)
+        for (int j = grid.halo; j < grid.halo + grid.cols; ++j)
+            grid.set(i, j, rand() % 2);
+}
+
+/**
+ * @brief Counts the number of alive neighbors for a cell
+ * @param grid The grid, ghost frame already filled
+ * @param x Stored row index
+ * @param y Stored column index
+ * @return Number of alive neighbors
+ */
+inline int countAliveNeighbors(const Grid &grid, int x, int y) {
+    int count = 0;
+    for (int dx = -1; dx <= 1; ++dx)
+        for (int dy = -1; dy <= 1; ++dy) {
+            if (dx == 0 && dy == 0) continue;
+            if (grid.get(x + dx, y + dy) == 1)
+                ++count;
+        }
+    return count;
+}
+
+/**
+ * @brief Applies Conway's rules to a rectangle of the grid
+ * @param current The current grid
+ * @param next The updated grid
+ * @param r0 First stored row
+ * @param r1 One past the last stored row
+ * @param c0 First stored column
+ * @param c1 One past the last stored column
+ */
+inline void updateGrid(const Grid &current, Grid &next, int r0, int r1, int c0, int c1) {
+    for (int i = r0; i < r1; ++i)
+        for (int j = c0; j < c1; ++j) {
+            int alive = countAliveNeighbors(current, i, j);
+            next.set(i, j, (current.get(i, j) == 1) ?
+                ((alive == 2 || alive == 3) ? 1 : 0) :
+                ((alive == 3) ? 1 : 0));
+        }
+}
+
+/**
+ * @brief Like updateGrid, and reports whether any cell differs from what next held
+ * @param current The current grid
+ * @param next The updated grid
+ * @param r0 First stored row
+ * @param r1 One past the last stored row
+ * @param c0 First stored column
+ * @param c1 One past the last stored column
+ * @return true if a cell of the rectangle changed in next
+ */
+inline bool updateGridChanged(const Grid &current, Grid &next, int r0, int r1, int c0, int c1) {
+    bool changed = false;
+    for (int i = r0; i < r1; ++i)
+        for (int j = c0; j < c1; ++j) {
+            int alive = countAliveNeighbors(current, i, j);
+            int v = (current.get(i, j) == 1) ?
+                ((alive == 2 || alive == 3) ? 1 : 0) :
+                ((alive == 3) ? 1 : 0);
+            changed |= next.get(i, j) != v;
+            next.set(i, j, v);
+        }
+    return changed;
+}
+
+#endif
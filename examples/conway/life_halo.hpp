@@ -0,0 +1,392 @@
+/**
+ * @file life_halo.hpp
+ * @brief Ghost frame exchange with the 8 neighbors of a tile
+ *
+ * Each tile trades its edge rows and columns with the 4 side neighbors and its
+ * corner blocks directly with the 4 diagonal neighbors, so all 8 messages can
+ * be in flight at once. A message is tagged with the direction it travels,
+ * which keeps them apart when one rank is the neighbor on several sides
+ * (small process grids, or a single process that wraps onto itself).
+ *
+ * The exchange is split into start() and finish() around persistent
+ * requests, so the caller can update the interior of the tile while the
+ * messages are in flight. The sparse variants send an empty message for an
+ * edge equal to the one sent two exchanges ago, when the same grid of the
+ * double buffer was current, so the receiver keeps its ghost cells (see
+ * life_sparse.hpp).
+ *
+ * With shared memory enabled, neighbors on the same node trade edges through
+ * the mailboxes of life_shm.hpp instead; requests exist only for the others.
+ */
+
+#ifndef LIFE_HALO_HPP
+#define LIFE_HALO_HPP
+
+#include <mpi.h>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "life_grid.hpp"
+#include "life_bitpacked.hpp"
+#include "life_decomp.hpp"
+#include "life_shm.hpp"
+
+template <typename G>
+class HaloExchange;
+
+/**
+ * @brief Int backend: halos are described in place with MPI_Type_vector
+ *
+ * A region of nr rows and nc columns is nr blocks of nc ints separated by the
+ * grid row length, so no packing is done by hand.
+ */
+template <>
+class HaloExchange<Grid> {
+public:
+    /**
+     * @brief Builds persistent requests for both grids of the double buffer
+     * @param tile Local tile
+     * @param a Current grid
+     * @param b Next grid
+     * @param shm Trade edges with neighbors on the same node through shared memory
+     */
+    HaloExchange(const Tile &tile, Grid &a, Grid &b, bool shm = false) {
+        size_t bytes[8];
+        for (int d = 0; d < 8; ++d) {
+            Region r = ghostRegion(a.rows, a.cols, a.halo, d);
+            MPI_Type_vector(r.nr, r.nc, a.ld, MPI_INT, &types_[d]);
+            MPI_Type_commit(&types_[d]);
+            bytes[d] = static_cast<size_t>(r.nr) * r.nc * sizeof(int);
+        }
+        if (shm)
+            shm_.reset(new ShmMailboxes(tile, bytes));
+        Grid *grids[2] = {&a, &b};
+        for (int k = 0; k < 2; ++k) {
+            Grid &g = *grids[k];
+            base_[k] = g.cells.data();
+            for (int d = 0; d < 8; ++d) {
+                if (local(d)) {
+                    reqs_[k][d] = reqs_[k][8 + d] = empty_[k][d] = MPI_REQUEST_NULL;
+                    continue;
+                }
+                Region gr = ghostRegion(g.rows, g.cols, g.halo, d);
+                Region sr = sendRegion(g.rows, g.cols, g.halo, d);
+                MPI_Recv_init(g.at(gr.r0, gr.c0), 1, types_[d], tile.neighbors[d], 7 - d, tile.comm, &reqs_[k][d]);
+                MPI_Send_init(g.at(sr.r0, sr.c0), 1, types_[d], tile.neighbors[d], d, tile.comm, &reqs_[k][8 + d]);
+                MPI_Send_init(g.at(sr.r0, sr.c0), 0, types_[d], tile.neighbors[d], d, tile.comm, &empty_[k][d]);
+            }
+        }
+    }
+
+    ~HaloExchange() {
+        for (int k = 0; k < 2; ++k)
+            for (int i = 0; i < 16; ++i)
+                if (reqs_[k][i] != MPI_REQUEST_NULL)
+                    MPI_Request_free(&reqs_[k][i]);
+        for (int k = 0; k < 2; ++k)
+            for (int d = 0; d < 8; ++d)
+                if (empty_[k][d] != MPI_REQUEST_NULL)
+                    MPI_Request_free(&empty_[k][d]);
+        for (int d = 0; d < 8; ++d)
+            MPI_Type_free(&types_[d]);
+    }
+
+    HaloExchange(const HaloExchange &) = delete;
+    HaloExchange &operator=(const HaloExchange &) = delete;
+
+    /// Number of neighbor directions served through shared memory
+    int sharedNeighbors() const { return shm_ ? shm_->localCount() : 0; }
+
+    /**
+     * @brief Posts the receives and sends of the ghost frame of grid
+     * @param grid The grid whose active cells are current
+     */
+    void start(Grid &grid) {
+        const bool all[8] = {true, true, true, true, true, true, true, true};
+        startSparse(grid, all);
+    }
+
+    /**
+     * @brief Waits until the ghost frame of grid is filled
+     * @param grid The grid passed to start()
+     */
+    void finish(Grid &grid) {
+        bool received[8];
+        finishSparse(grid, received);
+    }
+
+    /// Blocking exchange: start() followed by finish()
+    void exchange(Grid &grid) { start(grid); finish(grid); }
+
+    /**
+     * @brief Like start(), but unchanged edges go as empty messages
+     * @param grid The grid whose active cells are current
+     * @param changed Whether the edge sent in each direction changed since this grid was last exchanged
+     */
+    void startSparse(Grid &grid, const bool changed[8]) {
+        active_ = (grid.cells.data() == base_[0]) ? 0 : 1;
+        started_ = 0;
+        for (int d = 0; d < 8; ++d)
+            if (!local(d))
+                sparse_[started_++] = reqs_[active_][d];
+        for (int d = 0; d < 8; ++d)
+            if (!local(d))
+                sparse_[started_++] = changed[d] ? reqs_[active_][8 + d] : empty_[active_][d];
+        if (shm_) {
+            shm_->begin();
+            for (int d = 0; d < 8; ++d)
+                if (local(d)) {
+                    void *box = shm_->send(d, active_);
+                    if (changed[d])
+                        pack(grid, sendRegion(grid.rows, grid.cols, grid.halo, d), static_cast<int *>(box));
+                    shm_->post(d, active_, changed[d]);
+                }
+        }
+        MPI_Startall(started_, sparse_);
+    }
+
+    /**
+     * @brief Waits for the halos of startSparse()
+     *
+     * An empty message leaves the ghost cells of grid as they were, which is
+     * what this grid received two exchanges ago.
+     * @param grid The grid passed to startSparse()
+     * @param received Set to whether each ghost region came with cells
+     */
+    void finishSparse(Grid &grid, bool received[8]) {
+        MPI_Status statuses[16];
+        MPI_Waitall(started_, sparse_, statuses);
+        for (int d = 0, i = 0; d < 8; ++d) {
+            if (local(d)) {
+                const void *box = shm_->receive(d, active_, received[d]);
+                if (received[d])
+                    unpack(grid, ghostRegion(grid.rows, grid.cols, grid.halo, d), static_cast<const int *>(box));
+                shm_->release(d);
+                continue;
+            }
+            int count;
+            MPI_Get_count(&statuses[i++], types_[d], &count);
+            received[d] = count > 0;
+        }
+    }
+
+private:
+    bool local(int d) const { return shm_ && shm_->local(d); }
+
+    static void pack(const Grid &grid, const Region &r, int *buf) {
+        for (int k = 0; k < r.nr; ++k)
+            std::memcpy(buf + static_cast<size_t>(k) * r.nc, grid.at(r.r0 + k, r.c0), r.nc * sizeof(int));
+    }
+
+    static void unpack(Grid &grid, const Region &r, const int *buf) {
+        for (int k = 0; k < r.nr; ++k)
+            std::memcpy(grid.at(r.r0 + k, r.c0), buf + static_cast<size_t>(k) * r.nc, r.nc * sizeof(int));
+    }
+
+    MPI_Datatype types_[8];
+    const int *base_[2];       ///< Cell buffer each request set points into
+    MPI_Request reqs_[2][16];  ///< Receives [0, 8) and sends [8, 16) per buffer
+    MPI_Request empty_[2][8];  ///< Empty sends of unchanged edges, per buffer
+    MPI_Request sparse_[16];   ///< Requests started: receives, then sends
+    int started_ = 0;
+    int active_ = 0;
+    std::unique_ptr<ShmMailboxes> shm_;
+};
+
+/**
+ * @brief Bit backend: halos travel as dense bit streams
+ *
+ * A region of nr x nc cells is packed into ceil(nr * nc / 64) words, so a
+ * one-cell-wide column halo costs one bit per row instead of one int.
+ */
+template <>
+class HaloExchange<BitGrid> {
+public:
+    /**
+     * @brief Allocates the packing buffers and their persistent requests
+     * @param tile Local tile
+     * @param a Current grid
+     * @param b Next grid (same shape)
+     * @param shm Trade edges with neighbors on the same node through shared memory
+     */
+    HaloExchange(const Tile &tile, BitGrid &a, BitGrid &b, bool shm = false) {
+        base_[0] = a.cells.data();
+        base_[1] = b.cells.data();
+        size_t bytes[8];
+        for (int d = 0; d < 8; ++d) {
+            Region r = ghostRegion(a.rows, a.cols, a.halo, d);
+            bytes[d] = ((static_cast<size_t>(r.nr) * r.nc + 63) / 64 + 1) * sizeof(uint64_t);
+        }
+        if (shm)
+            shm_.reset(new ShmMailboxes(tile, bytes));
+        for (int d = 0; d < 8; ++d) {
+            if (local(d)) {
+                reqs_[d] = reqs_[8 + d] = empty_[d] = held_reqs_[0][d] = held_reqs_[1][d] = MPI_REQUEST_NULL;
+                continue;
+            }
+            Region r = ghostRegion(a.rows, a.cols, a.halo, d);
+            size_t words = (static_cast<size_t>(r.nr) * r.nc + 63) / 64;
+            send_[d].assign(words + 1, 0);
+            recv_[d].assign(words + 1, 0);
+            MPI_Recv_init(recv_[d].data(), static_cast<int>(words), MPI_UINT64_T, tile.neighbors[d], 7 - d, tile.comm, &reqs_[d]);
+            MPI_Send_init(send_[d].data(), static_cast<int>(words), MPI_UINT64_T, tile.neighbors[d], d, tile.comm, &reqs_[8 + d]);
+            MPI_Send_init(send_[d].data(), 0, MPI_UINT64_T, tile.neighbors[d], d, tile.comm, &empty_[d]);
+            for (int k = 0; k < 2; ++k) {
+                held_[k][d].assign(words + 1, 0);
+                MPI_Recv_init(held_[k][d].data(), static_cast<int>(words), MPI_UINT64_T, tile.neighbors[d], 7 - d,
+                              tile.comm, &held_reqs_[k][d]);
+            }
+        }
+    }
+
+    ~HaloExchange() {
+        for (int d = 0; d < 8; ++d) {
+            if (local(d))
+                continue;
+            MPI_Request_free(&reqs_[d]);
+            MPI_Request_free(&reqs_[8 + d]);
+            MPI_Request_free(&empty_[d]);
+            MPI_Request_free(&held_reqs_[0][d]);
+            MPI_Request_free(&held_reqs_[1][d]);
+        }
+    }
+
+    HaloExchange(const HaloExchange &) = delete;
+    HaloExchange &operator=(const HaloExchange &) = delete;
+
+    /// Number of neighbor directions served through shared memory
+    int sharedNeighbors() const { return shm_ ? shm_->localCount() : 0; }
+
+    /**
+     * @brief Packs the edges of grid and posts the receives and sends
+     * @param grid The grid whose active cells are current
+     */
+    void start(BitGrid &grid) {
+        active_ = (grid.cells.data() == base_[0]) ? 0 : 1;
+        started_ = 0;
+        for (int d = 0; d < 8; ++d)
+            if (!local(d))
+                sparse_[started_++] = reqs_[d];
+        for (int d = 0; d < 8; ++d)
+            if (!local(d)) {
+                pack(grid, sendRegion(grid.rows, grid.cols, grid.halo, d), send_[d].data());
+                sparse_[started_++] = reqs_[8 + d];
+            }
+        postShared(grid, nullptr);
+        MPI_Startall(started_, sparse_);
+    }
+
+    /**
+     * @brief Waits for the halos and unpacks them into the ghost frame
+     * @param grid The grid passed to start()
+     */
+    void finish(BitGrid &grid) {
+        MPI_Waitall(started_, sparse_, MPI_STATUSES_IGNORE);
+        for (int d = 0; d < 8; ++d) {
+            bool changed;
+            const uint64_t *buf = local(d) ? receiveShared(d, changed) : recv_[d].data();
+            unpack(grid, ghostRegion(grid.rows, grid.cols, grid.halo, d), buf);
+            if (local(d))
+                shm_->release(d);
+        }
+    }
+
+    /// Blocking exchange: start() followed by finish()
+    void exchange(BitGrid &grid) { start(grid); finish(grid); }
+
+    /**
+     * @brief Like start(), but unchanged edges are neither packed nor sent
+     * @param grid The grid whose active cells are current
+     * @param changed Whether the edge sent in each direction changed since this grid was last exchanged
+     */
+    void startSparse(BitGrid &grid, const bool changed[8]) {
+        active_ = (grid.cells.data() == base_[0]) ? 0 : 1;
+        started_ = 0;
+        for (int d = 0; d < 8; ++d)
+            if (!local(d))
+                sparse_[started_++] = held_reqs_[active_][d];
+        for (int d = 0; d < 8; ++d)
+            if (!local(d)) {
+                sparse_[started_++] = changed[d] ? reqs_[8 + d] : empty_[d];
+                if (changed[d])
+                    pack(grid, sendRegion(grid.rows, grid.cols, grid.halo, d), send_[d].data());
+            }
+        postShared(grid, changed);
+        MPI_Startall(started_, sparse_);
+    }
+
+    /**
+     * @brief Waits for the halos of startSparse() and unpacks them into the ghost frame
+     *
+     * Ghost columns share words with active cells and are overwritten by the
+     * kernel, so every region is unpacked again from the last cells received
+     * for this grid; an empty message keeps them. A mailbox in shared memory
+     * is only rewritten when its edge changed, so it plays the same role.
+     * @param grid The grid passed to startSparse()
+     * @param received Set to whether each ghost region came with cells
+     */
+    void finishSparse(BitGrid &grid, bool received[8]) {
+        MPI_Status statuses[16];
+        MPI_Waitall(started_, sparse_, statuses);
+        for (int d = 0, i = 0; d < 8; ++d) {
+            const uint64_t *buf;
+            if (local(d)) {
+                buf = receiveShared(d, received[d]);
+            } else {
+                int count;
+                MPI_Get_count(&statuses[i++], MPI_UINT64_T, &count);
+                received[d] = count > 0;
+                buf = held_[active_][d].data();
+            }
+            unpack(grid, ghostRegion(grid.rows, grid.cols, grid.halo, d), buf);
+            if (local(d))
+                shm_->release(d);
+        }
+    }
+
+private:
+    bool local(int d) const { return shm_ && shm_->local(d); }
+
+    /// Packs the changed edges for the neighbors on this node (all of them if changed is null)
+    void postShared(const BitGrid &grid, const bool *changed) {
+        if (!shm_)
+            return;
+        shm_->begin();
+        for (int d = 0; d < 8; ++d)
+            if (local(d)) {
+                bool rewrite = !changed || changed[d];
+                void *box = shm_->send(d, active_);
+                if (rewrite)
+                    pack(grid, sendRegion(grid.rows, grid.cols, grid.halo, d), static_cast<uint64_t *>(box));
+                shm_->post(d, active_, rewrite);
+            }
+    }
+
+    const uint64_t *receiveShared(int d, bool &changed) const {
+        return static_cast<const uint64_t *>(shm_->receive(d, active_, changed));
+    }
+
+    static void pack(const BitGrid &grid, const Region &r, uint64_t *buf) {
+        for (int k = 0; k < r.nr; ++k)
+            copyBits(buf, static_cast<size_t>(k) * r.nc, grid.row(r.r0 + k), 64 + r.c0, r.nc);
+    }
+
+    static void unpack(BitGrid &grid, const Region &r, const uint64_t *buf) {
+        for (int k = 0; k < r.nr; ++k)
+            copyBits(grid.row(r.r0 + k), 64 + r.c0, buf, static_cast<size_t>(k) * r.nc, r.nc);
+    }
+
+    std::vector<uint64_t> send_[8], recv_[8];
+    std::vector<uint64_t> held_[2][8];  ///< Last cells received by startSparse(), per grid
+    const uint64_t *base_[2];           ///< Cell buffer of each grid
+    MPI_Request reqs_[16];              ///< Receives [0, 8) and sends [8, 16)
+    MPI_Request empty_[8];              ///< Empty sends of unchanged edges
+    MPI_Request held_reqs_[2][8];       ///< Receives into held_
+    MPI_Request sparse_[16];            ///< Requests started: receives, then sends
+    int started_ = 0;
+    int active_ = 0;
+    std::unique_ptr<ShmMailboxes> shm_;
+};
+
+#endif
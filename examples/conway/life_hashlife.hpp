@@ -0,0 +1,628 @@
+/**
+ * @file life_hashlife.hpp
+ * @brief Distributed HashLife engine for mpi_life
+ *
+ * The board is a quadtree of hash-consed nodes: a node of level l covers
+ * 2^l x 2^l cells and is identified by its four children, so equal regions
+ * anywhere on the board, and at any generation, are the same node. The
+ * result of a node (its central 2^(l-1) x 2^(l-1) cells 2^k generations
+ * later) is memoized in the node, which lets periodic and sparse boards jump
+ * 2^k generations at a time.
+ *
+ * The node table is split across the processes by the hash of the children:
+ * the owner of a node stores it, interns it, and computes and memoizes its
+ * result. Every operation works on a batch and is collective: requests travel
+ * to their owners with one MPI_Alltoallv and the answers come back with
+ * another, one tree level at a time. Nodes of up to BASE_LEVEL (64 x 64
+ * cells) are stepped directly with the bit-sliced kernel of
+ * life_bitpacked.hpp.
+ *
+ * The torus is the periodic tiling of the board: the result of a node made of
+ * four copies of the root is the board itself, shifted by half a side. Boards
+ * must be 2^a x 2^b with a, b >= 3; the shorter side is repeated to make the
+ * square root.
+ *
+ * Each process caps its part of the table. Between jumps, when a process is
+ * over the cap, the nodes not reachable from the board are collected and
+ * every memoized result is dropped.
+ */
+
+#ifndef LIFE_HASHLIFE_HPP
+#define LIFE_HASHLIFE_HPP
+
+#include <mpi.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "life_bitpacked.hpp"
+#include "life_decomp.hpp"
+
+/// Node identifier: owner rank and table index, or the cells of a 4 x 4 leaf
+typedef uint64_t NodeId;
+
+/**
+ * @brief Board of one run, stored as a quadtree spread over the processes
+ */
+class HashLife {
+public:
+    static constexpr int BASE_LEVEL = 6;  ///< Nodes up to 64 x 64 cells are stepped cell by cell
+
+    /**
+     * @brief Creates an empty board (collective)
+     * @param tile Local tile; the board must be 2^a x 2^b with a, b >= 3
+     * @param max_bytes Memory cap of the local part of the node table
+     */
+    HashLife(const Tile &tile, size_t max_bytes)
+        : tile_(tile), max_nodes_(max_bytes / (sizeof(Node) + 2 * sizeof(uint32_t))), slots_(1024, 0) {
+        while ((1 << level_) < std::max(tile.rows, tile.cols))
+            ++level_;
+        empty_.assign(level_ + 2, leaf(0));
+        for (int l = 3; l <= level_ + 1; ++l)
+            empty_[l] = share(join(lead({empty_[l - 1], empty_[l - 1], empty_[l - 1], empty_[l - 1]})));
+        root_ = empty_[level_];
+    }
+
+    /// Level of the root: the board is repeated over 2^level x 2^level cells
+    int level() const { return level_; }
+
+    /**
+     * @brief Builds the board from the active cells of every tile (collective)
+     *
+     * Live cells go to the owner of their 64 x 64 block, which builds the
+     * block; the levels above are built by all processes together.
+     * @param grid Local grid of the tile (ghost frame ignored)
+     */
+    template <typename G>
+    void load(const G &grid) {
+        const int side = 1 << level_, h = grid.halo;
+        const int block_level = std::min(level_, BASE_LEVEL), bs = 1 << block_level;
+        int nb = side / bs;
+
+        std::vector<int> dest;
+        std::vector<uint64_t> cells;
+        for (int i = 0; i < tile_.local_rows; ++i)
+            for (int j = 0; j < tile_.local_cols; ++j)
+                if (grid.get(h + i, h + j))
+                    for (int y = tile_.row0 + i; y < side; y += tile_.rows)
+                        for (int x = tile_.col0 + j; x < side; x += tile_.cols) {
+                            dest.push_back(((y / bs) * nb + x / bs) % tile_.size);
+                            cells.push_back(static_cast<uint64_t>(y) << 32 | static_cast<uint32_t>(x));
+                        }
+        Routed r = route(dest, cells, 1);
+
+        // This process owns blocks rank, rank + size, ...
+        const size_t mine = stripe(nb * nb, tile_.rank);
+        std::vector<uint64_t> rows(mine * bs, 0);
+        for (uint64_t c : r.items) {
+            int y = static_cast<int>(c >> 32), x = static_cast<int>(c & 0xffffffffu);
+            size_t k = ((y / bs) * nb + x / bs) / tile_.size;
+            rows[k * bs + y % bs] |= 1ULL << (x % bs);
+        }
+        std::vector<NodeId> nodes = gather(build(rows, mine, block_level), nb * nb);
+
+        for (int l = block_level + 1; l <= level_; ++l) {
+            nb /= 2;
+            std::vector<NodeId> quads;
+            for (int p = tile_.rank; p < nb * nb; p += tile_.size) {
+                int base = 2 * (p / nb) * 2 * nb + 2 * (p % nb);
+                quads.insert(quads.end(), {nodes[base], nodes[base + 1], nodes[base + 2 * nb], nodes[base + 2 * nb + 1]});
+            }
+            nodes = gather(join(quads), nb * nb);
+        }
+        root_ = nodes[0];
+    }
+
+    /**
+     * @brief Advances the board 2^k generations (collective)
+     * @param k Log2 of the jump, at most level() - 1
+     */
+    void step(int k) {
+        NodeId torus = share(join(lead({root_, root_, root_, root_})));
+        std::vector<NodeId> quads = children(advance(lead({torus}), level_ + 1, k));
+        if (tile_.rank == 0)
+            quads = {quads[3], quads[2], quads[1], quads[0]};
+        root_ = share(join(quads));
+    }
+
+    /**
+     * @brief Writes the cells of the tile into a grid (collective)
+     *
+     * Only the nodes that overlap the tile and are not empty are visited.
+     * @param grid Local grid of the tile (ghost frame untouched)
+     */
+    template <typename G>
+    void store(G &grid) const {
+        const int h = grid.halo;
+        const int r0 = tile_.row0, r1 = r0 + tile_.local_rows, c0 = tile_.col0, c1 = c0 + tile_.local_cols;
+        for (int i = 0; i < tile_.local_rows; ++i)
+            for (int j = 0; j < tile_.local_cols; ++j)
+                grid.set(h + i, h + j, 0);
+
+        struct Item { NodeId id; int y, x; };
+        std::vector<Item> items{{root_, 0, 0}}, next;
+        for (int l = level_; l > 2; --l) {
+            std::vector<NodeId> ids;
+            for (const Item &it : items)
+                ids.push_back(it.id);
+            std::vector<NodeId> kids = children(ids);
+            const int half = 1 << (l - 1);
+            next.clear();
+            for (size_t i = 0; i < items.size(); ++i)
+                for (int c = 0; c < 4; ++c) {
+                    Item k{kids[4 * i + c], items[i].y + (c >> 1) * half, items[i].x + (c & 1) * half};
+                    if (k.id != empty_[l - 1] && k.y < r1 && k.y + half > r0 && k.x < c1 && k.x + half > c0)
+                        next.push_back(k);
+                }
+            items.swap(next);
+        }
+        for (const Item &it : items)
+            for (int a = 0; a < 4; ++a)
+                for (int b = 0; b < 4; ++b) {
+                    int y = it.y + a, x = it.x + b;
+                    if ((it.id >> (4 * a + b)) & 1 && y >= r0 && y < r1 && x >= c0 && x < c1)
+                        grid.set(h + y - r0, h + x - c0, 1);
+                }
+    }
+
+    /// Whether any process holds more nodes than its cap (collective)
+    bool overCapacity() const {
+        int over = live_ > max_nodes_, any;
+        MPI_Allreduce(&over, &any, 1, MPI_INT, MPI_MAX, tile_.comm);
+        return any != 0;
+    }
+
+    /**
+     * @brief Frees the nodes not reachable from the board and drops all memoized results (collective)
+     *
+     * Marking follows the children level by level, each batch routed to the
+     * owners of the nodes.
+     */
+    void collect() {
+        for (Node &n : nodes_)
+            n.mark = false;
+        std::vector<NodeId> frontier = lead({root_});
+        if (tile_.rank == 0)
+            frontier.insert(frontier.end(), empty_.begin() + 3, empty_.end());
+        for (;;) {
+            long count = static_cast<long>(frontier.size()), total;
+            MPI_Allreduce(&count, &total, 1, MPI_LONG, MPI_SUM, tile_.comm);
+            if (total == 0)
+                break;
+            Routed r = route(owners(frontier), frontier, 1);
+            frontier.clear();
+            for (NodeId id : r.items) {
+                Node &n = nodes_[index(id)];
+                if (n.mark)
+                    continue;
+                n.mark = true;
+                for (NodeId c : n.child)
+                    if (!isLeaf(c))
+                        frontier.push_back(c);
+            }
+        }
+
+        for (uint32_t i = 0; i < nodes_.size(); ++i) {
+            Node &n = nodes_[i];
+            if (n.child[0] == 0)
+                continue;
+            n.step = NO_RESULT;
+            if (!n.mark) {
+                n.child[0] = 0;
+                free_.push_back(i);
+                --live_;
+            }
+        }
+        rehash(slots_.size());
+        ++collections_;
+    }
+
+    size_t nodes() const { return live_; }          ///< Nodes stored by this process
+    size_t capacity() const { return max_nodes_; }  ///< Node cap of this process
+    long memoHits() const { return hits_; }         ///< Results answered from the memo
+    long memoMisses() const { return misses_; }     ///< Results computed
+    long collections() const { return collections_; }
+
+private:
+    /// Table entry; the owner keeps the children and the memoized result
+    struct Node {
+        NodeId child[4];  ///< nw, ne, sw, se (child[0] == 0 marks a free entry)
+        NodeId result;    ///< Central cells 2^step generations later
+        int8_t step;      ///< Step of result, NO_RESULT or PENDING
+        bool mark;        ///< Reachable from the board (collect())
+    };
+    static constexpr int8_t NO_RESULT = -1;
+    static constexpr int8_t PENDING = -2;
+    static constexpr NodeId LEAF = 1ULL << 63;
+
+    /// Requests sent to their owners by route(), and how to send the answers back
+    struct Routed {
+        std::vector<int> sent, received;  ///< Requests per rank, each way
+        std::vector<int> slot;            ///< Position of every request in rank order
+        std::vector<uint64_t> items;      ///< Requests received, grouped by source
+    };
+
+    static NodeId leaf(uint64_t bits) { return LEAF | bits; }
+    static bool isLeaf(NodeId id) { return (id & LEAF) != 0; }
+    static int owner(NodeId id) { return static_cast<int>(id >> 40); }
+    static uint32_t index(NodeId id) { return static_cast<uint32_t>((id & ((1ULL << 40) - 1)) - 1); }
+    NodeId makeId(uint32_t i) const { return static_cast<NodeId>(tile_.rank) << 40 | (i + 1); }
+
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        return x ^ (x >> 33);
+    }
+    static uint64_t hashKey(const NodeId *k) { return mix(k[0] ^ mix(k[1] ^ mix(k[2] ^ mix(k[3])))); }
+
+    /// Items contributed by rank 0 only, for operations on shared nodes
+    std::vector<NodeId> lead(std::vector<NodeId> ids) const {
+        if (tile_.rank != 0)
+            ids.clear();
+        return ids;
+    }
+    /// Broadcasts the first id of rank 0
+    NodeId share(const std::vector<NodeId> &ids) const {
+        NodeId id = tile_.rank == 0 ? ids[0] : 0;
+        MPI_Bcast(&id, 1, MPI_UINT64_T, 0, tile_.comm);
+        return id;
+    }
+    /// Items of [0, total) that fall on rank r when dealt round robin
+    size_t stripe(int total, int r) const { return static_cast<size_t>((total - r + tile_.size - 1) / tile_.size); }
+
+    /// Collects on every process the items dealt round robin (item p on rank p % size)
+    std::vector<NodeId> gather(const std::vector<NodeId> &mine, int total) const {
+        std::vector<int> counts(tile_.size), displs(tile_.size);
+        for (int r = 0, offset = 0; r < tile_.size; offset += counts[r++]) {
+            counts[r] = static_cast<int>(stripe(total, r));
+            displs[r] = offset;
+        }
+        std::vector<NodeId> all(total), out(total);
+        MPI_Allgatherv(mine.data(), static_cast<int>(mine.size()), MPI_UINT64_T,
+                       all.data(), counts.data(), displs.data(), MPI_UINT64_T, tile_.comm);
+        for (int r = 0; r < tile_.size; ++r)
+            for (int k = 0; k < counts[r]; ++k)
+                out[r + static_cast<size_t>(k) * tile_.size] = all[displs[r] + k];
+        return out;
+    }
+
+    std::vector<int> owners(const std::vector<NodeId> &ids) const {
+        std::vector<int> dest(ids.size());
+        for (size_t i = 0; i < ids.size(); ++i)
+            dest[i] = owner(ids[i]);
+        return dest;
+    }
+
+    /// One MPI_Alltoallv of w words per item
+    void exchange(const std::vector<uint64_t> &out, const std::vector<int> &out_items,
+                  std::vector<uint64_t> &in, const std::vector<int> &in_items, int w) const {
+        const int p = tile_.size;
+        std::vector<int> sc(p), sd(p, 0), rc(p), rd(p, 0);
+        for (int r = 0; r < p; ++r) {
+            sc[r] = out_items[r] * w;
+            rc[r] = in_items[r] * w;
+        }
+        for (int r = 1; r < p; ++r) {
+            sd[r] = sd[r - 1] + sc[r - 1];
+            rd[r] = rd[r - 1] + rc[r - 1];
+        }
+        in.resize(static_cast<size_t>(rd[p - 1]) + rc[p - 1]);
+        MPI_Alltoallv(out.data(), sc.data(), sd.data(), MPI_UINT64_T, in.data(), rc.data(), rd.data(),
+                      MPI_UINT64_T, tile_.comm);
+    }
+
+    /**
+     * @brief Sends requests of w words to their ranks
+     * @param dest Rank of every request
+     * @param req Requests, w words each
+     * @param w Words per request
+     */
+    Routed route(const std::vector<int> &dest, const std::vector<uint64_t> &req, int w) const {
+        Routed r;
+        r.sent.assign(tile_.size, 0);
+        r.received.assign(tile_.size, 0);
+        r.slot.resize(dest.size());
+        for (int d : dest)
+            ++r.sent[d];
+        std::vector<int> next(tile_.size, 0);
+        for (int q = 1; q < tile_.size; ++q)
+            next[q] = next[q - 1] + r.sent[q - 1];
+        std::vector<uint64_t> buf(req.size());
+        for (size_t i = 0; i < dest.size(); ++i) {
+            r.slot[i] = next[dest[i]]++;
+            std::copy_n(&req[i * w], w, &buf[static_cast<size_t>(r.slot[i]) * w]);
+        }
+        MPI_Alltoall(r.sent.data(), 1, MPI_INT, r.received.data(), 1, MPI_INT, tile_.comm);
+        exchange(buf, r.sent, r.items, r.received, w);
+        return r;
+    }
+
+    /**
+     * @brief Returns w words per received request to its source
+     * @param r Routed requests
+     * @param ans Answers in the order of r.items
+     * @param w Words per answer
+     * @return Answers in the order the requests were made
+     */
+    std::vector<uint64_t> answer(const Routed &r, const std::vector<uint64_t> &ans, int w) const {
+        std::vector<uint64_t> buf, out(r.slot.size() * w);
+        exchange(ans, r.received, buf, r.sent, w);
+        for (size_t i = 0; i < r.slot.size(); ++i)
+            std::copy_n(&buf[static_cast<size_t>(r.slot[i]) * w], w, &out[i * w]);
+        return out;
+    }
+
+    /// Finds or inserts the local node with these children
+    NodeId intern(const NodeId *key) {
+        if ((live_ + 1) * 2 > slots_.size())
+            rehash(slots_.size() * 2);
+        const size_t mask = slots_.size() - 1;
+        for (size_t i = (hashKey(key) >> 24) & mask;; i = (i + 1) & mask) {
+            if (slots_[i] == 0) {
+                uint32_t idx;
+                if (!free_.empty()) {
+                    idx = free_.back();
+                    free_.pop_back();
+                } else {
+                    idx = static_cast<uint32_t>(nodes_.size());
+                    nodes_.emplace_back();
+                }
+                Node &n = nodes_[idx];
+                std::copy_n(key, 4, n.child);
+                n.result = 0;
+                n.step = NO_RESULT;
+                n.mark = false;
+                slots_[i] = idx + 1;
+                ++live_;
+                return makeId(idx);
+            }
+            if (std::equal(key, key + 4, nodes_[slots_[i] - 1].child))
+                return makeId(slots_[i] - 1);
+        }
+    }
+
+    /// Rebuilds the open-addressing index over the live nodes
+    void rehash(size_t size) {
+        slots_.assign(size, 0);
+        const size_t mask = size - 1;
+        for (uint32_t idx = 0; idx < nodes_.size(); ++idx) {
+            if (nodes_[idx].child[0] == 0)
+                continue;
+            size_t i = (hashKey(nodes_[idx].child) >> 24) & mask;
+            while (slots_[i])
+                i = (i + 1) & mask;
+            slots_[i] = idx + 1;
+        }
+    }
+
+    /// Interns the nodes with the given children, four per node (collective)
+    std::vector<NodeId> join(const std::vector<NodeId> &quads) {
+        std::vector<int> dest(quads.size() / 4);
+        for (size_t i = 0; i < dest.size(); ++i)
+            dest[i] = static_cast<int>(hashKey(&quads[4 * i]) % tile_.size);
+        Routed r = route(dest, quads, 4);
+        std::vector<uint64_t> ids(r.items.size() / 4);
+        for (size_t k = 0; k < ids.size(); ++k)
+            ids[k] = intern(&r.items[4 * k]);
+        return answer(r, ids, 1);
+    }
+
+    /// Children of interior nodes, four per node (collective)
+    std::vector<NodeId> children(const std::vector<NodeId> &ids) const {
+        Routed r = route(owners(ids), ids, 1);
+        std::vector<uint64_t> kids(r.items.size() * 4);
+        for (size_t k = 0; k < r.items.size(); ++k)
+            std::copy_n(nodes_[index(r.items[k])].child, 4, &kids[4 * k]);
+        return answer(r, kids, 4);
+    }
+
+    /**
+     * @brief Cells of nodes of up to 64 x 64 cells, one word per row (collective)
+     * @param ids Nodes
+     * @param level Level of the nodes
+     * @return 2^level rows per node, bit x for column x
+     */
+    std::vector<uint64_t> expand(const std::vector<NodeId> &ids, int level) const {
+        const int side = 1 << level;
+        struct Item { NodeId id; size_t row; int x; };
+        std::vector<Item> items, inner;
+        for (size_t i = 0; i < ids.size(); ++i)
+            items.push_back({ids[i], i * side, 0});
+        for (int l = level; l > 2; --l) {
+            std::vector<NodeId> asked;
+            inner.clear();
+            for (const Item &it : items)
+                if (it.id != empty_[l]) {
+                    inner.push_back(it);
+                    asked.push_back(it.id);
+                }
+            std::vector<NodeId> kids = children(asked);
+            const int half = 1 << (l - 1);
+            items.clear();
+            for (size_t i = 0; i < inner.size(); ++i)
+                for (int c = 0; c < 4; ++c)
+                    items.push_back({kids[4 * i + c], inner[i].row + (c >> 1) * half, inner[i].x + (c & 1) * half});
+        }
+        std::vector<uint64_t> rows(ids.size() * side, 0);
+        for (const Item &it : items)
+            for (int i = 0; i < 4; ++i)
+                rows[it.row + i] |= ((it.id >> (4 * i)) & 0xF) << it.x;
+        return rows;
+    }
+
+    /**
+     * @brief Interns squares of up to 64 x 64 cells given one word per row (collective)
+     * @param rows 2^level rows per square, bit x for column x
+     * @param count Number of squares
+     * @param level Level of the squares (2 to BASE_LEVEL)
+     * @return One node per square
+     */
+    std::vector<NodeId> build(const std::vector<uint64_t> &rows, size_t count, int level) {
+        const int side = 1 << level;
+        int n = side / 4;
+        std::vector<NodeId> ids(count * n * n);
+        for (size_t k = 0; k < count; ++k)
+            for (int by = 0; by < n; ++by)
+                for (int bx = 0; bx < n; ++bx) {
+                    uint64_t bits = 0;
+                    for (int i = 0; i < 4; ++i)
+                        bits |= ((rows[k * side + by * 4 + i] >> (bx * 4)) & 0xF) << (4 * i);
+                    ids[(k * n + by) * n + bx] = leaf(bits);
+                }
+        for (int l = 3; l <= level; ++l, n /= 2) {
+            const int m = n / 2;
+            std::vector<NodeId> quads;
+            quads.reserve(count * m * m * 4);
+            for (size_t k = 0; k < count; ++k)
+                for (int y = 0; y < m; ++y)
+                    for (int x = 0; x < m; ++x) {
+                        size_t base = (k * n + 2 * y) * n + 2 * x;
+                        quads.insert(quads.end(), {ids[base], ids[base + 1], ids[base + n], ids[base + n + 1]});
+                    }
+            ids = join(quads);
+        }
+        return ids;
+    }
+
+    /**
+     * @brief Memoized results of nodes of one level (collective)
+     *
+     * Each node is answered by its owner: from the memo, or computed once
+     * for all the processes asking for it.
+     * @param ids Nodes
+     * @param level Level of the nodes
+     * @param step Log2 of the generations (capped at level - 2)
+     * @return Central 2^(level-1) x 2^(level-1) cells of every node, 2^step generations later
+     */
+    std::vector<NodeId> advance(const std::vector<NodeId> &ids, int level, int step) {
+        step = std::min(step, level - 2);
+
+        // Empty space stays empty without asking
+        std::vector<NodeId> out(ids.size()), asked;
+        std::vector<int> dest;
+        std::vector<size_t> where;
+        for (size_t i = 0; i < ids.size(); ++i) {
+            if (ids[i] == empty_[level]) {
+                out[i] = empty_[level - 1];
+            } else {
+                asked.push_back(ids[i]);
+                dest.push_back(owner(ids[i]));
+                where.push_back(i);
+            }
+        }
+        Routed r = route(dest, asked, 1);
+
+        std::vector<uint32_t> todo;
+        for (NodeId id : r.items) {
+            Node &n = nodes_[index(id)];
+            if (n.step == step) {
+                ++hits_;
+            } else if (n.step != PENDING) {
+                n.step = PENDING;
+                todo.push_back(index(id));
+            }
+        }
+        misses_ += static_cast<long>(todo.size());
+
+        long pending = static_cast<long>(todo.size()), total;
+        MPI_Allreduce(&pending, &total, 1, MPI_LONG, MPI_SUM, tile_.comm);
+        if (total > 0) {
+            std::vector<NodeId> results = level <= BASE_LEVEL ? stepDirect(todo, level, step)
+                                                              : stepRecursive(todo, level, step);
+            for (size_t t = 0; t < todo.size(); ++t) {
+                nodes_[todo[t]].result = results[t];
+                nodes_[todo[t]].step = static_cast<int8_t>(step);
+            }
+        }
+
+        std::vector<uint64_t> ans(r.items.size());
+        for (size_t k = 0; k < ans.size(); ++k)
+            ans[k] = nodes_[index(r.items[k])].result;
+        std::vector<uint64_t> back = answer(r, ans, 1);
+        for (size_t j = 0; j < where.size(); ++j)
+            out[where[j]] = back[j];
+        return out;
+    }
+
+    /// Results of small local nodes, stepped generation by generation on one word per row
+    std::vector<NodeId> stepDirect(const std::vector<uint32_t> &todo, int level, int step) {
+        const int side = 1 << level, half = side / 2, quarter = side / 4, gens = 1 << step;
+        std::vector<NodeId> ids(todo.size());
+        for (size_t t = 0; t < todo.size(); ++t)
+            ids[t] = makeId(todo[t]);
+        std::vector<uint64_t> rows = expand(ids, level);
+
+        // Rows padded with a zero word on each side, as lifeWord reads them
+        std::vector<uint64_t> a(3 * side, 0), b(3 * side, 0), out(todo.size() * half);
+        for (size_t t = 0; t < todo.size(); ++t) {
+            for (int y = 0; y < side; ++y)
+                a[3 * y + 1] = rows[t * side + y];
+            // The cells that only depend on the node shrink by one per generation
+            for (int g = 1; g <= gens; ++g) {
+                for (int y = g; y < side - g; ++y)
+                    b[3 * y + 1] = lifeWord<uint64_t>(&a[3 * y - 2], &a[3 * y + 1], &a[3 * y + 4]);
+                a.swap(b);
+            }
+            for (int y = 0; y < half; ++y)
+                out[t * half + y] = (a[3 * (y + quarter) + 1] >> quarter) & ((1ULL << half) - 1);
+        }
+        return build(out, todo.size(), level - 1);
+    }
+
+    /**
+     * @brief Results of large local nodes from the results of their subnodes
+     *
+     * The nine overlapping subnodes are advanced first. A full step
+     * (2^(level-2) generations) advances the four nodes they form again; a
+     * smaller one takes their centers instead.
+     */
+    std::vector<NodeId> stepRecursive(const std::vector<uint32_t> &todo, int level, int step) {
+        const size_t n = todo.size();
+        std::vector<NodeId> kids(4 * n);
+        for (size_t t = 0; t < n; ++t)
+            std::copy_n(nodes_[todo[t]].child, 4, &kids[4 * t]);
+        std::vector<NodeId> grand = children(kids);
+        auto g = [&](size_t t, int y, int x) { return grand[16 * t + 4 * ((y / 2) * 2 + x / 2) + (y % 2) * 2 + x % 2]; };
+
+        std::vector<NodeId> quads;
+        quads.reserve(36 * n);
+        for (size_t t = 0; t < n; ++t)
+            for (int i = 0; i < 3; ++i)
+                for (int j = 0; j < 3; ++j)
+                    quads.insert(quads.end(), {g(t, i, j), g(t, i, j + 1), g(t, i + 1, j), g(t, i + 1, j + 1)});
+        std::vector<NodeId> nine = advance(join(quads), level - 1, step);
+        auto m = [&](size_t t, int i, int j) { return nine[9 * t + 3 * i + j]; };
+
+        quads.clear();
+        if (step == level - 2) {
+            for (size_t t = 0; t < n; ++t)
+                for (int a = 0; a < 2; ++a)
+                    for (int b = 0; b < 2; ++b)
+                        quads.insert(quads.end(), {m(t, a, b), m(t, a, b + 1), m(t, a + 1, b), m(t, a + 1, b + 1)});
+            return join(advance(join(quads), level - 1, step));
+        }
+
+        std::vector<NodeId> mk = children(nine);
+        auto c = [&](size_t t, int i, int j, int q) { return mk[36 * t + 4 * (3 * i + j) + q]; };
+        for (size_t t = 0; t < n; ++t)
+            for (int a = 0; a < 2; ++a)
+                for (int b = 0; b < 2; ++b)
+                    quads.insert(quads.end(), {c(t, a, b, 3), c(t, a, b + 1, 2), c(t, a + 1, b, 1), c(t, a + 1, b + 1, 0)});
+        return join(join(quads));
+    }
+
+    Tile tile_;
+    int level_ = 0;
+    size_t max_nodes_;
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> free_;   ///< Free entries of nodes_
+    std::vector<uint32_t> slots_;  ///< Hash index: entry + 1, or 0
+    size_t live_ = 0;
+    std::vector<NodeId> empty_;    ///< Empty node of every level
+    NodeId root_ = 0;
+    long hits_ = 0, misses_ = 0, collections_ = 0;
+};
+
+#endif
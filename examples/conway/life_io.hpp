@@ -0,0 +1,258 @@
+/**
+ * @file life_io.hpp
+ * @brief Parallel board input/output for mpi_life with MPI-IO
+ *
+ * Boards are written as binary PBM (P4) images: one bit per cell, 8 cells per
+ * byte, most significant bit first. Every process writes its own rectangle of
+ * the file in a single collective MPI_File_write_at_all through a subarray
+ * file view, so no board ever goes through rank 0. Checkpoints use the same
+ * raster behind a small binary header and are read back the same way, by
+ * any number of processes.
+ *
+ * A byte belongs to the process owning its first column. When a tile edge
+ * falls inside a byte, the missing columns (fewer than 8) are taken from the
+ * east neighbor with one small message.
+ */
+
+#ifndef LIFE_IO_HPP
+#define LIFE_IO_HPP
+
+#include <mpi.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "life_decomp.hpp"
+
+/**
+ * @brief Number of leading columns of a tile that belong to a byte started by its west neighbor
+ * @param col0 First global column of the tile
+ * @param ncols Columns of the tile
+ */
+inline int pbmLeadColumns(int col0, int ncols) {
+    return std::min((8 - col0 % 8) % 8, ncols);
+}
+
+/**
+ * @brief Checks that every tile can complete the bytes it owns with a single neighbor
+ * @param tile Any tile of the decomposition
+ * @return true if the narrowest tile is at least 8 columns wide (or spans the board)
+ */
+inline bool pbmTilesSupported(const Tile &tile) {
+    for (int j = 0; j < tile.dims[1]; ++j)
+        if (tile.dims[1] > 1 && tile.col_bounds[j + 1] - tile.col_bounds[j] < 8)
+            return false;
+    return true;
+}
+
+/**
+ * @brief Writes header followed by the board as a bit raster with one collective write
+ *
+ * The raster is the one of PBM P4: rows of ceil(cols / 8) bytes, cells most
+ * significant bit first.
+ * @param grid Local grid (ghost frame ignored)
+ * @param tile Local tile of the decomposition
+ * @param path Output file
+ * @param header Bytes written before the raster by rank 0
+ * @return false if the file could not be opened
+ */
+template <typename G>
+bool writeRaster(const G &grid, const Tile &tile, const std::string &path, const std::string &header) {
+    const int h = grid.halo;
+    const int lr = tile.local_rows, lc = tile.local_cols;
+    const int row_bytes = (tile.cols + 7) / 8;
+
+    // Leading columns go west, trailing columns come from the east
+    int lead = pbmLeadColumns(tile.col0, lc);
+    int east_col0 = tile.col0 + lc;
+    int trail = east_col0 < tile.cols ? (8 - east_col0 % 8) % 8 : 0;
+    std::vector<uint8_t> lead_cells(static_cast<size_t>(lr) * lead), trail_cells(static_cast<size_t>(lr) * trail);
+    for (int i = 0; i < lr; ++i)
+        for (int j = 0; j < lead; ++j)
+            lead_cells[static_cast<size_t>(i) * lead + j] = static_cast<uint8_t>(grid.get(h + i, h + j));
+    MPI_Sendrecv(lead_cells.data(), static_cast<int>(lead_cells.size()), MPI_BYTE, tile.neighbors[3], 0,
+                 trail_cells.data(), static_cast<int>(trail_cells.size()), MPI_BYTE, tile.neighbors[4], 0,
+                 tile.comm, MPI_STATUS_IGNORE);
+
+    // Bytes whose first column is in this tile
+    int b0 = (tile.col0 + 7) / 8;
+    int b1 = (east_col0 + 7) / 8;
+    int nbytes = b1 - b0;
+    std::vector<uint8_t> data(static_cast<size_t>(lr) * nbytes, 0);
+    for (int i = 0; i < lr; ++i)
+        for (int b = 0; b < nbytes; ++b) {
+            uint8_t byte = 0;
+            for (int k = 0; k < 8; ++k) {
+                int c = 8 * (b0 + b) + k;
+                int cell = 0;
+                if (c < east_col0)
+                    cell = grid.get(h + i, h + c - tile.col0);
+                else if (c < tile.cols)
+                    cell = trail_cells[static_cast<size_t>(i) * trail + (c - east_col0)];
+                byte |= static_cast<uint8_t>(cell << (7 - k));
+            }
+            data[static_cast<size_t>(i) * nbytes + b] = byte;
+        }
+
+    MPI_File fh;
+    if (MPI_File_open(tile.comm, path.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+        return false;
+    MPI_File_set_size(fh, 0);
+    if (tile.rank == 0)
+        MPI_File_write_at(fh, 0, header.data(), static_cast<int>(header.size()), MPI_BYTE, MPI_STATUS_IGNORE);
+
+    int sizes[2] = {tile.rows, row_bytes};
+    int subsizes[2] = {lr, nbytes};
+    int starts[2] = {tile.row0, b0};
+    MPI_Datatype view;
+    MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, MPI_BYTE, &view);
+    MPI_Type_commit(&view);
+    MPI_File_set_view(fh, static_cast<MPI_Offset>(header.size()), MPI_BYTE, view, "native", MPI_INFO_NULL);
+    MPI_File_write_at_all(fh, 0, data.data(), static_cast<int>(data.size()), MPI_BYTE, MPI_STATUS_IGNORE);
+    MPI_File_close(&fh);
+    MPI_Type_free(&view);
+    return true;
+}
+
+/**
+ * @brief Writes the board as a binary PBM file with one collective write
+ * @param grid Local grid (ghost frame ignored)
+ * @param tile Local tile of the decomposition
+ * @param path Output file
+ * @param comment Comment stored in the PBM header (may be empty)
+ * @return false if the file could not be opened
+ */
+template <typename G>
+bool writePBM(const G &grid, const Tile &tile, const std::string &path, const std::string &comment) {
+    std::string header = "P4\n";
+    if (!comment.empty())
+        header += "# " + comment + "\n";
+    header += std::to_string(tile.cols) + " " + std::to_string(tile.rows) + "\n";
+    return writeRaster(grid, tile, path, header);
+}
+
+/// Magic bytes that open a checkpoint
+const char CHECKPOINT_MAGIC[8] = {'L', 'I', 'F', 'E', 'C', 'K', 'P', '1'};
+
+/// Size of the checkpoint header: magic, then rows, columns and generation as uint64_t
+const int CHECKPOINT_HEADER = 32;
+
+/**
+ * @brief Writes a checkpoint: a 32-byte header and the PBM raster of the board
+ *
+ * The header holds the magic bytes and the rows, columns and generation as
+ * native uint64_t (little endian on x86 and ARM). The raster does not depend
+ * on the decomposition, so any number of processes can restart from it.
+ * @param grid Local grid (ghost frame ignored)
+ * @param tile Local tile of the decomposition
+ * @param path Output file
+ * @param generation Generation of the board
+ * @return false if the file could not be opened
+ */
+template <typename G>
+bool writeCheckpoint(const G &grid, const Tile &tile, const std::string &path, long generation) {
+    uint64_t fields[3] = {static_cast<uint64_t>(tile.rows), static_cast<uint64_t>(tile.cols),
+                          static_cast<uint64_t>(generation)};
+    std::string header(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header.append(reinterpret_cast<const char *>(fields), sizeof(fields));
+    return writeRaster(grid, tile, path, header);
+}
+
+/**
+ * @brief Reads the board size and generation of a checkpoint
+ * @param comm Processes that will restart (all get the result)
+ * @param path Checkpoint file
+ * @param rows Board rows
+ * @param cols Board columns
+ * @param generation Generation of the board
+ * @return false if the file cannot be read or is not a checkpoint
+ */
+inline bool readCheckpointHeader(MPI_Comm comm, const std::string &path, int &rows, int &cols, long &generation) {
+    MPI_File fh;
+    if (MPI_File_open(comm, path.c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+        return false;
+    char header[CHECKPOINT_HEADER] = {};
+    MPI_File_read_at_all(fh, 0, header, CHECKPOINT_HEADER, MPI_BYTE, MPI_STATUS_IGNORE);
+    MPI_File_close(&fh);
+
+    uint64_t fields[3];
+    std::memcpy(fields, header + sizeof(CHECKPOINT_MAGIC), sizeof(fields));
+    if (std::memcmp(header, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 || fields[0] == 0 ||
+        fields[1] == 0 || fields[0] > INT32_MAX || fields[1] > INT32_MAX)
+        return false;
+    rows = static_cast<int>(fields[0]);
+    cols = static_cast<int>(fields[1]);
+    generation = static_cast<long>(fields[2]);
+    return true;
+}
+
+/**
+ * @brief Cells of the local tile as a bit raster, laid out like the files
+ *
+ * Holds the initial board between runs. Row i keeps bytes
+ * [byte0, byte0 + nbytes) of board row row0 + i, so a tile reads its
+ * rectangle of a checkpoint without any message.
+ */
+struct LocalBoard {
+    int row0 = 0, col0 = 0;      ///< Global position of the first local cell
+    int rows = 0, cols = 0;      ///< Local tile size
+    int byte0 = 0, nbytes = 0;   ///< Bytes of a board row that cover the tile
+    std::vector<uint8_t> bits;
+
+    LocalBoard() = default;
+    explicit LocalBoard(const Tile &tile)
+        : row0(tile.row0), col0(tile.col0), rows(tile.local_rows), cols(tile.local_cols), byte0(tile.col0 / 8),
+          nbytes((tile.col0 + tile.local_cols - 1) / 8 - tile.col0 / 8 + 1),
+          bits(static_cast<size_t>(rows) * nbytes, 0) {}
+
+    /// Cell at a global position inside the tile
+    int get(int row, int col) const {
+        return (bits[static_cast<size_t>(row - row0) * nbytes + col / 8 - byte0] >> (7 - col % 8)) & 1;
+    }
+    /// Makes the cell at a global position inside the tile alive
+    void set(int row, int col) {
+        bits[static_cast<size_t>(row - row0) * nbytes + col / 8 - byte0] |= static_cast<uint8_t>(0x80 >> (col % 8));
+    }
+};
+
+/**
+ * @brief Reads the rectangle of a checkpoint owned by the tile, with one collective read
+ * @param tile Local tile (its board size must match the checkpoint)
+ * @param path Checkpoint file
+ * @param board Output cells
+ * @return false if the file could not be opened
+ */
+inline bool readCheckpoint(const Tile &tile, const std::string &path, LocalBoard &board) {
+    board = LocalBoard(tile);
+    MPI_File fh;
+    if (MPI_File_open(tile.comm, path.c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+        return false;
+
+    int sizes[2] = {tile.rows, (tile.cols + 7) / 8};
+    int subsizes[2] = {board.rows, board.nbytes};
+    int starts[2] = {board.row0, board.byte0};
+    MPI_Datatype view;
+    MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, MPI_BYTE, &view);
+    MPI_Type_commit(&view);
+    MPI_File_set_view(fh, CHECKPOINT_HEADER, MPI_BYTE, view, "native", MPI_INFO_NULL);
+    MPI_File_read_at_all(fh, 0, board.bits.data(), static_cast<int>(board.bits.size()), MPI_BYTE, MPI_STATUS_IGNORE);
+    MPI_File_close(&fh);
+    MPI_Type_free(&view);
+    return true;
+}
+
+/**
+ * @brief Copies the cells of a local board into the active cells of a grid
+ * @param board Cells of the local tile
+ * @param grid Grid of the same tile
+ */
+template <typename G>
+void applyBoard(const LocalBoard &board, G &grid) {
+    const int h = grid.halo;
+    for (int i = 0; i < board.rows; ++i)
+        for (int j = 0; j < board.cols; ++j)
+            grid.set(h + i, h + j, board.get(board.row0 + i, board.col0 + j));
+}
+
+#endif
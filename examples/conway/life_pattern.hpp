@@ -0,0 +1,355 @@
+/**
+ * @file life_pattern.hpp
+ * @brief Parallel loading of RLE and plaintext patterns for mpi_life
+ *
+ * The pattern file is split into equal byte ranges, one per process, and each
+ * process reads only its range with MPI-IO. What a range does to the parse
+ * cursor (rows advanced, column reached) is combined across processes with a
+ * prefix scan, so every process knows where its first cell lands without
+ * anyone parsing the whole file. Live runs are then routed to the tiles that
+ * own them with one MPI_Alltoallv.
+ *
+ * Formats:
+ * - RLE (.rle): "#" comment lines, a header "x = W, y = H[, rule = ...]" and
+ *   runs of "b" or "." (dead), "o" or any other letter (alive) and "$" (end of row),
+ *   ended by "!". The rule is ignored.
+ * - Plaintext (anything else, usually .cells): one line per row, "." dead and
+ *   "O" or "*" alive; lines starting with "!" are comments.
+ *
+ * The pattern is centered on the board.
+ */
+
+#ifndef LIFE_PATTERN_HPP
+#define LIFE_PATTERN_HPP
+
+#include <mpi.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "life_decomp.hpp"
+#include "life_io.hpp"
+
+/// Run of live cells in a row, in pattern coordinates
+struct PatternRun {
+    int row, col, len;
+};
+
+/**
+ * @brief Reads bytes [lo, hi) of a file (shorter at the end of the file)
+ * @param fh Open file
+ * @param lo First byte
+ * @param hi One past the last byte
+ */
+inline std::string readBytes(MPI_File fh, MPI_Offset lo, MPI_Offset hi) {
+    std::string buf(static_cast<size_t>(std::max<MPI_Offset>(hi - lo, 0)), '\0');
+    MPI_Status status;
+    MPI_File_read_at(fh, lo, &buf[0], static_cast<int>(buf.size()), MPI_BYTE, &status);
+    int count;
+    MPI_Get_count(&status, MPI_BYTE, &count);
+    buf.resize(count);
+    return buf;
+}
+
+/**
+ * @brief Effect of a stretch of RLE on the parse cursor
+ *
+ * Combining an earlier stretch a with a later one b gives a stretch that
+ * moves the cursor like a then b, which is associative, so it can be scanned.
+ */
+struct RleShift {
+    long long rows = 0;      ///< Rows advanced by "$"
+    long long col = 0;       ///< Column reached (relative if no "$" was seen)
+    long long newline = 0;   ///< Whether a "$" was seen
+    long long ended = 0;     ///< Whether "!" was seen
+};
+
+/// MPI_Op body: inout = in followed by inout
+inline void combineRleShift(void *in, void *inout, int *len, MPI_Datatype *) {
+    const RleShift *a = static_cast<const RleShift *>(in);
+    RleShift *b = static_cast<RleShift *>(inout);
+    for (int k = 0; k < *len; ++k) {
+        RleShift r = a[k];
+        if (!a[k].ended) {
+            r.rows = a[k].rows + b[k].rows;
+            r.col = b[k].newline ? b[k].col : a[k].col + b[k].col;
+            r.newline = a[k].newline || b[k].newline;
+            r.ended = b[k].ended;
+        }
+        b[k] = r;
+    }
+}
+
+/**
+ * @brief Parses the RLE runs whose tag byte falls in this process' range
+ * @param fh Open file
+ * @param size File size
+ * @param comm Processes loading the file
+ * @param runs Live runs found
+ * @param height Pattern rows
+ * @param width Pattern columns
+ * @param error Reason of a failure on this process
+ * @return false if the header is missing or a run count does not fit the lookback
+ */
+inline bool parseRle(MPI_File fh, MPI_Offset size, MPI_Comm comm, std::vector<PatternRun> &runs, int &height,
+                     int &width, std::string &error) {
+    int rank, nprocs;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &nprocs);
+
+    // Rank 0 finds the header line; the data starts after it
+    long long info[3] = {-1, 0, 0};  // data offset, width, height
+    if (rank == 0) {
+        MPI_Offset pos = 0;
+        while (pos < size && info[0] < 0) {
+            std::string line;
+            for (;;) {
+                std::string chunk = readBytes(fh, pos + static_cast<MPI_Offset>(line.size()),
+                                              pos + static_cast<MPI_Offset>(line.size()) + 4096);
+                size_t nl = chunk.find('\n');
+                line += chunk.substr(0, nl);
+                if (nl != std::string::npos || chunk.empty())
+                    break;
+            }
+            MPI_Offset next = pos + static_cast<MPI_Offset>(line.size()) + 1;
+            size_t first = line.find_first_not_of(" \t\r");
+            if (first != std::string::npos && line[first] == 'x') {
+                int w = 0, h = 0;
+                if (sscanf(line.c_str() + first, "x = %d , y = %d", &w, &h) == 2 && w > 0 && h > 0) {
+                    info[0] = next;
+                    info[1] = w;
+                    info[2] = h;
+                }
+                break;
+            }
+            if (first != std::string::npos && line[first] != '#')
+                break;
+            pos = next;
+        }
+    }
+    MPI_Bcast(info, 3, MPI_LONG_LONG, 0, comm);
+    if (info[0] < 0) {
+        error = "falta la cabecera 'x = ..., y = ...'";
+        return false;
+    }
+    const MPI_Offset data = std::min<MPI_Offset>(info[0], size);
+    width = static_cast<int>(info[1]);
+    height = static_cast<int>(info[2]);
+
+    // A run belongs to the range holding its tag; its count may start before
+    const int lookback = 64;
+    MPI_Offset b0 = data + (size - data) * rank / nprocs;
+    MPI_Offset b1 = data + (size - data) * (rank + 1) / nprocs;
+    MPI_Offset lo = std::max(data, b0 - lookback);
+    std::string buf = readBytes(fh, lo, b1);
+    size_t begin = static_cast<size_t>(b0 - lo);
+    while (begin > 0 && (std::isdigit(static_cast<unsigned char>(buf[begin - 1])) ||
+                         std::isspace(static_cast<unsigned char>(buf[begin - 1]))))
+        --begin;
+    bool ok = !(begin == 0 && lo > data);
+    if (!ok)
+        error = "contador de repetición demasiado largo";
+
+    // Runs the range from a cursor; with emit, records the live runs
+    auto parse = [&](long long row, long long col, bool emit) {
+        RleShift shift;
+        long long count = 0;
+        for (size_t k = ok ? begin : buf.size(); k < buf.size(); ++k) {
+            unsigned char c = static_cast<unsigned char>(buf[k]);
+            if (std::isdigit(c)) {
+                count = count * 10 + (c - '0');
+                continue;
+            }
+            if (std::isspace(c))
+                continue;
+            long long n = count > 0 ? count : 1;
+            count = 0;
+            if (c == '!') {
+                shift.ended = 1;
+                break;
+            } else if (c == '$') {
+                row += n;
+                col = 0;
+                shift.rows += n;
+                shift.col = 0;
+                shift.newline = 1;
+            } else if (std::isalpha(c) || c == '.') {
+                if (c != 'b' && c != '.' && emit && row < height && col < width)
+                    runs.push_back({static_cast<int>(row), static_cast<int>(col),
+                                    static_cast<int>(std::min<long long>(n, width - col))});
+                col += n;
+                shift.col += n;
+            }
+        }
+        return shift;
+    };
+
+    RleShift mine = parse(0, 0, false), before;
+    MPI_Datatype type;
+    MPI_Type_contiguous(4, MPI_LONG_LONG, &type);
+    MPI_Type_commit(&type);
+    MPI_Op op;
+    MPI_Op_create(combineRleShift, 0, &op);
+    MPI_Exscan(&mine, &before, 1, type, op, comm);
+    MPI_Op_free(&op);
+    MPI_Type_free(&type);
+    if (rank == 0)
+        before = RleShift();
+
+    if (!before.ended)
+        parse(before.rows, before.col, true);
+    return ok;
+}
+
+/**
+ * @brief Parses the plaintext rows whose first byte falls in this process' range
+ * @param fh Open file
+ * @param size File size
+ * @param comm Processes loading the file
+ * @param runs Live runs found
+ * @param height Pattern rows
+ * @param width Pattern columns
+ */
+inline void parsePlaintext(MPI_File fh, MPI_Offset size, MPI_Comm comm, std::vector<PatternRun> &runs,
+                           int &height, int &width) {
+    int rank, nprocs;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &nprocs);
+
+    // One byte before the range tells whether a line starts on its first byte,
+    // and the last line is read past the range up to its end
+    MPI_Offset b0 = size * rank / nprocs, b1 = size * (rank + 1) / nprocs;
+    MPI_Offset lo = b0 > 0 ? b0 - 1 : 0;
+    std::string buf = readBytes(fh, lo, b1);
+    while (lo + static_cast<MPI_Offset>(buf.size()) < size && (buf.empty() || buf.back() != '\n')) {
+        std::string more = readBytes(fh, lo + static_cast<MPI_Offset>(buf.size()),
+                                     lo + static_cast<MPI_Offset>(buf.size()) + 4096);
+        size_t nl = more.find('\n');
+        buf += more.substr(0, nl == std::string::npos ? more.size() : nl + 1);
+    }
+
+    size_t k = 0;
+    if (b0 > 0) {
+        size_t nl = buf.find('\n');
+        k = nl == std::string::npos ? buf.size() : nl + 1;
+    }
+    std::vector<PatternRun> local;
+    int rows = 0, widest = 0;
+    while (k < buf.size() && lo + static_cast<MPI_Offset>(k) < b1) {
+        size_t end = buf.find('\n', k);
+        if (end == std::string::npos)
+            end = buf.size();
+        std::string line = buf.substr(k, end - k);
+        k = end + 1;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (!line.empty() && line[0] == '!')
+            continue;
+        for (size_t j = 0; j < line.size();) {
+            if (line[j] == 'O' || line[j] == '*') {
+                size_t e = j;
+                while (e < line.size() && (line[e] == 'O' || line[e] == '*'))
+                    ++e;
+                local.push_back({rows, static_cast<int>(j), static_cast<int>(e - j)});
+                j = e;
+            } else {
+                ++j;
+            }
+        }
+        widest = std::max(widest, static_cast<int>(line.size()));
+        ++rows;
+    }
+
+    int row0 = 0;
+    MPI_Exscan(&rows, &row0, 1, MPI_INT, MPI_SUM, comm);
+    if (rank == 0)
+        row0 = 0;
+    MPI_Allreduce(&rows, &height, 1, MPI_INT, MPI_SUM, comm);
+    MPI_Allreduce(&widest, &width, 1, MPI_INT, MPI_MAX, comm);
+    for (PatternRun &r : local)
+        r.row += row0;
+    runs.insert(runs.end(), local.begin(), local.end());
+}
+
+/**
+ * @brief Loads a pattern file, centered on the board, into the cells of each tile
+ * @param tile Local tile of the decomposition
+ * @param path RLE (.rle) or plaintext file
+ * @param board Output cells of the local tile
+ * @param error Reason of the failure (on rank 0)
+ * @return false on every process if any of them failed
+ */
+inline bool loadPattern(const Tile &tile, const std::string &path, LocalBoard &board, std::string &error) {
+    board = LocalBoard(tile);
+    MPI_File fh;
+    if (MPI_File_open(tile.comm, path.c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+        error = "no se pudo abrir el archivo";
+        return false;
+    }
+    MPI_Offset size;
+    MPI_File_get_size(fh, &size);
+
+    std::vector<PatternRun> runs;
+    int height = 0, width = 0;
+    bool rle = path.size() >= 4 && path.compare(path.size() - 4, 4, ".rle") == 0;
+    int ok = 1;
+    if (rle)
+        ok = parseRle(fh, size, tile.comm, runs, height, width, error);
+    else
+        parsePlaintext(fh, size, tile.comm, runs, height, width);
+    MPI_File_close(&fh);
+
+    int all_ok;
+    MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_MIN, tile.comm);
+    if (!all_ok) {
+        if (error.empty())
+            error = "error de formato";
+        return false;
+    }
+    if (height > tile.rows || width > tile.cols) {
+        error = "el patrón de " + std::to_string(height) + "x" + std::to_string(width) + " no entra en el tablero";
+        return false;
+    }
+
+    // Route every run, split at tile columns, to the process that owns it
+    const int off_r = (tile.rows - height) / 2, off_c = (tile.cols - width) / 2;
+    std::vector<std::vector<int>> out(tile.size);
+    for (const PatternRun &r : runs) {
+        int row = off_r + r.row;
+        int coords[2] = {sliceOwner(tile.row_bounds, row), 0};
+        for (int c = off_c + r.col, end = off_c + r.col + r.len; c < end;) {
+            coords[1] = sliceOwner(tile.col_bounds, c);
+            int stop = std::min(end, tile.col_bounds[coords[1] + 1]);
+            int dest;
+            MPI_Cart_rank(tile.comm, coords, &dest);
+            out[dest].insert(out[dest].end(), {row, c, stop - c});
+            c = stop;
+        }
+    }
+
+    std::vector<int> send_counts(tile.size), recv_counts(tile.size), send_displs(tile.size), recv_displs(tile.size);
+    std::vector<int> send;
+    for (int p = 0; p < tile.size; ++p) {
+        send_counts[p] = static_cast<int>(out[p].size());
+        send_displs[p] = static_cast<int>(send.size());
+        send.insert(send.end(), out[p].begin(), out[p].end());
+    }
+    MPI_Alltoall(send_counts.data(), 1, MPI_INT, recv_counts.data(), 1, MPI_INT, tile.comm);
+    int total = 0;
+    for (int p = 0; p < tile.size; ++p) {
+        recv_displs[p] = total;
+        total += recv_counts[p];
+    }
+    std::vector<int> recv(total);
+    MPI_Alltoallv(send.data(), send_counts.data(), send_displs.data(), MPI_INT,
+                  recv.data(), recv_counts.data(), recv_displs.data(), MPI_INT, tile.comm);
+
+    for (int k = 0; k + 2 < total; k += 3)
+        for (int c = recv[k + 1]; c < recv[k + 1] + recv[k + 2]; ++c)
+            board.set(recv[k], c);
+    return true;
+}
+
+#endif
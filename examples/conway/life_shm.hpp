@@ -0,0 +1,160 @@
+/**
+ * @file life_shm.hpp
+ * @brief Halo mailboxes in shared memory for the neighbors on the same node
+ *
+ * The ranks of a node (MPI_Comm_split_type with MPI_COMM_TYPE_SHARED) share
+ * one MPI_Win_allocate_shared window. The segment of each rank holds, for
+ * every direction, two mailboxes (one per grid of the double buffer) where it
+ * packs the edge it sends. A neighbor on the same node unpacks the edge
+ * straight from that mailbox into its ghost frame: no message, no matching,
+ * one copy on each side. Neighbors on other nodes keep using messages.
+ *
+ * Exchanges are numbered. Each segment starts with lock-free atomic counters:
+ * the last exchange posted in every direction (written with release by the
+ * sender) and the last one unpacked from every neighbor (written by the
+ * receiver). A mailbox is only rewritten once the neighbor has unpacked its
+ * previous contents, so there is no lock and no MPI call per exchange.
+ */
+
+#ifndef LIFE_SHM_HPP
+#define LIFE_SHM_HPP
+
+#include <mpi.h>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#include "life_decomp.hpp"
+
+/**
+ * @brief Per-direction mailboxes of one tile, shared with the ranks of its node
+ */
+class ShmMailboxes {
+public:
+    /**
+     * @brief Allocates the window and finds the neighbors on this node (collective over tile.comm)
+     * @param tile Local tile
+     * @param bytes Size of the edge sent in every direction
+     */
+    ShmMailboxes(const Tile &tile, const size_t bytes[8]) {
+        MPI_Comm_split_type(tile.comm, MPI_COMM_TYPE_SHARED, tile.rank, MPI_INFO_NULL, &node_);
+        MPI_Group all, node;
+        MPI_Comm_group(tile.comm, &all);
+        MPI_Comm_group(node_, &node);
+        MPI_Group_translate_ranks(all, 8, tile.neighbors, node, peer_);
+        MPI_Group_free(&all);
+        MPI_Group_free(&node);
+
+        size_t offset = align(sizeof(Header));
+        size_t offsets[8][2];
+        for (int d = 0; d < 8; ++d)
+            for (int s = 0; s < 2; ++s) {
+                offsets[d][s] = offset;
+                offset += align(bytes[d]);
+            }
+        MPI_Win_allocate_shared(static_cast<MPI_Aint>(offset), 1, MPI_INFO_NULL, node_, &mine_, &win_);
+        std::memset(mine_, 0, offset);
+        header_ = new (mine_) Header();
+        std::memcpy(header_->offset, offsets, sizeof(offsets));
+        MPI_Win_lock_all(MPI_MODE_NOCHECK, win_);
+        MPI_Barrier(node_);
+
+        for (int d = 0; d < 8; ++d) {
+            peers_[d] = nullptr;
+            if (peer_[d] != MPI_UNDEFINED) {
+                MPI_Aint size;
+                int unit;
+                MPI_Win_shared_query(win_, peer_[d], &size, &unit, &peers_[d]);
+            }
+        }
+    }
+
+    ~ShmMailboxes() {
+        MPI_Win_unlock_all(win_);
+        MPI_Win_free(&win_);
+        MPI_Comm_free(&node_);
+    }
+
+    ShmMailboxes(const ShmMailboxes &) = delete;
+    ShmMailboxes &operator=(const ShmMailboxes &) = delete;
+
+    /// Whether the neighbor in direction d runs on this node
+    bool local(int d) const { return peer_[d] != MPI_UNDEFINED; }
+
+    /// Number of neighbor directions served through shared memory
+    int localCount() const {
+        int n = 0;
+        for (int d = 0; d < 8; ++d)
+            n += local(d);
+        return n;
+    }
+
+    /// Starts the next exchange; call once before its send() and receive() calls
+    void begin() { ++round_; }
+
+    /**
+     * @brief Mailbox for the edge sent in direction d, once the neighbor is done with it
+     * @param d Direction
+     * @param s Grid of the double buffer
+     */
+    void *send(int d, int s) {
+        const Header *peer = header(d);
+        while (peer->unpacked[7 - d].load(std::memory_order_acquire) < last_[d][s])
+            std::this_thread::yield();
+        last_[d][s] = round_;
+        return static_cast<char *>(mine_) + header_->offset[d][s];
+    }
+
+    /**
+     * @brief Publishes the mailbox of direction d for this exchange
+     * @param d Direction
+     * @param s Grid of the double buffer
+     * @param changed Whether the mailbox was rewritten (sparse stepping)
+     */
+    void post(int d, int s, bool changed) {
+        header_->changed[d][s] = changed;
+        header_->posted[d].store(round_, std::memory_order_release);
+    }
+
+    /**
+     * @brief Waits for the edge of the neighbor in direction d and returns its mailbox
+     * @param d Ghost direction
+     * @param s Grid of the double buffer
+     * @param changed Set to whether the neighbor rewrote the mailbox
+     */
+    const void *receive(int d, int s, bool &changed) const {
+        const Header *peer = header(d);
+        while (peer->posted[7 - d].load(std::memory_order_acquire) < round_)
+            std::this_thread::yield();
+        changed = peer->changed[7 - d][s];
+        return static_cast<const char *>(peers_[d]) + peer->offset[7 - d][s];
+    }
+
+    /// Tells the neighbor in direction d that its mailbox was unpacked
+    void release(int d) { header_->unpacked[d].store(round_, std::memory_order_release); }
+
+private:
+    /// Start of every segment
+    struct Header {
+        std::atomic<long> posted[8];    ///< Last exchange posted in each direction
+        std::atomic<long> unpacked[8];  ///< Last exchange unpacked from each neighbor
+        bool changed[8][2];             ///< Whether each mailbox was rewritten when last posted
+        size_t offset[8][2];            ///< Position of each mailbox in the segment
+    };
+
+    static size_t align(size_t n) { return (n + 63) / 64 * 64; }
+    const Header *header(int d) const { return static_cast<const Header *>(peers_[d]); }
+
+    MPI_Comm node_;
+    MPI_Win win_;
+    void *mine_;
+    Header *header_;
+    int peer_[8];              ///< Rank of each neighbor in node_, or MPI_UNDEFINED
+    void *peers_[8];           ///< Segment of each neighbor on this node
+    long round_ = 0;           ///< Number of the current exchange
+    long last_[8][2] = {};     ///< Exchange that last wrote each mailbox
+};
+
+#endif
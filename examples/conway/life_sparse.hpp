@@ -0,0 +1,172 @@
+/**
+ * @file life_sparse.hpp
+ * @brief Activity tracking for mpi_life: skip the parts of a tile that cannot change
+ *
+ * The active cells of a tile are split into blocks of BLOCK x BLOCK cells,
+ * aligned to multiples of BLOCK in stored coordinates so that two blocks of
+ * the bit backend never share a word.
+ *
+ * A block is "changed" when it differs from two generations back, which is
+ * what the other grid of the double buffer holds. If a block and its 8
+ * neighbor blocks (or the ghost cells facing it) did not change, its next
+ * state equals the one two generations back, already in the next grid, so
+ * the block is skipped. Comparing two generations apart makes still lifes and
+ * period-2 oscillators (blinkers, most of the ash a soup leaves) both count as
+ * stable.
+ *
+ * The same bitmap tells which edges did not change: those halos travel as
+ * empty messages and the neighbor keeps the ghost cells of that grid. This
+ * requires an exchange every generation (halo depth 1).
+ */
+
+#ifndef LIFE_SPARSE_HPP
+#define LIFE_SPARSE_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include "life_decomp.hpp"
+#include "life_threads.hpp"
+
+/**
+ * @brief Changed/unchanged bitmap over the blocks of a tile
+ */
+class ActivityMap {
+public:
+    static constexpr int BLOCK = 64;  ///< Block side in cells
+
+    /**
+     * @brief Marks every block and ghost region as changed
+     * @param rows Active local rows
+     * @param cols Active local columns
+     * @param halo Width of the ghost frame (smaller than BLOCK)
+     */
+    ActivityMap(int rows, int cols, int halo)
+        : r_begin_(halo), r_end_(halo + rows), c_begin_(halo), c_end_(halo + cols),
+          nbr_((r_end_ - 1) / BLOCK + 1), nbc_((c_end_ - 1) / BLOCK + 1),
+          changed_(static_cast<size_t>(nbr_) * nbc_, 1), next_(changed_.size(), 0) {
+        for (int d = 0; d < 8; ++d)
+            ghost_changed_[d] = true;
+    }
+
+    int blocks() const { return nbr_ * nbc_; }
+
+    /// Stored cells of block b (blocks are numbered row by row)
+    Region block(int b) const {
+        int bi = b / nbc_, bj = b % nbc_;
+        Region r;
+        r.r0 = std::max(r_begin_, bi * BLOCK);
+        r.nr = std::min(r_end_, (bi + 1) * BLOCK) - r.r0;
+        r.c0 = std::max(c_begin_, bj * BLOCK);
+        r.nc = std::min(c_end_, (bj + 1) * BLOCK) - r.c0;
+        return r;
+    }
+
+    /// Whether the cells sent in direction d changed in the last generation computed
+    bool edgeChanged(int d) const {
+        int i0 = DIRS[d][0] > 0 ? nbr_ - 1 : 0, i1 = DIRS[d][0] < 0 ? 1 : nbr_;
+        int j0 = DIRS[d][1] > 0 ? nbc_ - 1 : 0, j1 = DIRS[d][1] < 0 ? 1 : nbc_;
+        for (int bi = i0; bi < i1; ++bi)
+            for (int bj = j0; bj < j1; ++bj)
+                if (changed_[static_cast<size_t>(bi) * nbc_ + bj])
+                    return true;
+        return false;
+    }
+
+    /// Records which ghost regions changed in the last exchange
+    void setGhostChanged(const bool changed[8]) {
+        for (int d = 0; d < 8; ++d)
+            ghost_changed_[d] = changed[d];
+    }
+
+    /**
+     * @brief Lists the blocks that must be recomputed this generation
+     *
+     * Interior blocks do not read the ghost frame, so they can be collected
+     * before the halos arrive.
+     * @param interior Include blocks away from the tile edges
+     * @param edge Include blocks on the tile edges (needs setGhostChanged())
+     * @param out Block numbers
+     */
+    void collect(bool interior, bool edge, std::vector<int> &out) const {
+        out.clear();
+        for (int bi = 0; bi < nbr_; ++bi)
+            for (int bj = 0; bj < nbc_; ++bj) {
+                bool on_edge = bi == 0 || bj == 0 || bi == nbr_ - 1 || bj == nbc_ - 1;
+                if ((on_edge ? edge : interior) && needsUpdate(bi, bj))
+                    out.push_back(bi * nbc_ + bj);
+            }
+    }
+
+    /// Records whether block b changed in the generation being computed
+    void mark(int b, bool changed) { next_[b] = changed; }
+
+    /**
+     * @brief Makes the marks of the computed generation current; unmarked blocks did not change
+     *
+     * The first generation is written over a grid with no previous state, so
+     * all its blocks count as changed.
+     */
+    void advance() {
+        changed_.swap(next_);
+        std::fill(next_.begin(), next_.end(), 0);
+        if (generation_++ == 0)
+            std::fill(changed_.begin(), changed_.end(), 1);
+    }
+
+private:
+    bool needsUpdate(int bi, int bj) const {
+        for (int di = -1; di <= 1; ++di)
+            for (int dj = -1; dj <= 1; ++dj) {
+                int ni = bi + di, nj = bj + dj;
+                int dr = ni < 0 ? -1 : ni >= nbr_ ? 1 : 0;
+                int dc = nj < 0 ? -1 : nj >= nbc_ ? 1 : 0;
+                if (dr == 0 && dc == 0) {
+                    if (changed_[static_cast<size_t>(ni) * nbc_ + nj])
+                        return true;
+                } else {
+                    // Outside the tile: the ghost region in that direction
+                    int d = (dr + 1) * 3 + (dc + 1);
+                    if (ghost_changed_[d > 4 ? d - 1 : d])
+                        return true;
+                }
+            }
+        return false;
+    }
+
+    int r_begin_, r_end_, c_begin_, c_end_;
+    int nbr_, nbc_;               ///< Block rows and columns
+    std::vector<char> changed_;   ///< Blocks changed in the last generation
+    std::vector<char> next_;      ///< Blocks changed in the generation being computed
+    bool ghost_changed_[8];       ///< Ghost regions changed in the last exchange
+    int generation_ = 0;          ///< Generations computed so far
+};
+
+/**
+ * @brief Applies Conway's rules to a list of blocks, splitting them across the pool
+ *
+ * Every block is compared with what the next grid held and marked in the map.
+ * @param pool Thread pool
+ * @param current The current grid
+ * @param next The updated grid
+ * @param map Activity map of the tile
+ * @param blocks Block numbers, as returned by ActivityMap::collect()
+ */
+template <typename G>
+void updateBlocks(ThreadPool &pool, const G &current, G &next, ActivityMap &map, const std::vector<int> &blocks) {
+    const int n = static_cast<int>(blocks.size());
+    if (n == 0)
+        return;
+    auto work = [&](int t, int p) {
+        for (int k = blockStart(n, p, t); k < blockStart(n, p, t + 1); ++k) {
+            Region r = map.block(blocks[k]);
+            map.mark(blocks[k], updateGridChanged(current, next, r.r0, r.r0 + r.nr, r.c0, r.c0 + r.nc));
+        }
+    };
+    if (n < pool.size())
+        work(0, 1);
+    else
+        pool.run([&](int t) { work(t, pool.size()); });
+}
+
+#endif
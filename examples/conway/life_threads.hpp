@@ -0,0 +1,152 @@
+/**
+ * @file life_threads.hpp
+ * @brief Thread pool used by mpi_life to update a tile on every core of a node
+ *
+ * The calling thread is worker 0 and is the only one that talks to MPI
+ * (MPI_THREAD_FUNNELED). Work is split by rows with the same partition that
+ * first touches the grid memory, so each core updates rows that were faulted
+ * in by itself.
+ */
+
+#ifndef LIFE_THREADS_HPP
+#define LIFE_THREADS_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "life_decomp.hpp"
+
+/**
+ * @brief Fixed set of worker threads that run one job at a time
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Starts threads - 1 workers; the caller is the remaining one
+     * @param threads Total number of threads, caller included
+     */
+    explicit ThreadPool(int threads) : size_(threads < 1 ? 1 : threads) {
+        for (int t = 1; t < size_; ++t)
+            workers_.emplace_back(&ThreadPool::worker, this, t);
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+            ++epoch_;
+        }
+        start_.notify_all();
+        for (auto &w : workers_)
+            w.join();
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    int size() const { return size_; }
+
+    /**
+     * @brief Runs fn(thread index) on every thread and waits for all of them
+     * @param fn Job; index 0 runs on the calling thread
+     */
+    void run(const std::function<void(int)> &fn) {
+        if (size_ == 1) {
+            fn(0);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = &fn;
+            pending_ = size_ - 1;
+            ++epoch_;
+        }
+        start_.notify_all();
+        fn(0);
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return pending_ == 0; });
+        job_ = nullptr;
+    }
+
+private:
+    void worker(int id) {
+        uint64_t seen = 0;
+        for (;;) {
+            const std::function<void(int)> *job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                start_.wait(lock, [&] { return epoch_ != seen; });
+                seen = epoch_;
+                if (stop_)
+                    return;
+                job = job_;
+            }
+            (*job)(id);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (--pending_ == 0)
+                    done_.notify_one();
+            }
+        }
+    }
+
+    int size_;
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable start_, done_;
+    const std::function<void(int)> *job_ = nullptr;
+    uint64_t epoch_ = 0;
+    int pending_ = 0;
+    bool stop_ = false;
+};
+
+/**
+ * @brief Allocates a grid whose pages are first touched by the thread that updates them
+ *
+ * Every thread zeroes its share of the stored rows, which is the partition
+ * updateGridParallel uses for the active rows.
+ * @param pool Thread pool
+ * @param rows Active local rows
+ * @param cols Active local columns
+ * @param halo Width of the ghost frame
+ * @return The zeroed grid
+ */
+template <typename G>
+G makeGrid(ThreadPool &pool, int rows, int cols, int halo) {
+    G grid(rows, cols, halo, false);
+    const int stored = rows + 2 * halo;
+    pool.run([&](int t) {
+        grid.zeroRows(blockStart(stored, pool.size(), t), blockStart(stored, pool.size(), t + 1));
+    });
+    return grid;
+}
+
+/**
+ * @brief Applies Conway's rules to a rectangle, splitting its rows across the pool
+ * @param pool Thread pool
+ * @param current The current grid
+ * @param next The updated grid
+ * @param r0 First stored row
+ * @param r1 One past the last stored row
+ * @param c0 First stored column
+ * @param c1 One past the last stored column
+ */
+template <typename G>
+void updateGridParallel(ThreadPool &pool, const G &current, G &next, int r0, int r1, int c0, int c1) {
+    if (r1 <= r0)
+        return;
+    if (pool.size() == 1 || r1 - r0 < pool.size()) {
+        updateGrid(current, next, r0, r1, c0, c1);
+        return;
+    }
+    pool.run([&](int t) {
+        updateGrid(current, next, r0 + blockStart(r1 - r0, pool.size(), t),
+                   r0 + blockStart(r1 - r0, pool.size(), t + 1), c0, c1);
+    });
+}
+
+#endif
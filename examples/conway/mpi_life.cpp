@@ -2,12 +2,36 @@
  * @file conway_mpi.cpp
  * @brief Parallel Conway's Game of Life using MPI
  *
- * This program runs Conway's Game of Life in parallel using MPI. Each MPI process
- * handles a block of rows, with ghost rows exchanged between neighbors.
- * The game updates and displays the full grid over a number of generations.
+ * This program runs Conway's Game of Life in parallel using MPI. The board is
+ * a torus split into 2D tiles over a periodic Cartesian process grid (see
+ * life_decomp.hpp); each MPI process exchanges a ghost frame with its 8
+ * neighbors. The game updates and displays the full grid over a number of
+ * generations.
+ *
+ * Two grid backends are available: the default one stores one int per cell,
+ * while "--engine bitpacked" packs 64 cells per uint64_t (see life_bitpacked.hpp).
+ * With "--threads N" each process updates its tile on N cores (life_threads.hpp).
+ * "--bench" drops the rendering and reports cells updated per second, and
+ * "--snapshot-every N" writes PBM frames in parallel with MPI-IO (life_io.hpp).
+ * "--sparse" only updates the blocks that can change (life_sparse.hpp).
+ * "--load" starts from an RLE or plaintext pattern parsed in parallel
+ * (life_pattern.hpp), and "--checkpoint-every N" / "--restart" save and resume
+ * runs with any number of processes (life_io.hpp). "--rebalance-every M"
+ * moves the tile boundaries toward the measured speed of each node
+ * (life_balance.hpp). "--engine hashlife" jumps 2^k generations at a time
+ * with a quadtree memoized across the processes (life_hashlife.hpp). "--shm"
+ * trades halos with the neighbors on the same node through a shared memory
+ * window instead of messages (life_shm.hpp). "--ensemble batch.txt" runs many
+ * small independent boards, each one whole on a single thread, handed out
+ * by a work queue shared by all processes (life_ensemble.hpp).
  *
  * Usage:
- *   mpirun -np <processes> ./conway_mpi -c <cols> -f <rows> -g <generations>
+ *   mpirun -np <processes> ./conway_mpi -c <cols> -f <rows> -g <generations> [--engine int|bitpacked]
+ *          [--no-overlap] [--halo-depth k] [--halo-sweep K] [--threads N]
+ *          [--bench] [--snapshot-every N] [--seed S] [--sparse]
+ *          [--load pattern.rle|pattern.cells] [--checkpoint-every N] [--restart file.ckpt]
+ *          [--rebalance-every M] [--engine hashlife [--hash-step k] [--hash-memory MB]] [--shm]
+ *   mpirun -np <processes> ./conway_mpi --ensemble batch.txt [--ensemble-out results.csv] [--threads N]
  */
 
 #include <mpi.h>
@@ -17,9 +41,24 @@
 #include <ctime>
 #include <unistd.h>
 #include <thread>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <fstream>
+#include <sstream>
 
-/// Type alias for the grid
-using Grid = std::vector<std::vector<int>>;
+#include "life_grid.hpp"
+#include "life_bitpacked.hpp"
+#include "life_decomp.hpp"
+#include "life_halo.hpp"
+#include "life_threads.hpp"
+#include "life_io.hpp"
+#include "life_sparse.hpp"
+#include "life_pattern.hpp"
+#include "life_balance.hpp"
+#include "life_hashlife.hpp"
+#include "life_ensemble.hpp"
 
 // ANSI color codes
 const std::string PURPLE = "\033[35m";
@@ -27,90 +66,642 @@ const std::string WHITE = "\033[37m";
 const std::string RESET = "\033[0m";
 
 /**
- * @brief Initializes the local subgrid with random 0s and 1s
- * @param grid The grid to initialize
- * @param local_rows Number of active local rows
- * @param cols Number of columns
+ * @brief Gathers and prints the full grid from all processes
+ * @param local_grid Local grid (with ghost frame)
+ * @param tile Local tile of the decomposition
+ */
+template <typename G>
+void printFullGrid(const G &local_grid, const Tile &tile) {
+    const int h = local_grid.halo;
+    std::vector<int> local(static_cast<size_t>(tile.local_rows) * tile.local_cols);
+    for (int i = 0; i < tile.local_rows; ++i)
+        for (int j = 0; j < tile.local_cols; ++j)
+            local[static_cast<size_t>(i) * tile.local_cols + j] = local_grid.get(h + i, h + j);
+
+    std::vector<int> counts(tile.size), displs(tile.size), all;
+    if (tile.rank == 0) {
+        int offset = 0;
+        for (int r = 0; r < tile.size; ++r) {
+            int coords[2], row0, nrows, col0, ncols;
+            MPI_Cart_coords(tile.comm, r, 2, coords);
+            tileExtent(tile, coords, row0, nrows, col0, ncols);
+            counts[r] = nrows * ncols;
+            displs[r] = offset;
+            offset += counts[r];
+        }
+        all.resize(offset);
+    }
+    MPI_Gatherv(local.data(), static_cast<int>(local.size()), MPI_INT,
+                all.data(), counts.data(), displs.data(), MPI_INT, 0, tile.comm);
+
+    if (tile.rank == 0) {
+        std::vector<std::vector<int>> full_grid(tile.rows, std::vector<int>(tile.cols));
+        for (int r = 0; r < tile.size; ++r) {
+            int coords[2], row0, nrows, col0, ncols;
+            MPI_Cart_coords(tile.comm, r, 2, coords);
+            tileExtent(tile, coords, row0, nrows, col0, ncols);
+            for (int i = 0; i < nrows; ++i)
+                for (int j = 0; j < ncols; ++j)
+                    full_grid[row0 + i][col0 + j] = all[displs[r] + i * ncols + j];
+        }
+
+        system("clear");
+        for (const auto &row : full_grid)
+            for (int j = 0; j < tile.cols; ++j)
+                std::cout << (row[j] ? PURPLE + "█" + RESET : WHITE + " " + RESET), j == tile.cols - 1 ? std::cout << "\n" : std::cout << "";
+    }
+}
+
+/// Command line options
+struct Options {
+    int cols = 40, rows = 40, gens = 10;
+    std::string engine = "int";
+    bool overlap = true;  ///< Overlap the halo exchange with the interior update
+    int halo_depth = 1;   ///< Ghost cells exchanged every halo_depth generations
+    int halo_sweep = 0;   ///< Largest depth timed by the sweep (0: no sweep)
+    int threads = 1;      ///< Threads per process updating the tile
+    bool bench = false;   ///< No rendering or sleep, report cells/second instead
+    int snapshot_every = 0;  ///< Write a PBM frame every N generations (0: never)
+    long seed = -1;       ///< Base seed of the initial board (-1: time based)
+    bool sparse = false;  ///< Skip blocks and halos that cannot change
+    std::string load;     ///< RLE or plaintext pattern to start from
+    std::string restart;  ///< Checkpoint to resume from
+    int checkpoint_every = 0;  ///< Write a checkpoint every N generations (0: never)
+    long start_gen = 0;   ///< Generation of the initial board (from the checkpoint)
+    int rebalance_every = 0;  ///< Move tile boundaries every M generations (0: never)
+    int hash_step = -1;     ///< HashLife jumps up to 2^k generations (-1: the largest the board allows)
+    int hash_memory = 256;  ///< HashLife node table cap per process, in MB
+    bool shm = false;     ///< Halos with neighbors on the same node through shared memory
+    std::string ensemble;  ///< Batch of independent boards to run instead of one board
+    std::string ensemble_out = "ensemble.csv";  ///< Per-board results of the ensemble
+};
+
+/// Timings of one run, in seconds per generation
+struct RunStats {
+    double blocking = 0;  ///< Blocking exchange, amortized over the depth
+    double exposed = 0;   ///< Time spent posting and waiting for halos
+    double interior = 0;  ///< Interior update overlapped with the halos
+    double total = 0;     ///< Wall time of a generation, snapshots excluded
+    double snapshots = 0; ///< Total time spent writing snapshots and checkpoints
+    double blocks = 1;    ///< Share of blocks updated (sparse stepping)
+    double halos = 1;     ///< Share of halos sent with cells (sparse stepping)
+    double shared = 0;    ///< Neighbor directions served through shared memory
+    std::vector<double> gen_times;  ///< Time of every generation
+};
+
+/**
+ * @brief Applies Conway's rules to the border of a rectangle
+ *
+ * These are the cells that read the ghost frame, so they are updated after
+ * the halos arrive.
+ * @param pool Thread pool
+ * @param current The current grid
+ * @param next The updated grid
+ * @param r0 First stored row
+ * @param r1 One past the last stored row
+ * @param c0 First stored column
+ * @param c1 One past the last stored column
+ * @param width Border width
  */
-void initGrid(Grid &grid, int local_rows, int cols) {
-    for (int i = 1; i <= local_rows; ++i)
-        for (int j = 0; j < cols; ++j)
-            grid[i][j] = rand() % 2;
+template <typename G>
+void updateBorder(ThreadPool &pool, const G &current, G &next, int r0, int r1, int c0, int c1, int width) {
+    if (r1 - r0 <= 2 * width || c1 - c0 <= 2 * width) {
+        updateGridParallel(pool, current, next, r0, r1, c0, c1);
+        return;
+    }
+    updateGridParallel(pool, current, next, r0, r0 + width, c0, c1);
+    updateGridParallel(pool, current, next, r1 - width, r1, c0, c1);
+    updateGridParallel(pool, current, next, r0 + width, r1 - width, c0, c0 + width);
+    updateGridParallel(pool, current, next, r0 + width, r1 - width, c1 - width, c1);
 }
 
 /**
- * @brief Counts the number of alive neighbors for a cell
- * @param grid The full grid with ghost rows
- * @param x Row index
- * @param y Column index
- * @param rows Local rows
- * @param cols Columns
- * @return Number of alive neighbors
+ * @brief Runs the simulation on the local tile with grid backend G
+ *
+ * The ghost frame is depth cells wide and is exchanged every depth
+ * generations. In between, each step also recomputes the part of the frame
+ * that is still valid, which shrinks by one cell per generation, so the
+ * active cells stay exact with depth times fewer messages.
+ *
+ * With overlap enabled the halos are posted first, the interior (cells that
+ * do not touch the ghost frame) is updated while they travel, and the border
+ * is updated once they arrive. The time spent waiting is compared with a
+ * blocking exchange measured before the run to report how much communication
+ * was hidden.
+ *
+ * With opt.sparse only the blocks that can change are updated and unchanged
+ * edges travel as empty messages (see life_sparse.hpp).
+ *
+ * With opt.rebalance_every each process times its cell updates, and every M
+ * generations the tile boundaries follow the measured speeds (see
+ * life_balance.hpp). This happens right before a halo exchange, so the new
+ * grids only need their active cells.
+ * @param start_tile Initial tile of the decomposition
+ * @param pool Threads updating the tile
+ * @param opt Command line options
+ * @param depth Halo depth
+ * @param seed Seed of the random initial board
+ * @param board Loaded initial board, or nullptr for a random one
+ * @param output Render (unless benchmarking) and write the requested snapshots and checkpoints
+ * @return Timings of this process
  */
-int countAliveNeighbors(const Grid &grid, int x, int y, int rows, int cols) {
-    int count = 0;
-    for (int dx = -1; dx <= 1; ++dx)
-        for (int dy = -1; dy <= 1; ++dy) {
-            if (dx == 0 && dy == 0) continue;
-            int nx = x + dx;
-            int ny = (y + dy + cols) % cols;
-            if (nx >= 0 && nx < rows + 2 && grid[nx][ny] == 1)
-                ++count;
+template <typename G>
+RunStats simulate(const Tile &start_tile, ThreadPool &pool, const Options &opt, int depth, unsigned seed,
+                  const LocalBoard *board, bool output) {
+    const int h = depth;
+    Tile tile = start_tile;
+    int rows = tile.local_rows, cols = tile.local_cols;
+    G current = makeGrid<G>(pool, rows, cols, h);
+    G next = makeGrid<G>(pool, rows, cols, h);
+    if (board) {
+        applyBoard(*board, current);
+    } else {
+        srand(seed);
+        initGrid(current);
+    }
+
+    std::unique_ptr<HaloExchange<G>> halo(new HaloExchange<G>(tile, current, next, opt.shm));
+    ActivityMap activity(rows, cols, h);
+    std::vector<int> blocks;
+    RunStats stats;
+    if (opt.sparse)
+        stats.blocks = stats.halos = 0;
+
+    // Reference cost of a blocking exchange, before the generations start
+    const int probes = 5;
+    MPI_Barrier(tile.comm);
+    double t_probe = MPI_Wtime();
+    for (int k = 0; k < probes; ++k)
+        halo->exchange(current);
+    stats.blocking = (MPI_Wtime() - t_probe) / probes / depth;
+
+    // Tiles keep enough cells to fill a neighbor's frame and to write whole bytes
+    const int min_rows = depth;
+    const int min_cols = std::max(depth, tile.dims[1] > 1 && (opt.snapshot_every > 0 || opt.checkpoint_every > 0) ? 8 : 1);
+    double busy = 0, first_imbalance = -1;
+    int busy_gens = 0;
+
+    MPI_Barrier(tile.comm);
+    double t_run = MPI_Wtime();
+    stats.gen_times.assign(opt.gens, 0);
+    for (int gen = 0; gen < opt.gens; ++gen) {
+        double t_gen = MPI_Wtime();
+        double exposed_before = stats.exposed;
+
+        if (opt.rebalance_every > 0 && gen > 0 && gen % opt.rebalance_every == 0 && gen % depth == 0) {
+            Rebalance plan = planRebalance(tile, busy / busy_gens, min_rows, min_cols);
+            if (first_imbalance < 0)
+                first_imbalance = plan.before;
+            if (plan.moved) {
+                Tile moved = tile;
+                setBounds(moved, plan.row_bounds, plan.col_bounds);
+                G fresh = makeGrid<G>(pool, moved.local_rows, moved.local_cols, h);
+                migrateCells(current, tile, fresh, moved);
+
+                halo.reset();
+                tile = moved;
+                rows = tile.local_rows;
+                cols = tile.local_cols;
+                current = std::move(fresh);
+                next = makeGrid<G>(pool, rows, cols, h);
+                halo.reset(new HaloExchange<G>(tile, current, next, opt.shm));
+                activity = ActivityMap(rows, cols, h);
+            }
+            if (output && tile.rank == 0) {
+                printf("Rebalanceo (generación %ld): desequilibrio %.1f%% -> %.1f%% estimado", opt.start_gen + gen,
+                       100 * plan.before, 100 * plan.after);
+                if (plan.moved) {
+                    printf(", filas");
+                    for (int b : tile.row_bounds) printf(" %d", b);
+                    printf(", columnas");
+                    for (int b : tile.col_bounds) printf(" %d", b);
+                }
+                printf("\n");
+            }
+            busy = 0;
+            busy_gens = 0;
+        }
+
+        // Cells of the frame still valid after this step
+        int e = depth - 1 - gen % depth;
+        int r0 = h - e, r1 = h + rows + e, c0 = h - e, c1 = h + cols + e;
+
+        if (opt.sparse) {
+            bool edges[8], ghosts[8];
+            int sent = 0, updated = 0;
+            for (int d = 0; d < 8; ++d)
+                sent += edges[d] = activity.edgeChanged(d);
+
+            double t0 = MPI_Wtime();
+            halo->startSparse(current, edges);
+            double t1 = MPI_Wtime();
+            if (opt.overlap) {
+                activity.collect(true, false, blocks);
+                updateBlocks(pool, current, next, activity, blocks);
+                updated += static_cast<int>(blocks.size());
+            }
+            double t2 = MPI_Wtime();
+            halo->finishSparse(current, ghosts);
+            double t3 = MPI_Wtime();
+            activity.setGhostChanged(ghosts);
+            activity.collect(!opt.overlap, true, blocks);
+            updateBlocks(pool, current, next, activity, blocks);
+            updated += static_cast<int>(blocks.size());
+            activity.advance();
+
+            stats.exposed += (t1 - t0) + (t3 - t2);
+            stats.interior += t2 - t1;
+            stats.blocks += static_cast<double>(updated) / activity.blocks();
+            stats.halos += sent / 8.0;
+        } else if (gen % depth != 0) {
+            updateGridParallel(pool, current, next, r0, r1, c0, c1);
+        } else if (opt.overlap) {
+            double t0 = MPI_Wtime();
+            halo->start(current);
+            double t1 = MPI_Wtime();
+            updateGridParallel(pool, current, next, h + 1, h + rows - 1, h + 1, h + cols - 1);
+            double t2 = MPI_Wtime();
+            halo->finish(current);
+            double t3 = MPI_Wtime();
+            updateBorder(pool, current, next, r0, r1, c0, c1, depth);
+
+            stats.exposed += (t1 - t0) + (t3 - t2);
+            stats.interior += t2 - t1;
+        } else {
+            double t0 = MPI_Wtime();
+            halo->exchange(current);
+            stats.exposed += MPI_Wtime() - t0;
+            updateGridParallel(pool, current, next, r0, r1, c0, c1);
         }
-    return count;
+        current.swap(next);
+        stats.gen_times[gen] = MPI_Wtime() - t_gen;
+        busy += stats.gen_times[gen] - (stats.exposed - exposed_before);
+        ++busy_gens;
+
+        const long generation = opt.start_gen + gen + 1;
+        if (output && opt.snapshot_every > 0 && (gen + 1) % opt.snapshot_every == 0) {
+            double t0 = MPI_Wtime();
+            char path[64];
+            snprintf(path, sizeof(path), "life_%06ld.pbm", generation);
+            if (!writePBM(current, tile, path, "generation " + std::to_string(generation)) && tile.rank == 0)
+                std::cerr << "[!] Error: no se pudo escribir " << path << "\n";
+            stats.snapshots += MPI_Wtime() - t0;
+        }
+        if (output && opt.checkpoint_every > 0 && (gen + 1) % opt.checkpoint_every == 0) {
+            double t0 = MPI_Wtime();
+            char path[64];
+            snprintf(path, sizeof(path), "life_%06ld.ckpt", generation);
+            if (!writeCheckpoint(current, tile, path, generation) && tile.rank == 0)
+                std::cerr << "[!] Error: no se pudo escribir " << path << "\n";
+            stats.snapshots += MPI_Wtime() - t0;
+        }
+
+        if (output && !opt.bench) {
+            printFullGrid(current, tile);
+            if (tile.rank == 0)
+                std::cout << "\nGeneraci\u00f3n: " << opt.start_gen + gen << std::endl;
+
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+
+            // Rank 0 renders while the others wait: realign them so the timings
+            // measure the exchange and not the rendering skew
+            MPI_Barrier(tile.comm);
+        }
+    }
+    MPI_Barrier(tile.comm);
+    stats.total = MPI_Wtime() - t_run - stats.snapshots;
+    stats.shared = halo->sharedNeighbors();
+
+    if (opt.rebalance_every > 0 && first_imbalance >= 0) {
+        double last = imbalance(gatherTimes(tile, busy / std::max(busy_gens, 1)));
+        if (output && tile.rank == 0)
+            printf("Desequilibrio de cómputo: %.1f%% en la primera ventana, %.1f%% en la última\n",
+                   100 * first_imbalance, 100 * last);
+    }
+
+    if (opt.gens > 0) {
+        stats.exposed /= opt.gens;
+        stats.interior /= opt.gens;
+        stats.total /= opt.gens;
+        if (opt.sparse) {
+            stats.blocks /= opt.gens;
+            stats.halos /= opt.gens;
+        }
+    }
+    return stats;
 }
 
 /**
- * @brief Applies Conway's rules to update the grid
- * @param current The current grid
- * @param next The updated grid
- * @param local_rows Number of local rows
- * @param cols Number of columns
+ * @brief Reduces run timings to the worst process on rank 0
+ * @param stats Local timings
+ * @param comm Communicator
+ * @return Worst timings (meaningful on rank 0 only)
  */
-void updateGrid(const Grid &current, Grid &next, int local_rows, int cols) {
-    for (int i = 1; i <= local_rows; ++i)
-        for (int j = 0; j < cols; ++j) {
-            int alive = countAliveNeighbors(current, i, j, local_rows, cols);
-            next[i][j] = (current[i][j] == 1) ?
-                ((alive == 2 || alive == 3) ? 1 : 0) :
-                ((alive == 3) ? 1 : 0);
+RunStats worstStats(const RunStats &stats, MPI_Comm comm) {
+    double local[8] = {stats.blocking, stats.exposed, stats.interior, stats.total, stats.snapshots, stats.blocks,
+                       stats.halos, stats.shared};
+    double worst[8];
+    MPI_Reduce(local, worst, 8, MPI_DOUBLE, MPI_MAX, 0, comm);
+
+    RunStats result{worst[0], worst[1], worst[2], worst[3], worst[4], worst[5], worst[6], worst[7],
+                    std::vector<double>(stats.gen_times.size())};
+    MPI_Reduce(stats.gen_times.data(), result.gen_times.data(), static_cast<int>(stats.gen_times.size()),
+               MPI_DOUBLE, MPI_MAX, 0, comm);
+    return result;
+}
+
+/**
+ * @brief Prints the cells updated per second, per generation and overall
+ * @param tile Local tile of the decomposition
+ * @param pool Threads updating the tile
+ * @param opt Command line options
+ * @param worst Worst timings over all processes
+ */
+void printBenchmark(const Tile &tile, const ThreadPool &pool, const Options &opt, const RunStats &worst) {
+    const double cells = static_cast<double>(tile.rows) * tile.cols;
+    std::cout << "--- Benchmark: " << tile.rows << "x" << tile.cols << ", motor " << opt.engine << ", "
+              << tile.dims[0] << "x" << tile.dims[1] << " procesos x " << pool.size() << " hilos ---\n"
+              << "Generación        ms     Mceldas/s\n";
+    double fastest = 0, slowest = 0;
+    for (size_t g = 0; g < worst.gen_times.size(); ++g) {
+        double t = worst.gen_times[g];
+        double rate = t > 0 ? cells / t : 0;
+        printf("%10zu %9.3f %13.1f\n", g + 1, t * 1e3, rate / 1e6);
+        if (g == 0 || rate > fastest) fastest = rate;
+        if (g == 0 || rate < slowest) slowest = rate;
+    }
+    double wall = worst.total * opt.gens;
+    std::cout << "\nTiempo total       : " << wall << " s\n"
+              << "Celdas/s (total)   : " << (wall > 0 ? cells * opt.gens / wall : 0) << "\n"
+              << "Celdas/s (min/max) : " << slowest << " / " << fastest << "\n";
+    if (opt.snapshot_every > 0)
+        std::cout << "Snapshots          : " << opt.gens / opt.snapshot_every << " en " << worst.snapshots << " s\n";
+}
+
+/**
+ * @brief Runs the simulation, then reports the benchmark and the communication cost
+ * @param tile Local tile of the decomposition
+ * @param pool Threads updating the tile
+ * @param opt Command line options
+ * @param seed Seed of the random initial board
+ * @param board Loaded initial board, or nullptr for a random one
+ */
+template <typename G>
+void runLife(const Tile &tile, ThreadPool &pool, const Options &opt, unsigned seed, const LocalBoard *board) {
+    RunStats worst = worstStats(simulate<G>(tile, pool, opt, opt.halo_depth, seed, board, true), tile.comm);
+    if (tile.rank == 0 && opt.bench)
+        printBenchmark(tile, pool, opt, worst);
+    if (tile.rank == 0) {
+        double hidden = std::max(0.0, worst.blocking - worst.exposed);
+        std::cout << "\n--- Comunicación por generación (peor proceso) ---\n"
+                  << "Profundidad de halo    : " << opt.halo_depth << "\n"
+                  << "Hilos por proceso      : " << pool.size() << "\n"
+                  << "Intercambio bloqueante : " << worst.blocking * 1e3 << " ms\n"
+                  << "Espera expuesta        : " << worst.exposed * 1e3 << " ms\n";
+        if (opt.overlap)
+            std::cout << "Cómputo interior       : " << worst.interior * 1e3 << " ms\n"
+                      << "Comunicación oculta    : " << hidden * 1e3 << " ms ("
+                      << (worst.blocking > 0 ? 100.0 * hidden / worst.blocking : 0) << "%)\n";
+        if (opt.sparse)
+            std::cout << "Bloques actualizados   : " << 100 * worst.blocks << "%\n"
+                      << "Halos con celdas       : " << 100 * worst.halos << "%\n";
+        if (opt.shm)
+            std::cout << "Vecinos en shm         : " << worst.shared << " de 8 (máximo por proceso)\n";
+    }
+}
+
+/**
+ * @brief Times the run for every halo depth up to opt.halo_sweep and reports the best
+ *
+ * Every depth starts from the same board and runs without rendering. The
+ * redundant work is the share of extra cells computed in the ghost frame.
+ * @param tile Local tile of the decomposition
+ * @param pool Threads updating the tile
+ * @param opt Command line options
+ * @param max_depth Largest depth allowed by the smallest tile
+ * @param seed Seed of the random initial board
+ * @param board Loaded initial board, or nullptr for a random one
+ */
+template <typename G>
+void sweepHaloDepth(const Tile &tile, ThreadPool &pool, const Options &opt, int max_depth, unsigned seed,
+                    const LocalBoard *board) {
+    if (tile.rank == 0)
+        std::cout << "--- Barrido de profundidad de halo: " << opt.rows << "x" << opt.cols << ", "
+                  << opt.gens << " generaciones, " << tile.dims[0] << "x" << tile.dims[1] << " procesos ---\n"
+                  << " k   ms/gen   espera ms/gen   mensajes/gen   cómputo extra\n";
+
+    int best_depth = 1;
+    double best_time = -1;
+    for (int k = 1; k <= std::min(opt.halo_sweep, max_depth); ++k) {
+        RunStats worst = worstStats(simulate<G>(tile, pool, opt, k, seed, board, false), tile.comm);
+        if (tile.rank == 0) {
+            double computed = 0;
+            for (int s = 0; s < k; ++s)
+                computed += static_cast<double>(tile.local_rows + 2 * s) * (tile.local_cols + 2 * s);
+            double extra = computed / (static_cast<double>(k) * tile.local_rows * tile.local_cols) - 1;
+            printf("%2d %8.3f %15.3f %14.2f %13.1f%%\n", k, worst.total * 1e3, worst.exposed * 1e3, 8.0 / k, 100 * extra);
+            if (best_time < 0 || worst.total < best_time) {
+                best_time = worst.total;
+                best_depth = k;
+            }
         }
+    }
+    if (tile.rank == 0)
+        std::cout << "Mejor profundidad: k = " << best_depth << " (" << best_time * 1e3 << " ms/gen)\n";
 }
 
 /**
- * @brief Gathers and prints the full grid from all processes
- * @param local_grid Local grid (with ghost rows)
- * @param local_rows Number of active local rows
- * @param cols Number of columns
- * @param rank Rank of the current process
- * @param size Total number of processes
- * @param comm MPI communicator
+ * @brief Runs the simulation with the distributed HashLife engine (life_hashlife.hpp)
+ *
+ * The board jumps 2^k generations at a time; a jump is shortened when needed
+ * to land exactly on every snapshot, checkpoint and the last generation. The
+ * tiles only hold the board to build it and to render or write it.
+ * @param tile Local tile of the decomposition
+ * @param opt Command line options
+ * @param seed Seed of the random initial board
+ * @param board Loaded initial board, or nullptr for a random one
  */
-void printFullGrid(const Grid &local_grid, int local_rows, int cols, int rank, int size, MPI_Comm comm) {
+void runHashLife(const Tile &tile, const Options &opt, unsigned seed, const LocalBoard *board) {
+    Grid grid(tile.local_rows, tile.local_cols, 1);
+    if (board) {
+        applyBoard(*board, grid);
+    } else {
+        srand(seed);
+        initGrid(grid);
+    }
+
+    HashLife life(tile, static_cast<size_t>(opt.hash_memory) << 20);
+    const int max_step = opt.hash_step >= 0 ? opt.hash_step : life.level() - 1;
+    double t_out = 0;
+    long jumps = 0;
+    bool warned = false;
+
+    MPI_Barrier(tile.comm);
+    double t_run = MPI_Wtime();
+    life.load(grid);
+    for (long gen = 0; gen < opt.gens;) {
+        long stop = opt.gens;
+        if (opt.snapshot_every > 0)
+            stop = std::min(stop, (gen / opt.snapshot_every + 1) * opt.snapshot_every);
+        if (opt.checkpoint_every > 0)
+            stop = std::min(stop, (gen / opt.checkpoint_every + 1) * opt.checkpoint_every);
+        int step = max_step;
+        while ((1L << step) > stop - gen)
+            --step;
+
+        if (life.overCapacity()) {
+            life.collect();
+            if (!warned && life.overCapacity() && tile.rank == 0) {
+                std::cerr << "[!] Aviso: el tablero no entra en --hash-memory " << opt.hash_memory
+                          << " MB aun después de recolectar.\n";
+                warned = true;
+            }
+        }
+        life.step(step);
+        gen += 1L << step;
+        ++jumps;
+
+        const long generation = opt.start_gen + gen;
+        const bool snapshot = opt.snapshot_every > 0 && gen % opt.snapshot_every == 0;
+        const bool checkpoint = opt.checkpoint_every > 0 && gen % opt.checkpoint_every == 0;
+        if (snapshot || checkpoint || !opt.bench) {
+            double t0 = MPI_Wtime();
+            life.store(grid);
+            char path[64];
+            if (snapshot) {
+                snprintf(path, sizeof(path), "life_%06ld.pbm", generation);
+                if (!writePBM(grid, tile, path, "generation " + std::to_string(generation)) && tile.rank == 0)
+                    std::cerr << "[!] Error: no se pudo escribir " << path << "\n";
+            }
+            if (checkpoint) {
+                snprintf(path, sizeof(path), "life_%06ld.ckpt", generation);
+                if (!writeCheckpoint(grid, tile, path, generation) && tile.rank == 0)
+                    std::cerr << "[!] Error: no se pudo escribir " << path << "\n";
+            }
+            if (!opt.bench) {
+                printFullGrid(grid, tile);
+                if (tile.rank == 0)
+                    std::cout << "\nGeneraci\u00f3n: " << generation << std::endl;
+                std::this_thread::sleep_for(std::chrono::seconds(2));
+                MPI_Barrier(tile.comm);
+            }
+            t_out += MPI_Wtime() - t0;
+        }
+    }
+    MPI_Barrier(tile.comm);
+    double total = MPI_Wtime() - t_run - t_out;
+
+    life.store(grid);
+    long long alive = 0, population = 0;
+    for (int i = 0; i < tile.local_rows; ++i)
+        for (int j = 0; j < tile.local_cols; ++j)
+            alive += grid.get(1 + i, 1 + j);
+    MPI_Reduce(&alive, &population, 1, MPI_LONG_LONG, MPI_SUM, 0, tile.comm);
+
+    long local[3] = {static_cast<long>(life.nodes()), life.memoHits(), life.memoMisses()}, sum[3];
+    long most_nodes;
+    MPI_Reduce(local, sum, 3, MPI_LONG, MPI_SUM, 0, tile.comm);
+    MPI_Reduce(&local[0], &most_nodes, 1, MPI_LONG, MPI_MAX, 0, tile.comm);
+
+    if (tile.rank == 0) {
+        const double cells = static_cast<double>(tile.rows) * tile.cols;
+        std::cout << "--- HashLife: " << tile.rows << "x" << tile.cols << ", " << tile.size << " procesos ---\n"
+                  << "Generaciones       : " << opt.gens << " en " << jumps << " saltos (hasta 2^" << max_step << ")\n"
+                  << "Tiempo total       : " << total << " s\n"
+                  << "Generaciones/s     : " << (total > 0 ? opt.gens / total : 0) << "\n"
+                  << "Celdas/s (equiv.)  : " << (total > 0 ? cells * opt.gens / total : 0) << "\n"
+                  << "Nodos              : " << sum[0] << " (máx. " << most_nodes << " por proceso, límite "
+                  << life.capacity() << ")\n"
+                  << "Resultados memo.   : " << (sum[1] + sum[2] > 0 ? 100.0 * sum[1] / (sum[1] + sum[2]) : 0) << "%\n"
+                  << "Recolecciones      : " << life.collections() << "\n"
+                  << "Población final    : " << population << "\n";
+        if (opt.snapshot_every > 0)
+            std::cout << "Snapshots          : " << opt.gens / opt.snapshot_every << " en " << t_out << " s\n";
+    }
+}
+
+/**
+ * @brief Runs the boards of a batch file over every process and thread
+ *
+ * Rank 0 reads the batch and broadcasts it; every process then takes boards
+ * from the shared work queue until none are left (see life_ensemble.hpp).
+ * @param opt Command line options
+ * @return false if the batch or the results file cannot be used (reported by rank 0)
+ */
+bool runBatch(const Options &opt) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    std::string text;
+    long length = -1;
     if (rank == 0) {
-        Grid full_grid(size * local_rows, std::vector<int>(cols));
-        for (int i = 0; i < local_rows; ++i)
-            full_grid[i] = local_grid[i + 1];
-        for (int src = 1; src < size; ++src)
-            for (int i = 0; i < local_rows; ++i)
-                MPI_Recv(&full_grid[src * local_rows + i][0], cols, MPI_INT, src, 0, comm, MPI_STATUS_IGNORE);
+        std::ifstream in(opt.ensemble);
+        if (in) {
+            std::ostringstream contents;
+            contents << in.rdbuf();
+            text = contents.str();
+            length = static_cast<long>(text.size());
+        }
+    }
+    MPI_Bcast(&length, 1, MPI_LONG, 0, MPI_COMM_WORLD);
+    if (length < 0) {
+        if (rank == 0)
+            std::cerr << "[!] Error: no se pudo leer '" << opt.ensemble << "'.\n";
+        return false;
+    }
+    text.resize(length);
+    MPI_Bcast(&text[0], static_cast<int>(length), MPI_CHAR, 0, MPI_COMM_WORLD);
 
-        system("clear");
-        for (const auto &row : full_grid)
-            for (int j = 0; j < cols; ++j)
-                std::cout << (row[j] ? PURPLE + "█" + RESET : WHITE + " " + RESET), j == cols - 1 ? std::cout << "\n" : std::cout << "";
-    } else {
-        for (int i = 1; i <= local_rows; ++i)
-            MPI_Send(&local_grid[i][0], cols, MPI_INT, 0, 0, comm);
+    std::vector<EnsembleJob> jobs;
+    std::string error;
+    if (!parseBatch(text, jobs, error)) {
+        if (rank == 0)
+            std::cerr << "[!] Error: '" << opt.ensemble << "' " << error << ".\n";
+        return false;
+    }
+
+    ThreadPool pool(opt.threads);
+    EnsembleStats stats;
+    MPI_Barrier(MPI_COMM_WORLD);
+    double t0 = MPI_Wtime();
+    if (!runEnsemble(MPI_COMM_WORLD, pool, jobs, opt.ensemble_out, stats)) {
+        if (rank == 0)
+            std::cerr << "[!] Error: no se pudo crear '" << opt.ensemble_out << "'.\n";
+        return false;
     }
+    double local[6] = {static_cast<double>(stats.boards), static_cast<double>(stats.periodic),
+                       static_cast<double>(stats.extinct), stats.cells, stats.busy, MPI_Wtime() - t0};
+    double sum[6], most[6], fewest;
+    MPI_Reduce(local, sum, 6, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(local, most, 6, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(local, &fewest, 1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        double wall = most[5];
+        double cores = static_cast<double>(size) * pool.size();
+        std::cout << "--- Ensemble: " << jobs.size() << " tableros, " << size << " procesos x " << pool.size()
+                  << " hilos ---\n"
+                  << "Tiempo total       : " << wall << " s\n"
+                  << "Tableros/s         : " << (wall > 0 ? sum[0] / wall : 0) << "\n"
+                  << "Celdas/s           : " << (wall > 0 ? sum[3] / wall : 0) << "\n"
+                  << "Ocupación hilos    : " << (wall > 0 ? 100 * sum[4] / (wall * cores) : 0) << "%\n"
+                  << "Tableros/proceso   : " << fewest << " a " << most[0] << "\n"
+                  << "Con ciclo          : " << sum[1] << " (extinguidos: " << sum[2] << ")\n"
+                  << "Resultados         : " << opt.ensemble_out << "\n";
+    }
+    return true;
 }
 
 /**
  * @brief Main function
  */
 int main(int argc, char** argv) {
-    int cols = 40, rows = 40, gens = 10;
-    MPI_Init(&argc, &argv);
+    Options opt;
+
+    // Only the main thread calls MPI; the pool threads just update cells
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
 
     int rank, size;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
@@ -119,51 +710,179 @@ int main(int argc, char** argv) {
     // Read optional arguments
     for (int i = 1; i < argc; ++i) {
         if (std::string(argv[i]) == "-c" && i + 1 < argc)
-            cols = std::atoi(argv[++i]);
+            opt.cols = std::atoi(argv[++i]);
         else if (std::string(argv[i]) == "-f" && i + 1 < argc)
-            rows = std::atoi(argv[++i]);
+            opt.rows = std::atoi(argv[++i]);
         else if (std::string(argv[i]) == "-g" && i + 1 < argc)
-            gens = std::atoi(argv[++i]);
+            opt.gens = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--engine" && i + 1 < argc)
+            opt.engine = argv[++i];
+        else if (std::string(argv[i]) == "--no-overlap")
+            opt.overlap = false;
+        else if (std::string(argv[i]) == "--halo-depth" && i + 1 < argc)
+            opt.halo_depth = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--halo-sweep" && i + 1 < argc)
+            opt.halo_sweep = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--threads" && i + 1 < argc)
+            opt.threads = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--bench")
+            opt.bench = true;
+        else if (std::string(argv[i]) == "--snapshot-every" && i + 1 < argc)
+            opt.snapshot_every = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--seed" && i + 1 < argc)
+            opt.seed = std::atol(argv[++i]);
+        else if (std::string(argv[i]) == "--sparse")
+            opt.sparse = true;
+        else if (std::string(argv[i]) == "--load" && i + 1 < argc)
+            opt.load = argv[++i];
+        else if (std::string(argv[i]) == "--restart" && i + 1 < argc)
+            opt.restart = argv[++i];
+        else if (std::string(argv[i]) == "--checkpoint-every" && i + 1 < argc)
+            opt.checkpoint_every = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--rebalance-every" && i + 1 < argc)
+            opt.rebalance_every = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--hash-step" && i + 1 < argc)
+            opt.hash_step = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--hash-memory" && i + 1 < argc)
+            opt.hash_memory = std::atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--shm")
+            opt.shm = true;
+        else if (std::string(argv[i]) == "--ensemble" && i + 1 < argc)
+            opt.ensemble = argv[++i];
+        else if (std::string(argv[i]) == "--ensemble-out" && i + 1 < argc)
+            opt.ensemble_out = argv[++i];
+    }
+
+    if (!opt.load.empty() && !opt.restart.empty()) {
+        if (rank == 0)
+            std::cerr << "[!] Error: use --load o --restart, no ambos.\n";
+        MPI_Finalize();
+        return 1;
     }
 
-    if (rows % size != 0) {
+    // The checkpoint fixes the board size before the decomposition
+    if (!opt.restart.empty() &&
+        !readCheckpointHeader(MPI_COMM_WORLD, opt.restart, opt.rows, opt.cols, opt.start_gen)) {
         if (rank == 0)
-            std::cerr << "[!] Error: filas no divisible por cantidad de procesos.\n";
+            std::cerr << "[!] Error: '" << opt.restart << "' no es un checkpoint válido.\n";
         MPI_Finalize();
         return 1;
     }
 
-    int local_rows = rows / size;
-    Grid current(local_rows + 2, std::vector<int>(cols));
-    Grid next(local_rows + 2, std::vector<int>(cols));
-    srand(time(NULL) + rank * 100);
+    if (opt.threads < 1 || (opt.threads > 1 && provided < MPI_THREAD_FUNNELED)) {
+        if (rank == 0)
+            std::cerr << "[!] Error: --threads requiere N >= 1 y una biblioteca MPI con MPI_THREAD_FUNNELED.\n";
+        MPI_Finalize();
+        return 1;
+    }
 
-    initGrid(current, local_rows, cols);
+    // Independent boards need no decomposition
+    if (!opt.ensemble.empty()) {
+        bool ok = runBatch(opt);
+        MPI_Finalize();
+        return ok ? 0 : 1;
+    }
 
-    for (int gen = 0; gen < gens; ++gen) {
-        int up = (rank == 0) ? MPI_PROC_NULL : rank - 1;
-        int down = (rank == size - 1) ? MPI_PROC_NULL : rank + 1;
+    if (opt.engine != "int" && opt.engine != "bitpacked" && opt.engine != "hashlife") {
+        if (rank == 0)
+            std::cerr << "[!] Error: motor desconocido '" << opt.engine << "' (use int, bitpacked o hashlife).\n";
+        MPI_Finalize();
+        return 1;
+    }
 
-        // Send top row up, receive from below
-        MPI_Sendrecv(&current[1][0], cols, MPI_INT, up, 0,
-                     &current[local_rows + 1][0], cols, MPI_INT, down, 0,
-                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    // HashLife splits the board in power-of-two quadrants and has no halos or threads
+    if (opt.engine == "hashlife") {
+        auto power_of_two = [](int n) { return n >= 8 && (n & (n - 1)) == 0; };
+        int level = 0;
+        while ((1 << level) < std::max(opt.rows, opt.cols))
+            ++level;
+        const char *problem = nullptr;
+        if (!power_of_two(opt.rows) || !power_of_two(opt.cols))
+            problem = "requiere filas y columnas potencia de 2 (al menos 8)";
+        else if (opt.sparse || opt.halo_depth != 1 || opt.halo_sweep > 0 || opt.threads > 1 || opt.rebalance_every > 0 ||
+                 opt.shm)
+            problem = "no admite --sparse, --halo-depth, --halo-sweep, --threads, --rebalance-every ni --shm";
+        else if (opt.hash_step < -1 || opt.hash_step > level - 1 || opt.hash_memory < 1)
+            problem = "requiere --hash-memory >= 1 y --hash-step entre 0 y log2(lado) - 1";
+        if (problem) {
+            if (rank == 0)
+                std::cerr << "[!] Error: --engine hashlife " << problem << ".\n";
+            MPI_Finalize();
+            return 1;
+        }
+    }
 
-        // Send bottom row down, receive from above
-        MPI_Sendrecv(&current[local_rows][0], cols, MPI_INT, down, 1,
-                     &current[0][0], cols, MPI_INT, up, 1,
-                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    int dims[2];
+    if (!chooseProcessGrid(size, opt.rows, opt.cols, dims)) {
+        if (rank == 0)
+            std::cerr << "[!] Error: tablero de " << opt.rows << "x" << opt.cols << " demasiado chico para " << size << " procesos.\n";
+        MPI_Finalize();
+        return 1;
+    }
 
-        updateGrid(current, next, local_rows, cols);
-        current.swap(next);
+    // A neighbor must own at least depth rows and columns to fill the frame
+    int max_depth = std::min(opt.rows / dims[0], opt.cols / dims[1]);
+    if (opt.halo_depth < 1 || opt.halo_depth > max_depth) {
+        if (rank == 0)
+            std::cerr << "[!] Error: la profundidad de halo debe estar entre 1 y " << max_depth << ".\n";
+        MPI_Finalize();
+        return 1;
+    }
 
-        printFullGrid(current, local_rows, cols, rank, size, MPI_COMM_WORLD);
+    // Skipped halos reuse the ghost cells of the previous generation
+    if (opt.sparse && (opt.halo_depth != 1 || opt.halo_sweep > 0)) {
         if (rank == 0)
-            std::cout << "\nGeneraci\u00f3n: " << gen << std::endl;
+            std::cerr << "[!] Error: --sparse requiere --halo-depth 1 y no admite --halo-sweep.\n";
+        MPI_Finalize();
+        return 1;
+    }
+
+    Tile tile = makeTile(MPI_COMM_WORLD, opt.rows, opt.cols, dims);
+    unsigned seed = (opt.seed >= 0 ? opt.seed : time(NULL)) + tile.rank * 100;
+
+    if ((opt.snapshot_every > 0 || opt.checkpoint_every > 0) && !pbmTilesSupported(tile)) {
+        if (tile.rank == 0)
+            std::cerr << "[!] Error: los snapshots y checkpoints requieren bloques de al menos 8 columnas.\n";
+        MPI_Comm_free(&tile.comm);
+        MPI_Finalize();
+        return 1;
+    }
 
-        std::this_thread::sleep_for(std::chrono::seconds(2));
+    LocalBoard board;
+    const LocalBoard *initial = nullptr;
+    std::string error;
+    if (!opt.load.empty() && !loadPattern(tile, opt.load, board, error)) {
+        if (tile.rank == 0)
+            std::cerr << "[!] Error: no se pudo cargar '" << opt.load << "': " << error << ".\n";
+        MPI_Comm_free(&tile.comm);
+        MPI_Finalize();
+        return 1;
+    }
+    if (!opt.restart.empty() && !readCheckpoint(tile, opt.restart, board)) {
+        if (tile.rank == 0)
+            std::cerr << "[!] Error: no se pudo leer '" << opt.restart << "'.\n";
+        MPI_Comm_free(&tile.comm);
+        MPI_Finalize();
+        return 1;
+    }
+    if (!opt.load.empty() || !opt.restart.empty())
+        initial = &board;
+
+    bool bitpacked = (opt.engine == "bitpacked");
+    if (opt.engine == "hashlife") {
+        runHashLife(tile, opt, seed, initial);
+    } else {
+        ThreadPool pool(opt.threads);
+        if (opt.halo_sweep > 0) {
+            if (bitpacked) sweepHaloDepth<BitGrid>(tile, pool, opt, max_depth, seed, initial);
+            else           sweepHaloDepth<Grid>(tile, pool, opt, max_depth, seed, initial);
+        } else {
+            if (bitpacked) runLife<BitGrid>(tile, pool, opt, seed, initial);
+            else           runLife<Grid>(tile, pool, opt, seed, initial);
+        }
     }
 
+    MPI_Comm_free(&tile.comm);
     MPI_Finalize();
     return 0;
 }
@@ -0,0 +1,267 @@
+/**
+ * @file escape_time.hpp
+ * @brief Mandelbrot / Julia escape-time renderer with dynamic tile scheduling
+ *
+ * The cost of a pixel is the number of iterations before its orbit escapes,
+ * which ranges from one to the iteration limit inside the set. A static split
+ * of the rows leaves the ranks that got the outside of the set idle, so the
+ * image is cut into strips of rows handed out on demand: a counter on rank 0,
+ * advanced with MPI_Fetch_and_op, gives every rank its next strip as soon as
+ * it finishes the previous one. Strips start large and shrink towards the
+ * end (guided scheduling), so the last ones are small enough to even out the
+ * finishing times without paying one remote atomic per row.
+ *
+ * The kernel iterates groups of ESCAPE_VECS x ESCAPE_LANES pixels of a row
+ * together in double precision, as GCC vector types that map to NEON / SSE /
+ * AVX registers. Escaped lanes are frozen with selects instead of branches
+ * and the group only stops when every lane escaped.
+ */
+
+#ifndef ESCAPE_TIME_HPP
+#define ESCAPE_TIME_HPP
+
+#include <mpi.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/// Pixels iterated together by the kernel, one double per SIMD lane
+#if defined(__AVX512F__)
+constexpr int ESCAPE_LANES = 8;
+#elif defined(__AVX__)
+constexpr int ESCAPE_LANES = 4;
+#else
+constexpr int ESCAPE_LANES = 2;
+#endif
+
+/// SIMD vector of ESCAPE_LANES doubles (NEON / SSE2 / AVX depending on target)
+typedef double EscapeVec __attribute__((vector_size(8 * ESCAPE_LANES)));
+/// Lane mask produced by comparing two EscapeVec
+typedef int64_t EscapeMask __attribute__((vector_size(8 * ESCAPE_LANES)));
+
+/// Independent vectors iterated together, to hide the latency of the multiply chain
+constexpr int ESCAPE_VECS = 4;
+
+/**
+ * @brief Region of the complex plane and fractal to render
+ */
+struct EscapeView {
+    bool julia = false;       ///< Julia set of julia_re + i julia_im instead of the Mandelbrot set
+    double julia_re = -0.8;   ///< Constant of the Julia set, real part
+    double julia_im = 0.156;  ///< Constant of the Julia set, imaginary part
+    double center_re = -0.5;  ///< Center of the image, real part
+    double center_im = 0.0;   ///< Center of the image, imaginary part
+    double span = 3.5;        ///< Width of the image in the complex plane
+    int max_iter = 1000;      ///< Iteration limit (pixels that reach it are in the set)
+    int width = 1920;         ///< Image width in pixels
+    int height = 1080;        ///< Image height in pixels
+};
+
+/**
+ * @brief Escape counts of one row
+ * @param v View
+ * @param row Row of the image
+ * @param iters Output, width counts (max_iter for pixels in the set)
+ */
+inline void escapeRow(const EscapeView &v, int row, int32_t *iters) {
+    const double step = v.span / v.width;
+    const double im = v.center_im - (row - v.height / 2) * step;
+    const double re0 = v.center_re - (v.width / 2) * step;
+
+    constexpr int GROUP = ESCAPE_LANES * ESCAPE_VECS;
+    EscapeVec lane;
+    for (int l = 0; l < ESCAPE_LANES; ++l)
+        lane[l] = l;
+
+    for (int x = 0; x < v.width; x += GROUP) {
+        EscapeVec zr[ESCAPE_VECS], zi[ESCAPE_VECS], cr[ESCAPE_VECS], ci[ESCAPE_VECS];
+        EscapeMask n[ESCAPE_VECS] = {};
+        for (int k = 0; k < ESCAPE_VECS; ++k) {
+            zr[k] = re0 + (x + k * ESCAPE_LANES + lane) * step;
+            zi[k] = lane * 0.0 + im;
+            cr[k] = v.julia ? zr[k] * 0.0 + v.julia_re : zr[k];
+            ci[k] = v.julia ? zi[k] * 0.0 + v.julia_im : zi[k];
+        }
+
+        for (int it = 0; it < v.max_iter; ++it) {
+            EscapeMask alive = {};
+            for (int k = 0; k < ESCAPE_VECS; ++k) {
+                EscapeVec rr = zr[k] * zr[k], ii = zi[k] * zi[k];
+                EscapeMask in = rr + ii <= 4.0;  // -1 in lanes still inside the circle
+                EscapeVec nzi = 2.0 * zr[k] * zi[k] + ci[k];
+                EscapeVec nzr = rr - ii + cr[k];
+                zr[k] = in ? nzr : zr[k];
+                zi[k] = in ? nzi : zi[k];
+                n[k] -= in;
+                alive |= in;
+            }
+            int64_t any = 0;
+            for (int l = 0; l < ESCAPE_LANES; ++l)
+                any |= alive[l];
+            if (!any)
+                break;
+        }
+
+        const int pixels = std::min(GROUP, v.width - x);
+        for (int p = 0; p < pixels; ++p)
+            iters[x + p] = static_cast<int32_t>(n[p / ESCAPE_LANES][p % ESCAPE_LANES]);
+    }
+}
+
+/**
+ * @brief Gray level of an escape count: black inside the set, logarithmic ramp outside
+ * @param n Escape count
+ * @param max_iter Iteration limit
+ */
+inline uint8_t escapeLevel(int32_t n, int max_iter) {
+    if (n >= max_iter)
+        return 0;
+    return static_cast<uint8_t>(1 + 254.0 * std::log1p(static_cast<double>(n)) / std::log1p(static_cast<double>(max_iter)));
+}
+
+/// Strip of rows handed out as one unit of work
+struct EscapeTile {
+    int row;   ///< First row
+    int rows;  ///< Number of rows
+};
+
+/**
+ * @brief Guided schedule: each strip takes 1/(2P) of the rows still unassigned
+ * @param height Image height
+ * @param size Number of ranks
+ * @param min_rows Smallest strip
+ * @return Strips covering the image, largest first
+ */
+inline std::vector<EscapeTile> guidedTiles(int height, int size, int min_rows) {
+    std::vector<EscapeTile> tiles;
+    for (int row = 0; row < height;) {
+        int rows = std::max(min_rows, (height - row) / (2 * size));
+        rows = std::min(rows, height - row);
+        tiles.push_back({row, rows});
+        row += rows;
+    }
+    return tiles;
+}
+
+/**
+ * @brief Shared counter of the next strip, kept on rank 0 and advanced with one-sided atomics
+ */
+class TileQueue {
+public:
+    /// Creates the counter (collective over comm)
+    explicit TileQueue(MPI_Comm comm) {
+        int rank;
+        MPI_Comm_rank(comm, &rank);
+        MPI_Win_allocate(rank == 0 ? sizeof(long) : 0, sizeof(long), MPI_INFO_NULL, comm, &counter_, &win_);
+        if (rank == 0)
+            *counter_ = 0;
+        MPI_Barrier(comm);
+        MPI_Win_lock_all(0, win_);
+    }
+
+    ~TileQueue() {
+        MPI_Win_unlock_all(win_);
+        MPI_Win_free(&win_);
+    }
+
+    TileQueue(const TileQueue &) = delete;
+    TileQueue &operator=(const TileQueue &) = delete;
+
+    /// Index of the next strip; past the end once the image is done
+    long next() {
+        const long one = 1;
+        long tile;
+        MPI_Fetch_and_op(&one, &tile, MPI_LONG, 0, 0, MPI_SUM, win_);
+        MPI_Win_flush(0, win_);
+        return tile;
+    }
+
+private:
+    long *counter_;
+    MPI_Win win_;
+};
+
+/// Work done by one rank
+struct EscapeStats {
+    double busy = 0;     ///< Time computing strips, in seconds
+    double wait = 0;     ///< Time asking for strips, in seconds
+    long tiles = 0;      ///< Strips rendered
+    long rows = 0;       ///< Rows rendered
+    double iters = 0;    ///< Orbit iterations computed
+};
+
+/**
+ * @brief Renders one strip into a row-major 8-bit image
+ * @param v View
+ * @param tile Strip
+ * @param image Output, width x height
+ * @param iters Scratch, width counts
+ * @return Orbit iterations computed
+ */
+inline double renderTile(const EscapeView &v, const EscapeTile &tile, uint8_t *image, int32_t *iters) {
+    double total = 0;
+    for (int y = tile.row; y < tile.row + tile.rows; ++y) {
+        escapeRow(v, y, iters);
+        uint8_t *out = image + static_cast<size_t>(y) * v.width;
+        for (int x = 0; x < v.width; ++x) {
+            out[x] = escapeLevel(iters[x], v.max_iter);
+            total += iters[x];
+        }
+    }
+    return total;
+}
+
+/**
+ * @brief Renders this rank's share of the image (collective over comm)
+ *
+ * With dynamic scheduling every rank pulls strips from the shared counter
+ * until they run out; otherwise rank r renders the r-th block of rows.
+ * Pixels the rank did not render stay zero, so the images of all ranks can
+ * be combined with a MPI_MAX reduction.
+ * @param comm Ranks taking part
+ * @param v View
+ * @param image Output, width x height, zeroed
+ * @param dynamic Dynamic (guided) scheduling instead of static blocks
+ * @param min_rows Smallest strip of the guided schedule
+ * @return Work done by this rank
+ */
+inline EscapeStats renderEscape(MPI_Comm comm, const EscapeView &v, uint8_t *image, bool dynamic, int min_rows) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    EscapeStats stats;
+    std::vector<int32_t> iters(v.width);
+
+    auto render = [&](const EscapeTile &tile) {
+        double t = MPI_Wtime();
+        stats.iters += renderTile(v, tile, image, iters.data());
+        stats.busy += MPI_Wtime() - t;
+        stats.tiles++;
+        stats.rows += tile.rows;
+    };
+
+    if (!dynamic) {
+        int first = static_cast<int>(static_cast<long>(v.height) * rank / size);
+        int last = static_cast<int>(static_cast<long>(v.height) * (rank + 1) / size);
+        if (last > first)
+            render({first, last - first});
+        return stats;
+    }
+
+    const std::vector<EscapeTile> tiles = guidedTiles(v.height, size, min_rows);
+    TileQueue queue(comm);
+    for (;;) {
+        double t = MPI_Wtime();
+        long next = queue.next();
+        stats.wait += MPI_Wtime() - t;
+        if (next >= static_cast<long>(tiles.size()))
+            break;
+        render(tiles[next]);
+    }
+    // Nobody frees the counter while another rank may still be reading it
+    MPI_Barrier(comm);
+    return stats;
+}
+
+#endif
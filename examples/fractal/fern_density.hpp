@@ -0,0 +1,163 @@
+/**
+ * @file fern_density.hpp
+ * @brief Hit-count rendering of the fern with the image split in bands
+ *
+ * Instead of every rank holding the whole image and combining them with a
+ * MPI_MAX reduction, each rank owns one horizontal band and counts how many
+ * points fall on each of its pixels. Points drawn by any rank are binned by
+ * owner and shipped in batches with MPI_Alltoallv, so a rank only stores 1/P
+ * of the counters. The counts are then tone mapped with a logarithm and a
+ * gamma curve, which shows the density of the attractor instead of a
+ * binary silhouette.
+ */
+
+#ifndef FERN_DENSITY_HPP
+#define FERN_DENSITY_HPP
+
+#include <mpi.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Band of the image owned by this rank, with its hit counters
+ */
+class DensityBands {
+public:
+    /**
+     * @brief Splits the image rows into one band per rank (collective over comm)
+     * @param comm Ranks sharing the image
+     * @param width Image width in pixels
+     * @param height Image height in pixels
+     */
+    DensityBands(MPI_Comm comm, int width, int height)
+        : comm_(comm), width_(width), height_(height) {
+        MPI_Comm_rank(comm, &rank_);
+        MPI_Comm_size(comm, &size_);
+        band_ = (height + size_ - 1) / size_;
+        hits_.assign(static_cast<size_t>(rows(rank_)) * width, 0);
+        outbox_.resize(size_);
+        send_counts_.resize(size_);
+        recv_counts_.resize(size_);
+        send_displs_.resize(size_);
+        recv_displs_.resize(size_);
+    }
+
+    /// First row of the band of a rank
+    int firstRow(int rank) const { return std::min(height_, rank * band_); }
+    /// Rows of the band of a rank (the last bands may be shorter or empty)
+    int rows(int rank) const { return firstRow(rank + 1) - firstRow(rank); }
+
+    /**
+     * @brief Bins points by owner; points of the own band are counted right away
+     * @param pixels Pixel indices (y * width + x), -1 for points outside the image
+     * @param n Number of points
+     */
+    void add(const int32_t *pixels, long n) {
+        const uint32_t first = static_cast<uint32_t>(firstRow(rank_)) * width_;
+        const int32_t row_pixels = band_ * width_;
+        for (long i = 0; i < n; ++i) {
+            if (pixels[i] < 0)
+                continue;
+            int owner = pixels[i] / row_pixels;
+            if (owner == rank_)
+                ++hits_[pixels[i] - first];
+            else
+                outbox_[owner].push_back(static_cast<uint32_t>(pixels[i]) - static_cast<uint32_t>(firstRow(owner)) * width_);
+        }
+    }
+
+    /**
+     * @brief Ships the binned points to their owners and counts the ones received (collective)
+     *
+     * Counts travel first with MPI_Alltoall, then the pixel offsets inside
+     * each band with one MPI_Alltoallv.
+     * @return Points received from other ranks
+     */
+    long exchange() {
+        for (int r = 0; r < size_; ++r)
+            send_counts_[r] = static_cast<int>(outbox_[r].size());
+        MPI_Alltoall(send_counts_.data(), 1, MPI_INT, recv_counts_.data(), 1, MPI_INT, comm_);
+
+        int sent = 0, received = 0;
+        for (int r = 0; r < size_; ++r) {
+            send_displs_[r] = sent;
+            recv_displs_[r] = received;
+            sent += send_counts_[r];
+            received += recv_counts_[r];
+        }
+        send_.resize(sent);
+        recv_.resize(received);
+        for (int r = 0; r < size_; ++r) {
+            std::copy(outbox_[r].begin(), outbox_[r].end(), send_.begin() + send_displs_[r]);
+            outbox_[r].clear();
+        }
+        MPI_Alltoallv(send_.data(), send_counts_.data(), send_displs_.data(), MPI_UINT32_T,
+                      recv_.data(), recv_counts_.data(), recv_displs_.data(), MPI_UINT32_T, comm_);
+        for (uint32_t offset : recv_)
+            ++hits_[offset];
+        return received;
+    }
+
+    /// Largest hit count over the whole image (collective)
+    uint32_t maxHits() const {
+        uint32_t local = hits_.empty() ? 0 : *std::max_element(hits_.begin(), hits_.end());
+        uint32_t global;
+        MPI_Allreduce(&local, &global, 1, MPI_UINT32_T, MPI_MAX, comm_);
+        return global;
+    }
+
+    /**
+     * @brief Tone maps the band: 255 * (log(1 + hits) / log(1 + max))^(1 / gamma)
+     * @param max_hits Largest count of the image
+     * @param gamma Gamma of the curve (> 1 brightens sparse regions)
+     * @return 8-bit pixels of the band
+     */
+    std::vector<uint8_t> toneMap(uint32_t max_hits, double gamma) const {
+        std::vector<uint8_t> out(hits_.size(), 0);
+        if (max_hits == 0)
+            return out;
+        // Few distinct counts: build the curve once per count up to a limit
+        const double norm = 1.0 / std::log1p(static_cast<double>(max_hits));
+        std::vector<uint8_t> curve(std::min<uint32_t>(max_hits, 1u << 16) + 1);
+        auto level = [&](uint32_t h) {
+            return static_cast<uint8_t>(std::lround(255.0 * std::pow(std::log1p(static_cast<double>(h)) * norm, 1.0 / gamma)));
+        };
+        for (uint32_t h = 0; h < curve.size(); ++h)
+            curve[h] = level(h);
+        for (size_t i = 0; i < hits_.size(); ++i)
+            out[i] = hits_[i] < curve.size() ? curve[hits_[i]] : level(hits_[i]);
+        return out;
+    }
+
+    /**
+     * @brief Collects the tone-mapped bands on rank 0 (collective)
+     * @param band Pixels of the own band
+     * @param image Whole image, width x height bytes (rank 0 only)
+     */
+    void gather(const std::vector<uint8_t> &band, uint8_t *image) const {
+        std::vector<int> counts(size_), displs(size_);
+        for (int r = 0; r < size_; ++r) {
+            counts[r] = rows(r) * width_;
+            displs[r] = firstRow(r) * width_;
+        }
+        MPI_Gatherv(band.data(), static_cast<int>(band.size()), MPI_UNSIGNED_CHAR, image, counts.data(),
+                    displs.data(), MPI_UNSIGNED_CHAR, 0, comm_);
+    }
+
+    /// Bytes held by the counters of this rank
+    size_t bytes() const { return hits_.size() * sizeof(uint32_t); }
+
+private:
+    MPI_Comm comm_;
+    int rank_, size_;
+    int width_, height_;
+    int band_;                              ///< Rows per band
+    std::vector<uint32_t> hits_;            ///< Hit count of every pixel of the band
+    std::vector<std::vector<uint32_t>> outbox_;  ///< Binned offsets per owner
+    std::vector<uint32_t> send_, recv_;
+    std::vector<int> send_counts_, recv_counts_, send_displs_, recv_displs_;
+};
+
+#endif
@@ -0,0 +1,157 @@
+/**
+ * @file fern_kernel.hpp
+ * @brief Vectorized chaos game for the Barnsley fern
+ *
+ * Instead of one walker drawing rand() and switching on the map every
+ * iteration, each rank advances FERN_WALKERS independent walkers stored as
+ * structure-of-arrays floats. Every walker owns a xoshiro128+ stream seeded
+ * from (seed, rank, walker), so the image only depends on the seed and the
+ * number of ranks. The map is chosen without branches: the random number is
+ * compared against the cumulative probabilities and the sum indexes small
+ * coefficient tables. The inner loop over walkers has no dependencies
+ * between lanes, so the compiler turns it into NEON / SSE / AVX code.
+ */
+
+#ifndef FERN_KERNEL_HPP
+#define FERN_KERNEL_HPP
+
+#include <cstdint>
+
+/// Walkers advanced together by each rank
+constexpr int FERN_WALKERS = 256;
+
+/// Affine maps of the fern, x' = a x + b y + e, y' = c x + d y + f
+constexpr float FERN_A[4] = {0.0f, 0.2f, -0.15f, 0.85f};
+constexpr float FERN_B[4] = {0.0f, -0.26f, 0.28f, 0.04f};
+constexpr float FERN_C[4] = {0.0f, 0.23f, 0.26f, -0.04f};
+constexpr float FERN_D[4] = {0.16f, 0.22f, 0.24f, 0.85f};
+constexpr float FERN_E[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+constexpr float FERN_F[4] = {0.0f, 1.6f, 0.44f, 1.6f};
+
+/// Cumulative probabilities of maps 0..2 (1%, 7%, 7%, the rest 85%) scaled to 2^32
+constexpr uint32_t FERN_T1 = 42949673u;
+constexpr uint32_t FERN_T2 = 343597384u;
+constexpr uint32_t FERN_T3 = 644245094u;
+
+/**
+ * @brief splitmix64 step, used to spread (seed, rank, walker) over the xoshiro state
+ * @param x State, advanced in place
+ * @return Next output
+ */
+inline uint64_t splitmix64(uint64_t &x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Walkers of one rank: positions and xoshiro128+ states, one array per field
+ */
+struct FernWalkers {
+    alignas(64) float x[FERN_WALKERS];
+    alignas(64) float y[FERN_WALKERS];
+    alignas(64) uint32_t s0[FERN_WALKERS];
+    alignas(64) uint32_t s1[FERN_WALKERS];
+    alignas(64) uint32_t s2[FERN_WALKERS];
+    alignas(64) uint32_t s3[FERN_WALKERS];
+
+    /**
+     * @brief Starts every walker at the origin with its own random stream
+     * @param seed Seed of the run
+     * @param rank Rank owning the walkers
+     */
+    FernWalkers(uint64_t seed, int rank) {
+        for (int l = 0; l < FERN_WALKERS; ++l) {
+            uint64_t sm = seed ^ (static_cast<uint64_t>(rank) << 32) ^ (static_cast<uint64_t>(l) << 16);
+            uint64_t a = splitmix64(sm), b = splitmix64(sm);
+            s0[l] = static_cast<uint32_t>(a);
+            s1[l] = static_cast<uint32_t>(a >> 32);
+            s2[l] = static_cast<uint32_t>(b);
+            s3[l] = static_cast<uint32_t>(b >> 32) | 1u;  // never all zero
+            x[l] = y[l] = 0.0f;
+        }
+    }
+};
+
+/**
+ * @brief Advances every walker once and stores the pixel it lands on
+ *
+ * One xoshiro128+ step, the map by table lookup and the pixel index, for all
+ * walkers in a loop the compiler vectorizes.
+ * @param w Walkers
+ * @param pixel Output, per walker: y * width + x, or -1 outside the image
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @param scale Pixels per unit of the fern
+ */
+inline void fernStep(FernWalkers &w, int32_t *pixel, int width, int height, float scale) {
+    const float x0 = static_cast<float>(width / 2), y0 = static_cast<float>(height);
+    for (int l = 0; l < FERN_WALKERS; ++l) {
+        uint32_t r = w.s0[l] + w.s3[l];
+        uint32_t t = w.s1[l] << 9;
+        w.s2[l] ^= w.s0[l];
+        w.s3[l] ^= w.s1[l];
+        w.s1[l] ^= w.s2[l];
+        w.s0[l] ^= w.s3[l];
+        w.s2[l] ^= t;
+        w.s3[l] = (w.s3[l] << 11) | (w.s3[l] >> 21);
+
+        int k = (r >= FERN_T1) + (r >= FERN_T2) + (r >= FERN_T3);
+        float x = w.x[l], y = w.y[l];
+        float nx = FERN_A[k] * x + FERN_B[k] * y + FERN_E[k];
+        float ny = FERN_C[k] * x + FERN_D[k] * y + FERN_F[k];
+        w.x[l] = nx;
+        w.y[l] = ny;
+
+        int32_t px = static_cast<int32_t>(nx * scale + x0);
+        int32_t py = static_cast<int32_t>(y0 - ny * scale);
+        bool inside = (px >= 0) & (px < width) & (py >= 0) & (py < height);
+        pixel[l] = inside ? py * width + px : -1;
+    }
+}
+
+/**
+ * @brief Draws n points and stores their pixels (-1 outside the image)
+ * @param w Walkers
+ * @param out Output, n entries
+ * @param n Points to draw
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @param scale Pixels per unit of the fern
+ */
+inline void fernPoints(FernWalkers &w, int32_t *out, long n, int width, int height, float scale) {
+    alignas(64) int32_t pixel[FERN_WALKERS];
+    long done = 0;
+    for (; done + FERN_WALKERS <= n; done += FERN_WALKERS)
+        fernStep(w, out + done, width, height, scale);
+    if (done < n) {
+        fernStep(w, pixel, width, height, scale);
+        for (long l = 0; done + l < n; ++l)
+            out[done + l] = pixel[l];
+    }
+}
+
+/**
+ * @brief Advances the walkers and plots every point they visit
+ * @param w Walkers
+ * @param image Row-major 8-bit image, width x height
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @param scale Pixels per unit of the fern
+ * @param iterations Points to draw (split evenly over the walkers)
+ */
+inline void fernChaosGame(FernWalkers &w, uint8_t *image, int width, int height, float scale, long iterations) {
+    alignas(64) int32_t pixel[FERN_WALKERS];
+    for (long done = 0; done < iterations; done += FERN_WALKERS) {
+        const int lanes = iterations - done < FERN_WALKERS ? static_cast<int>(iterations - done) : FERN_WALKERS;
+        fernStep(w, pixel, width, height, scale);
+
+        // Scattered stores stay scalar
+        for (int l = 0; l < lanes; ++l)
+            if (pixel[l] >= 0)
+                image[pixel[l]] = 255;
+    }
+}
+
+#endif
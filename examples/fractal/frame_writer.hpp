@@ -0,0 +1,123 @@
+/**
+ * @file frame_writer.hpp
+ * @brief Background thread that colors, rotates and encodes animation frames
+ *
+ * PNG encoding takes about as long as rendering a frame, so a rank that
+ * writes its frames itself spends half of its time idle for the rest of its
+ * group. FrameWriter takes the reduced frame, returns at once and does the
+ * color map, rotation and imwrite on its own thread while the rank computes
+ * the next frame. The thread never calls MPI, so MPI_THREAD_FUNNELED is
+ * enough; with a library that only grants MPI_THREAD_SINGLE the writer is
+ * built synchronous and submit() encodes the frame itself.
+ */
+
+#ifndef FRAME_WRITER_HPP
+#define FRAME_WRITER_HPP
+
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+/**
+ * @brief Bounded queue of frames written by one I/O thread
+ */
+class FrameWriter {
+public:
+    /**
+     * @brief Starts the I/O thread
+     * @param colormap OpenCV color map applied before writing, or -1 for gray
+     * @param rotation Argument of cv::rotate, or -1 to keep the orientation
+     * @param threaded False to write every frame inside submit(), without a thread
+     * @param depth Frames that may wait in the queue before submit() blocks
+     */
+    FrameWriter(int colormap, int rotation, bool threaded = true, size_t depth = 4)
+        : colormap_(colormap), rotation_(rotation), depth_(depth),
+          thread_(threaded ? std::thread([this] { loop(); }) : std::thread()) {}
+
+    /// Writes the frames still queued and stops the thread
+    ~FrameWriter() { finish(); }
+
+    FrameWriter(const FrameWriter &) = delete;
+    FrameWriter &operator=(const FrameWriter &) = delete;
+
+    /**
+     * @brief Queues a frame; only blocks while the queue is full
+     * @param path File to write
+     * @param frame Gray image, owned by the writer from now on
+     * @return Seconds spent waiting for room in the queue (0 when not threaded)
+     */
+    double submit(std::string path, cv::Mat frame) {
+        if (!thread_.joinable()) {
+            write(path, frame);
+            return 0;
+        }
+        auto start = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(mutex_);
+        room_.wait(lock, [this] { return queue_.size() < depth_; });
+        queue_.emplace_back(std::move(path), std::move(frame));
+        ready_.notify_one();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /// Waits until every queued frame is written and joins the thread
+    void finish() {
+        if (!thread_.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_ = true;
+        }
+        ready_.notify_one();
+        thread_.join();
+    }
+
+    /// Seconds spent coloring, rotating and encoding
+    double busy() const { return busy_; }
+    /// Frames written
+    long written() const { return written_; }
+
+private:
+    void loop() {
+        for (;;) {
+            std::pair<std::string, cv::Mat> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ready_.wait(lock, [this] { return done_ || !queue_.empty(); });
+                if (queue_.empty())
+                    return;
+                job = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            room_.notify_one();
+            write(job.first, job.second);
+        }
+    }
+
+    void write(const std::string &path, cv::Mat image) {
+        auto start = std::chrono::steady_clock::now();
+        if (colormap_ >= 0)
+            cv::applyColorMap(image, image, colormap_);
+        if (rotation_ >= 0)
+            cv::rotate(image, image, rotation_);
+        cv::imwrite(path, image);
+        busy_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ++written_;
+    }
+
+    int colormap_, rotation_;
+    size_t depth_;
+    std::deque<std::pair<std::string, cv::Mat>> queue_;
+    std::mutex mutex_;
+    std::condition_variable ready_, room_;
+    bool done_ = false;
+    double busy_ = 0;      ///< Only touched by the writing thread until it is joined
+    long written_ = 0;
+    std::thread thread_;   ///< Last member: starts once the rest is initialized
+};
+
+#endif
@@ -4,6 +4,15 @@
 #include <vector>
 #include <cstdlib>
 #include <climits>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <memory>
+
+#include "fern_kernel.hpp"
+#include "fern_density.hpp"
+#include "escape_time.hpp"
+#include "frame_writer.hpp"
 
 using namespace std;
 using namespace cv;
@@ -12,6 +21,8 @@ const int WIDTH = 1080;
 const int HEIGHT = 1920;
 const int SCALE = 150;
 const int TOTAL_ITER = 1000000;
+const long DENSITY_BATCH = 1 << 20;  // puntos por rank entre intercambios en --density
+const long BUDGET_CHUNK = FERN_WALKERS * 1024L;  // puntos entre consultas del reloj en --time-budget
 
 /**
  * @brief Applies the first affine transformation used in the Barnsley fern.
@@ -56,12 +67,17 @@ Point2f f4(Point2f p) {
 
 /**
  * @brief Generates the local portion of a Barnsley fern image using a stochastic IFS method.
+ *
+ * Single-walker reference kernel, kept for comparison (--scalar); the default
+ * is the vectorized multi-walker kernel of fern_kernel.hpp.
  * 
  * @param image Output OpenCV matrix to write the fern pixels into.
  * @param iterations Number of iterations to perform.
  * @param seed Random seed for generating different point sets.
+ * @param scale Pixels per unit of the fern.
  */
-void generateFern(Mat& image, int iterations, int seed) {
+void generateFern(Mat& image, int iterations, int seed, float scale) {
+    const int width = image.cols, height = image.rows;
     Point2f pos(0, 0);
     const int dieWalls = 100;
     srand(seed);
@@ -77,15 +93,330 @@ void generateFern(Mat& image, int iterations, int seed) {
         else
             pos = f4(pos);
 
-        int x = static_cast<int>(pos.x * SCALE + WIDTH / 2);
-        int y = static_cast<int>(HEIGHT - pos.y * SCALE);
+        int x = static_cast<int>(pos.x * scale + width / 2);
+        int y = static_cast<int>(height - pos.y * scale);
 
-        if (x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT) {
+        if (x >= 0 && x < width && y >= 0 && y < height) {
             image.at<uchar>(y, x) = 255;
         }
     }
 }
 
+/**
+ * @brief Density rendering: every rank owns a band of hit counters and points travel to their owner.
+ *
+ * @param walkers Walkers of this rank.
+ * @param local_iter Points drawn by this rank.
+ * @param width Image width.
+ * @param height Image height.
+ * @param scale Pixels per unit of the fern.
+ * @param gamma Gamma of the tone mapping.
+ * @param rank Rank of this process.
+ */
+void renderDensity(FernWalkers& walkers, long local_iter, int width, int height, float scale, double gamma, int rank) {
+    DensityBands bands(MPI_COMM_WORLD, width, height);
+    vector<int32_t> points(DENSITY_BATCH);
+
+    // Todos los ranks dibujan local_iter puntos, así que hacen las mismas rondas de intercambio
+    double start_time = MPI_Wtime(), exchange_time = 0;
+    for (long done = 0; done < local_iter; done += DENSITY_BATCH) {
+        long n = min(DENSITY_BATCH, local_iter - done);
+        fernPoints(walkers, points.data(), n, width, height, scale);
+        bands.add(points.data(), n);
+        double t = MPI_Wtime();
+        bands.exchange();
+        exchange_time += MPI_Wtime() - t;
+    }
+    double elapsed = MPI_Wtime() - start_time;
+    cout << "Rank " << rank << " completed in " << elapsed << " seconds ("
+         << (elapsed > 0 ? local_iter / elapsed / 1e6 : 0) << " Mpoints/s, "
+         << exchange_time << " s exchanging, " << bands.bytes() / (1 << 20) << " MiB of counters)." << endl;
+
+    vector<uint8_t> band = bands.toneMap(bands.maxHits(), gamma);
+    Mat global_image;
+    if (rank == 0)
+        global_image = Mat::zeros(height, width, CV_8UC1);
+    bands.gather(band, rank == 0 ? global_image.data : nullptr);
+
+    if (rank == 0) {
+        rotate(global_image, global_image, ROTATE_90_COUNTERCLOCKWISE);
+        imwrite("Fern.png", global_image);
+    }
+}
+
+/**
+ * @brief Partial image in flight towards rank 0 during a time-budgeted render.
+ */
+struct Preview {
+    vector<uint8_t> sent;       ///< Copy of the local image being reduced (the original keeps changing)
+    Mat combined;               ///< Reduced image (rank 0 only)
+    MPI_Request request = MPI_REQUEST_NULL;
+    int frame = -1;             ///< Number of the preview, -1 when the slot is free
+};
+
+/**
+ * @brief Writes a finished preview on rank 0 and frees its slot.
+ *
+ * @param preview Preview whose reduction completed.
+ * @param rank Rank of this process.
+ */
+void savePreview(Preview& preview, int rank) {
+    if (rank == 0) {
+        Mat frame;
+        rotate(preview.combined, frame, ROTATE_90_COUNTERCLOCKWISE);
+        char name[64];
+        snprintf(name, sizeof(name), "Fern_preview_%03d.png", preview.frame);
+        imwrite(name, frame);
+    }
+    preview.frame = -1;
+}
+
+/**
+ * @brief Time-budgeted rendering: ranks draw points until the deadline while previews are reduced in the background.
+ *
+ * Preview k is started by every rank once k * interval seconds have passed,
+ * so all ranks issue the same MPI_Ireduce calls in the same order. Each one
+ * reduces a copy of the local image, which lets the walkers keep plotting;
+ * the requests are tested between chunks of points and rank 0 writes every
+ * preview as soon as it arrives.
+ *
+ * @param walkers Walkers of this rank.
+ * @param budget Seconds of drawing.
+ * @param interval Seconds between previews (0 for none).
+ * @param width Image width.
+ * @param height Image height.
+ * @param scale Pixels per unit of the fern.
+ * @param rank Rank of this process.
+ */
+void renderTimeBudget(FernWalkers& walkers, double budget, double interval, int width, int height, float scale, int rank) {
+    Mat local_image = Mat::zeros(height, width, CV_8UC1);
+    const int pixels = width * height;
+    const int previews = interval > 0 ? static_cast<int>(ceil(budget / interval)) - 1 : 0;
+
+    // Dos previsualizaciones en vuelo como máximo; solo se espera si ambas siguen pendientes
+    Preview slots[2];
+    for (Preview& p : slots) {
+        p.sent.resize(pixels);
+        if (rank == 0)
+            p.combined = Mat::zeros(height, width, CV_8UC1);
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start_time = MPI_Wtime(), stall = 0;
+    long points = 0;
+    int issued = 0;
+    for (;;) {
+        fernChaosGame(walkers, local_image.data, width, height, scale, BUDGET_CHUNK);
+        points += BUDGET_CHUNK;
+        double now = MPI_Wtime() - start_time;
+        bool over = now >= budget;
+
+        while (issued < previews && (over || now >= (issued + 1) * interval)) {
+            Preview& p = slots[issued % 2];
+            if (p.frame >= 0) {
+                double t = MPI_Wtime();
+                MPI_Wait(&p.request, MPI_STATUS_IGNORE);
+                stall += MPI_Wtime() - t;
+                savePreview(p, rank);
+            }
+            memcpy(p.sent.data(), local_image.data, pixels);
+            MPI_Ireduce(p.sent.data(), rank == 0 ? p.combined.data : nullptr, pixels, MPI_UNSIGNED_CHAR,
+                        MPI_MAX, 0, MPI_COMM_WORLD, &p.request);
+            p.frame = ++issued;
+        }
+
+        // Hace avanzar las reducciones pendientes sin bloquear
+        for (Preview& p : slots) {
+            int done = 0;
+            if (p.frame >= 0)
+                MPI_Test(&p.request, &done, MPI_STATUS_IGNORE);
+            if (done)
+                savePreview(p, rank);
+        }
+        if (over)
+            break;
+    }
+    double elapsed = MPI_Wtime() - start_time;
+
+    for (int k = 0; k < 2; ++k) {
+        Preview& p = slots[(issued + k) % 2];  // la más antigua primero
+        if (p.frame >= 0) {
+            MPI_Wait(&p.request, MPI_STATUS_IGNORE);
+            savePreview(p, rank);
+        }
+    }
+
+    cout << "Rank " << rank << " completed in " << elapsed << " seconds (" << points / 1e6 << " Mpoints, "
+         << points / elapsed / 1e6 << " Mpoints/s, " << stall << " s waiting for previews)." << endl;
+
+    long total_points = 0;
+    MPI_Reduce(&points, &total_points, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    Mat global_image;
+    if (rank == 0) {
+        global_image = Mat::zeros(height, width, CV_8UC1);
+    }
+    MPI_Reduce(local_image.data,
+                (rank == 0 ? global_image.data : nullptr),
+                pixels, MPI_UNSIGNED_CHAR,
+                MPI_MAX, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        cout << "Budget of " << budget << " seconds: " << total_points / 1e6 << " Mpoints in total, "
+             << previews << " previews." << endl;
+        rotate(global_image, global_image, ROTATE_90_COUNTERCLOCKWISE);
+        imwrite("Fern.png", global_image);
+    }
+}
+
+/**
+ * @brief Escape-time rendering: ranks pull strips of rows until the image is done, then reduce by maximum.
+ *
+ * @param view Fractal, region and image size.
+ * @param dynamic Dynamic (guided) strips instead of one static block per rank.
+ * @param min_rows Smallest strip of the dynamic schedule.
+ * @param rank Rank of this process.
+ * @param size Number of ranks.
+ */
+void renderEscapeTime(const EscapeView& view, bool dynamic, int min_rows, int rank, int size) {
+    Mat local_image = Mat::zeros(view.height, view.width, CV_8UC1);
+
+    double start_time = MPI_Wtime();
+    EscapeStats stats = renderEscape(MPI_COMM_WORLD, view, local_image.data, dynamic, min_rows);
+    double elapsed = MPI_Wtime() - start_time;
+
+    // Tiempo ocupado de cada rank en rank 0 para ver el balance de carga
+    double mine[6] = {stats.busy, stats.wait, static_cast<double>(stats.tiles), static_cast<double>(stats.rows), stats.iters, elapsed};
+    vector<double> all(rank == 0 ? 6 * size : 0);
+    MPI_Gather(mine, 6, MPI_DOUBLE, all.data(), 6, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if (rank == 0) {
+        double max_busy = 0, sum_busy = 0;
+        elapsed = 0;
+        for (int r = 0; r < size; ++r) {
+            const double* s = &all[6 * r];
+            cout << "Rank " << r << " busy " << s[0] << " s, waiting " << s[1] << " s, "
+                 << static_cast<long>(s[2]) << " tiles, " << static_cast<long>(s[3]) << " rows, "
+                 << s[4] / 1e6 << " Miterations." << endl;
+            max_busy = max(max_busy, s[0]);
+            sum_busy += s[0];
+            elapsed = max(elapsed, s[5]);
+        }
+        cout << (dynamic ? "Dynamic" : "Static") << " schedule completed in " << elapsed
+             << " seconds, load balance (mean / max busy): " << (max_busy > 0 ? sum_busy / size / max_busy : 1) << endl;
+    }
+
+    Mat global_image;
+    if (rank == 0) {
+        global_image = Mat::zeros(view.height, view.width, CV_8UC1);
+    }
+
+    // Cada píxel lo calcula un solo rank; el resto aporta ceros
+    MPI_Reduce(local_image.data,
+                (rank == 0 ? global_image.data : nullptr),
+                view.width * view.height, MPI_UNSIGNED_CHAR,
+                MPI_MAX, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        Mat color;
+        applyColorMap(global_image, color, COLORMAP_INFERNO);
+        imwrite(view.julia ? "Julia.png" : "Mandelbrot.png", color);
+    }
+}
+
+/**
+ * @brief Zoom animation: groups of ranks render frames in turn and their leaders encode them on an I/O thread.
+ *
+ * The ranks are split into groups of group_size consecutive ranks; group g
+ * renders frames g, g + groups, ... with the dynamic strips of the
+ * escape-time renderer and reduces each one to its leader, which queues it
+ * on a FrameWriter and starts the next frame while the previous one is
+ * colored and encoded.
+ *
+ * @param view First frame; the span shrinks by zoom on every frame.
+ * @param frames Number of frames.
+ * @param zoom Span of frame k + 1 over span of frame k.
+ * @param group_size Ranks per group.
+ * @param dynamic Dynamic (guided) strips instead of one static block per rank.
+ * @param min_rows Smallest strip of the dynamic schedule.
+ * @param threaded Encode on an I/O thread (needs MPI_THREAD_FUNNELED) instead of on the leader itself.
+ * @param rank Rank of this process.
+ * @param size Number of ranks.
+ */
+void renderAnimation(const EscapeView& view, int frames, double zoom, int group_size, bool dynamic, int min_rows,
+                     bool threaded, int rank, int size) {
+    group_size = min(group_size, size);
+    const int groups = (size + group_size - 1) / group_size;
+    const int my_group = rank / group_size;
+    MPI_Comm group;
+    MPI_Comm_split(MPI_COMM_WORLD, my_group, rank, &group);
+    int group_rank;
+    MPI_Comm_rank(group, &group_rank);
+
+    // Solo el líder de cada grupo codifica, en su propio hilo
+    unique_ptr<FrameWriter> writer;
+    if (group_rank == 0)
+        writer.reset(new FrameWriter(COLORMAP_INFERNO, -1, threaded));
+
+    Mat local_image = Mat::zeros(view.height, view.width, CV_8UC1);
+    const int pixels = view.width * view.height;
+    double compute = 0, idle = 0, reduce = 0, stall = 0;
+    long rendered = 0;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start_time = MPI_Wtime();
+    for (int f = my_group; f < frames; f += groups) {
+        EscapeView frame_view = view;
+        frame_view.span = view.span * pow(zoom, f);
+        memset(local_image.data, 0, pixels);
+
+        double t0 = MPI_Wtime();
+        EscapeStats stats = renderEscape(group, frame_view, local_image.data, dynamic, min_rows);
+        double t1 = MPI_Wtime();
+        compute += stats.busy;
+        idle += t1 - t0 - stats.busy;
+
+        Mat frame;
+        if (group_rank == 0)
+            frame = Mat::zeros(view.height, view.width, CV_8UC1);
+        MPI_Reduce(local_image.data, group_rank == 0 ? frame.data : nullptr, pixels, MPI_UNSIGNED_CHAR,
+                   MPI_MAX, 0, group);
+        reduce += MPI_Wtime() - t1;
+
+        if (writer) {
+            char name[64];
+            snprintf(name, sizeof(name), "%s_%04d.png", view.julia ? "Julia" : "Mandelbrot", f);
+            stall += writer->submit(name, frame);
+        }
+        ++rendered;
+    }
+    double encode = 0;
+    if (writer) {
+        double t = MPI_Wtime();
+        writer->finish();
+        stall += MPI_Wtime() - t;
+        encode = writer->busy();
+    }
+    double elapsed = MPI_Wtime() - start_time;
+    MPI_Comm_free(&group);
+
+    // Desglose de tiempos de cada rank en rank 0
+    double mine[7] = {static_cast<double>(rendered), compute, idle, reduce, encode, stall, elapsed};
+    vector<double> all(rank == 0 ? 7 * size : 0);
+    MPI_Gather(mine, 7, MPI_DOUBLE, all.data(), 7, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if (rank == 0) {
+        double total = 0;
+        for (int r = 0; r < size; ++r) {
+            const double* s = &all[7 * r];
+            cout << "Rank " << r << " (group " << r / group_size << "): " << static_cast<long>(s[0]) << " frames, compute "
+                 << s[1] << " s, scheduling/idle " << s[2] << " s, reduction " << s[3] << " s, encoding " << s[4]
+                 << " s (I/O thread), waiting for I/O " << s[5] << " s." << endl;
+            total = max(total, s[6]);
+        }
+        cout << frames << " frames by " << groups << " groups of " << group_size << " ranks in " << total
+             << " seconds (" << (total > 0 ? frames / total : 0) << " frames/s)." << endl;
+    }
+}
+
 /**
  * @brief Entry point. Initializes MPI, generates partial images on each rank, and reduces them into a final image.
  * 
@@ -94,33 +425,147 @@ void generateFern(Mat& image, int iterations, int seed) {
  * @return int Exit status.
  */
 int main(int argc, char** argv) {
-    MPI_Init(&argc, &argv);
+    // Solo el hilo principal llama a MPI; el hilo de E/S de --frames solo codifica
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
 
     int rank, size;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-    int local_iter = TOTAL_ITER / size;
+    // Opciones: --iters N (puntos totales), --seed S, --scalar (kernel de referencia),
+    // --density (conteo por píxel en bandas), --gamma G, --res F (escala de la imagen)
+    // Tiempo de escape: --mandelbrot o --julia RE IM, --max-iter N, --center RE IM, --span W,
+    // --static (un bloque fijo por rank), --min-rows N (franja mínima del reparto dinámico)
+    // Por tiempo: --time-budget S (dibuja hasta el plazo), --preview-every S (previsualizaciones)
+    // Animación: --frames N (zoom de N cuadros), --zoom Z (escala entre cuadros), --group-size G
+    long total_iter = TOTAL_ITER;
+    unsigned long seed = 1234;
+    bool scalar = false, density = false;
+    double gamma = 2.2, res = 1.0;
+    bool escape = false, dynamic = true;
+    int min_rows = 4;
+    double budget = 0, interval = 1.0;
+    int frames = 0, group_size = 1;
+    double zoom = 0.9;
+    EscapeView view;
+    bool centered = false, spanned = false;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--iters") && i + 1 < argc)
+            total_iter = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            seed = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--scalar"))
+            scalar = true;
+        else if (!strcmp(argv[i], "--density"))
+            density = true;
+        else if (!strcmp(argv[i], "--gamma") && i + 1 < argc)
+            gamma = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--res") && i + 1 < argc)
+            res = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--mandelbrot"))
+            escape = true;
+        else if (!strcmp(argv[i], "--julia") && i + 2 < argc) {
+            escape = view.julia = true;
+            view.julia_re = atof(argv[++i]);
+            view.julia_im = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--max-iter") && i + 1 < argc)
+            view.max_iter = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--center") && i + 2 < argc) {
+            centered = true;
+            view.center_re = atof(argv[++i]);
+            view.center_im = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--span") && i + 1 < argc) {
+            spanned = true;
+            view.span = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--static"))
+            dynamic = false;
+        else if (!strcmp(argv[i], "--min-rows") && i + 1 < argc)
+            min_rows = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--time-budget") && i + 1 < argc)
+            budget = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--preview-every") && i + 1 < argc)
+            interval = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            frames = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--zoom") && i + 1 < argc)
+            zoom = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--group-size") && i + 1 < argc)
+            group_size = atoi(argv[++i]);
+    }
+    if (res <= 0 || gamma <= 0 || (scalar && density) || view.max_iter < 1 || view.span <= 0 || min_rows < 1 ||
+        budget < 0 || interval < 0 || (budget > 0 && (scalar || density)) || frames < 0 || zoom <= 0 ||
+        group_size < 1 || (frames > 0 && !escape)) {
+        if (rank == 0)
+            cerr << "Usage: --res, --gamma, --max-iter, --span, --min-rows, --zoom and --group-size must be positive; "
+                    "--scalar cannot be combined with --density or --time-budget, nor --density with --time-budget; "
+                    "--frames needs --mandelbrot or --julia." << endl;
+        MPI_Finalize();
+        return 1;
+    }
+
+    if (escape) {
+        // Imagen apaisada del mismo tamaño que el helecho rotado
+        view.width = static_cast<int>(HEIGHT * res);
+        view.height = static_cast<int>(WIDTH * res);
+        if (view.julia && !centered)
+            view.center_re = 0.0;
+        if (view.julia && !spanned)
+            view.span = 3.2;
+        if (frames > 0)
+            renderAnimation(view, frames, zoom, group_size, dynamic, min_rows, provided >= MPI_THREAD_FUNNELED, rank,
+                            size);
+        else
+            renderEscapeTime(view, dynamic, min_rows, rank, size);
+        MPI_Finalize();
+        return 0;
+    }
+
+    const int width = static_cast<int>(WIDTH * res);
+    const int height = static_cast<int>(HEIGHT * res);
+    const float scale = static_cast<float>(SCALE * res);
+    long local_iter = total_iter / size;
+
+    if (density) {
+        FernWalkers walkers(seed, rank);
+        renderDensity(walkers, local_iter, width, height, scale, gamma, rank);
+        MPI_Finalize();
+        return 0;
+    }
+
+    if (budget > 0) {
+        FernWalkers walkers(seed, rank);
+        renderTimeBudget(walkers, budget, interval, width, height, scale, rank);
+        MPI_Finalize();
+        return 0;
+    }
 
     double start_time = MPI_Wtime();
 
     // Imagen local de cada nodo
-    Mat local_image = Mat::zeros(HEIGHT, WIDTH, CV_8UC1);
-    generateFern(local_image, local_iter, 1234 + rank);
+    Mat local_image = Mat::zeros(height, width, CV_8UC1);
+    if (scalar) {
+        generateFern(local_image, static_cast<int>(local_iter), static_cast<int>(seed) + rank, scale);
+    } else {
+        FernWalkers walkers(seed, rank);
+        fernChaosGame(walkers, local_image.data, width, height, scale, local_iter);
+    }
 
     double end_time = MPI_Wtime();
-    cout << "Rank " << rank << " completed in " << (end_time - start_time) << " seconds." << endl;
+    double elapsed = end_time - start_time;
+    cout << "Rank " << rank << " completed in " << elapsed << " seconds ("
+         << (elapsed > 0 ? local_iter / elapsed / 1e6 : 0) << " Mpoints/s)." << endl;
 
     // Imagen final solo en el proceso 0
     Mat global_image;
     if (rank == 0) {
-        global_image = Mat::zeros(HEIGHT, WIDTH, CV_8UC1);
+        global_image = Mat::zeros(height, width, CV_8UC1);
     }
 
     // Reunir las imágenes usando reducción por máximo (para binario)
     MPI_Reduce(local_image.data,
                 (rank == 0 ? global_image.data : nullptr),
-                WIDTH * HEIGHT, MPI_UNSIGNED_CHAR,
+                width * height, MPI_UNSIGNED_CHAR,
                 MPI_MAX, 0, MPI_COMM_WORLD);
 
     if (rank == 0) {
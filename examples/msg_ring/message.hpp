@@ -0,0 +1,150 @@
+/**
+ * @file message.hpp
+ * @brief Variable-length MPI messages in a single send, and word lists packed without per-word copies.
+ *
+ * Sending a length first and the payload afterwards costs two messages and two
+ * latencies per string. Here the receiver learns the length from the message itself
+ * (MPI_Mprobe + MPI_Get_count), sizes its buffer and takes that same message with
+ * MPI_Mrecv, so every payload is exactly one message and no other receive can steal
+ * it in between.
+ *
+ * Word lists are packed as one contiguous buffer: a word count, the end offset of
+ * each word and then all the characters back to back. Receivers get string_views
+ * into that buffer instead of one std::string per word.
+ */
+
+#ifndef MSG_RING_MESSAGE_HPP
+#define MSG_RING_MESSAGE_HPP
+
+#include <mpi.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @def MPI_CHECK(cmd)
+ * @brief A macro to wrap MPI calls for automatic error checking.
+ */
+#define MPI_CHECK(cmd) check_mpi_error(cmd, __FILE__, __LINE__)
+
+/**
+ * @brief Checks the return value of an MPI function and aborts if it's not MPI_SUCCESS.
+ * @param err The error code returned by the MPI function.
+ * @param file The source file where the error occurred.
+ * @param line The line number where the error occurred.
+ */
+inline void check_mpi_error(int err, const char* file, int line) {
+    if (err != MPI_SUCCESS) {
+        char msg[MPI_MAX_ERROR_STRING];
+        int len;
+        MPI_Error_string(err, msg, &len);
+        std::fprintf(stderr, "MPI error at %s:%d - %s\n", file, line, msg);
+        MPI_Abort(MPI_COMM_WORLD, err);
+    }
+}
+
+// --- Single-Message Payloads ---
+
+/**
+ * @brief Sends a payload of any length as one message.
+ * @param data First byte of the payload.
+ * @param bytes Payload length.
+ * @param dest The rank of the destination process.
+ * @param tag The message tag.
+ * @param comm The MPI communicator.
+ */
+inline void send_bytes(const void* data, size_t bytes, int dest, int tag, MPI_Comm comm) {
+    MPI_CHECK(MPI_Send(data, static_cast<int>(bytes), MPI_CHAR, dest, tag, comm));
+}
+
+/**
+ * @brief Receives one message of any length, resizing the buffer to fit it.
+ *
+ * Works with std::string and std::vector<char>; the buffer keeps its capacity
+ * across calls, so a reused buffer stops allocating once it has grown.
+ * @param buf Destination buffer.
+ * @param src The rank of the source process (or MPI_ANY_SOURCE).
+ * @param tag The message tag (or MPI_ANY_TAG).
+ * @param comm The MPI communicator.
+ * @return Status of the received message.
+ */
+template <typename Buffer>
+inline MPI_Status recv_bytes(Buffer& buf, int src, int tag, MPI_Comm comm) {
+    MPI_Message message;
+    MPI_Status st;
+    int count;
+    MPI_CHECK(MPI_Mprobe(src, tag, comm, &message, &st));
+    MPI_CHECK(MPI_Get_count(&st, MPI_CHAR, &count));
+    buf.resize(count);
+    MPI_CHECK(MPI_Mrecv(buf.data(), count, MPI_CHAR, &message, &st));
+    return st;
+}
+
+// --- Packed Word Lists ---
+
+/**
+ * @brief Packs words as [count][end offset of each word][characters].
+ * @param words Words to pack (std::string or std::string_view).
+ * @return The packed buffer.
+ */
+template <typename Words>
+inline std::vector<char> pack_words(const Words& words) {
+    const uint32_t count = static_cast<uint32_t>(words.size());
+    size_t chars = 0;
+    for (const auto& w : words) chars += w.size();
+
+    std::vector<char> buf(sizeof(uint32_t) * (count + 1) + chars);
+    std::memcpy(buf.data(), &count, sizeof(count));
+    char* offsets = buf.data() + sizeof(uint32_t);
+    char* arena = offsets + sizeof(uint32_t) * count;
+    uint32_t end = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        std::memcpy(arena + end, words[i].data(), words[i].size());
+        end += static_cast<uint32_t>(words[i].size());
+        std::memcpy(offsets + sizeof(uint32_t) * i, &end, sizeof(end));
+    }
+    return buf;
+}
+
+/**
+ * @brief Views of the words in a buffer made by pack_words.
+ * @param buf Packed buffer; it must outlive the returned views.
+ * @return One string_view per word, pointing into buf.
+ */
+inline std::vector<std::string_view> unpack_words(const std::vector<char>& buf) {
+    std::vector<std::string_view> words;
+    if (buf.size() < sizeof(uint32_t)) return words;
+    uint32_t count;
+    std::memcpy(&count, buf.data(), sizeof(count));
+    const char* offsets = buf.data() + sizeof(uint32_t);
+    const char* arena = offsets + sizeof(uint32_t) * count;
+    words.reserve(count);
+    uint32_t begin = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t end;
+        std::memcpy(&end, offsets + sizeof(uint32_t) * i, sizeof(end));
+        words.emplace_back(arena + begin, end - begin);
+        begin = end;
+    }
+    return words;
+}
+
+/**
+ * @brief Broadcasts a packed buffer from the root: its length, then the bytes straight into place.
+ * @param buf Packed buffer on the root; resized and filled on the other ranks.
+ * @param root The broadcasting rank.
+ * @param comm The MPI communicator.
+ */
+inline void bcast_bytes(std::vector<char>& buf, int root, MPI_Comm comm) {
+    uint64_t bytes = buf.size();
+    MPI_CHECK(MPI_Bcast(&bytes, 1, MPI_UINT64_T, root, comm));
+    buf.resize(bytes);
+    if (bytes > 0) {
+        MPI_CHECK(MPI_Bcast(buf.data(), static_cast<int>(bytes), MPI_CHAR, root, comm));
+    }
+}
+
+#endif
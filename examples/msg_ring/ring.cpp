@@ -6,6 +6,16 @@
  * word by word. Each process, in turn, receives the current state of the sentence,
  * adds its assigned word, and passes it to the next process.
  *
+ * The default "full" mode forwards the whole phrase at every hop, so the bytes on the
+ * wire grow quadratically with the number of words. "--mode delta" forwards only an
+ * 8-byte token with the sequence number of the word just appended, keeps the words on
+ * their owners and assembles the text once at the root with MPI_Gatherv. Several sentences
+ * ("--file", one per line) are then in flight around the ring at the same time.
+ * "--compare" runs both modes and reports them side by side.
+ *
+ * Strings travel as single messages and the word list is broadcast as one packed
+ * buffer that every rank reads through string_views (message.hpp).
+ *
  * @version 2.0
  * @date 2025-07-03
  *
@@ -16,7 +26,7 @@
  *
  * @par Execution
  * @code
- * mpirun -np <N> --hostfile <hosts> ./word_ring
+ * mpirun -np <N> --hostfile <hosts> ./word_ring [--mode full|delta] [--compare] [--file <text>]
  * @endcode
  */
 
@@ -26,41 +36,28 @@
 #include <vector>
 #include <string>
 #include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <string_view>
 
-// --- Function Prototypes ---
-
-void check_mpi_error(int err, const char* file, int line);
-static std::vector<std::string> split_words(const std::string& txt);
-static std::string serialize_vector(const std::vector<std::string>& vec);
-static std::vector<std::string> deserialize_string(const std::string& s);
-static void send_string(const std::string& s, int dest, int tag);
-static std::string recv_string(int src, int tag, MPI_Comm comm);
-
-// --- MPI Error Utility ---
+#include "message.hpp"
 
 /**
- * @def MPI_CHECK(cmd)
- * @brief A macro to wrap MPI calls for automatic error checking.
+ * @brief Traffic of one ring run, counted on the sending side.
  */
-#define MPI_CHECK(cmd) check_mpi_error(cmd, __FILE__, __LINE__)
+struct RingStats {
+    double time = 0;         ///< Seconds from the start barrier until the root holds the text
+    long long messages = 0;  ///< Messages sent
+    long long bytes = 0;     ///< Bytes sent
+};
 
-/**
- * @brief Checks the return value of an MPI function and aborts if it's not MPI_SUCCESS.
- * @param err The error code returned by the MPI function.
- * @param file The source file where the error occurred.
- * @param line The line number where the error occurred.
- */
-void check_mpi_error(int err, const char* file, int line) {
-    if (err != MPI_SUCCESS) {
-        char msg[MPI_MAX_ERROR_STRING];
-        int len;
-        MPI_Error_string(err, msg, &len);
-        std::fprintf(stderr, "MPI error at %s:%d - %s\n", file, line, msg);
-        MPI_Abort(MPI_COMM_WORLD, err);
-    }
-}
+// --- Function Prototypes ---
 
-// --- String and Vector Helpers ---
+static std::vector<std::string> split_words(const std::string& txt);
+static void send_string(std::string_view s, int dest, int tag, RingStats& stats);
+
+// --- String Helpers ---
 
 /**
  * @brief Splits a string into a vector of words.
@@ -75,74 +72,251 @@ static std::vector<std::string> split_words(const std::string& txt) {
     return words;
 }
 
+// --- MPI Communication Wrappers ---
+
 /**
- * @brief Serializes a vector of strings into a single newline-delimited string.
- * @param vec The vector of strings to serialize.
- * @return A single string containing all vector elements separated by '\\n'.
+ * @brief Sends a string to a destination process as a single message (see message.hpp).
+ * @param s The string to send.
+ * @param dest The rank of the destination process.
+ * @param tag The message tag.
+ * @param stats Counters updated with the message sent.
  */
-static std::string serialize_vector(const std::vector<std::string>& vec) {
-    std::ostringstream oss;
-    for (size_t i = 0; i < vec.size(); ++i) {
-        oss << vec[i] << (i == vec.size() - 1 ? "" : "\n");
-    }
-    return oss.str();
+static void send_string(std::string_view s, int dest, int tag, RingStats& stats) {
+    send_bytes(s.data(), s.size(), dest, tag, MPI_COMM_WORLD);
+    stats.messages++;
+    stats.bytes += s.size();
 }
 
+// --- Ring Modes ---
+
 /**
- * @brief Deserializes a newline-delimited string into a vector of strings.
- * @param s The serialized string.
- * @return A vector containing the separated strings.
+ * @brief Original mode: every hop receives the whole phrase, appends a word and forwards it.
+ *
+ * Sentences are assembled one after the other; the owner of the last word sends
+ * each finished phrase to the root.
+ * @param sentences Words of each sentence, known by every rank.
+ * @param rank Rank of this process.
+ * @param size Number of processes.
+ * @param hostnames Hostname of every rank, for the log.
+ * @param verbose Whether each hop is logged.
+ * @param stats Counters updated with the messages sent.
+ * @return The assembled sentences (only on the root).
  */
-static std::vector<std::string> deserialize_string(const std::string& s) {
-    std::vector<std::string> vec;
-    if (s.empty()) return vec;
-    std::istringstream iss(s);
-    std::string word;
-    while (std::getline(iss, word)) {
-        vec.push_back(word);
+static std::vector<std::string> run_full_ring(const std::vector<std::vector<std::string_view>>& sentences, int rank,
+                                              int size, const std::vector<std::string>& hostnames, bool verbose,
+                                              RingStats& stats) {
+    const int TAG_PHRASE = 201;
+    std::vector<std::string> result;
+    std::string current_phrase;  // reused, so received phrases stop allocating once it has grown
+
+    for (const std::vector<std::string_view>& all_words : sentences) {
+        const int total_words = static_cast<int>(all_words.size());
+        current_phrase.clear();
+
+        for (int i = 0; i < total_words; ++i) {
+            int owner_rank = i % size;
+            if (rank == owner_rank) {
+                // Receive the phrase from the previous process (unless this is the first word)
+                if (i > 0) {
+                    int source_rank = (i - 1) % size;
+                    recv_bytes(current_phrase, source_rank, TAG_PHRASE, MPI_COMM_WORLD);
+                }
+
+                // Add the next word to the phrase
+                std::string_view my_word = all_words[i];
+                if (!current_phrase.empty()) {
+                    current_phrase += " ";
+                }
+                current_phrase += my_word;
+
+                // Log the action and send the updated phrase to the next process
+                if (i < total_words - 1) {
+                    int next_owner_rank = (i + 1) % size;
+                    if (verbose)
+                        std::cout << hostnames[rank] << " adds '" << my_word << "' and sends '" << current_phrase << "' to " << hostnames[next_owner_rank] << std::endl;
+                    send_string(current_phrase, next_owner_rank, TAG_PHRASE, stats);
+                } else if (verbose) {
+                    // For the last word, log that it's being sent back to the root node (rank 0)
+                    std::cout << hostnames[rank] << " adds '" << my_word << "' and sends '" << current_phrase << "' to " << hostnames[0] << std::endl;
+                }
+            }
+        }
+
+        int final_owner_rank = (total_words - 1) % size;
+        if (rank == final_owner_rank) {
+            // The process that added the last word reports that the ring is complete
+            if (verbose)
+                std::cout << "\nThe message has completed the ring and was finalized at " << hostnames[rank] << ".\n";
+            if (rank != 0) {
+                // If the final owner is not the root, send the final phrase to the root
+                send_string(current_phrase, 0, TAG_PHRASE, stats);
+            }
+        }
+        if (rank == 0) {
+            // If the root was not the final owner, it must receive the final phrase
+            if (final_owner_rank != 0) {
+                recv_bytes(current_phrase, final_owner_rank, TAG_PHRASE, MPI_COMM_WORLD);
+            }
+            result.push_back(current_phrase);
+        }
     }
-    return vec;
+    return result;
 }
 
-// --- MPI Communication Wrappers ---
+/**
+ * @brief Appends a (sequence number, word) record to a byte buffer.
+ * @param buf Buffer to extend.
+ * @param seq Global sequence number of the word.
+ * @param word The word.
+ */
+static void pack_word(std::vector<char>& buf, int64_t seq, std::string_view word) {
+    int32_t len = static_cast<int32_t>(word.size());
+    size_t used = buf.size();
+    buf.resize(used + sizeof(seq) + sizeof(len) + word.size());
+    std::memcpy(&buf[used], &seq, sizeof(seq));
+    std::memcpy(&buf[used + sizeof(seq)], &len, sizeof(len));
+    std::memcpy(&buf[used + sizeof(seq) + sizeof(len)], word.data(), word.size());
+}
 
 /**
- * @brief Sends a std::string to a destination process.
+ * @brief Delta mode: each hop forwards only the sequence number of the word it appended.
  *
- * First sends the length of the string, then the string data itself.
- * @param s The string to send.
- * @param dest The rank of the destination process.
- * @param tag The message tag.
+ * Word i of a sentence is still appended by rank i % size, in ring order, but the
+ * token that travels is just the 8-byte sequence number: every rank already has the
+ * broadcast words, so the token only hands over the turn. Each rank keeps the words
+ * it appended; once the ring is done the root collects them with
+ * a single MPI_Gatherv and places them by sequence number. Bytes on the wire grow
+ * linearly with the text. Because a rank only waits for the tokens of its own words,
+ * the next sentence enters the ring as soon as rank 0 is done with the previous one,
+ * so short sentences are pipelined around the ring.
+ * @param sentences Words of each sentence, known by every rank.
+ * @param rank Rank of this process.
+ * @param size Number of processes.
+ * @param hostnames Hostname of every rank, for the log.
+ * @param verbose Whether each hop is logged.
+ * @param stats Counters updated with the messages sent.
+ * @return The assembled sentences (only on the root).
  */
-static void send_string(const std::string& s, int dest, int tag) {
-    int len = static_cast<int>(s.size());
-    MPI_CHECK(MPI_Send(&len, 1, MPI_INT, dest, tag, MPI_COMM_WORLD));
-    if (len > 0) {
-        MPI_CHECK(MPI_Send(s.c_str(), len, MPI_CHAR, dest, tag, MPI_COMM_WORLD));
+static std::vector<std::string> run_delta_ring(const std::vector<std::vector<std::string_view>>& sentences, int rank,
+                                               int size, const std::vector<std::string>& hostnames, bool verbose,
+                                               RingStats& stats) {
+    const int TAG_TOKEN = 202;
+    std::vector<char> owned;  // (seq, word) records of the words appended here
+    int64_t seq = 0;
+
+    for (const std::vector<std::string_view>& words : sentences) {
+        const int total_words = static_cast<int>(words.size());
+        for (int i = 0; i < total_words; ++i, ++seq) {
+            if (i % size != rank)
+                continue;
+
+            // The token of the previous word must arrive before this one is appended
+            int source_rank = (i - 1) % size;
+            if (i > 0 && source_rank != rank) {
+                int64_t previous;
+                MPI_CHECK(MPI_Recv(&previous, 1, MPI_INT64_T, source_rank, TAG_TOKEN, MPI_COMM_WORLD, MPI_STATUS_IGNORE));
+                if (previous != seq - 1) {
+                    std::fprintf(stderr, "Rank %d expected token %lld but got %lld\n", rank,
+                                 static_cast<long long>(seq - 1), static_cast<long long>(previous));
+                    MPI_Abort(MPI_COMM_WORLD, 1);
+                }
+            }
+            pack_word(owned, seq, words[i]);
+
+            int next_owner_rank = (i + 1) % size;
+            if (i < total_words - 1 && next_owner_rank != rank) {
+                MPI_CHECK(MPI_Send(&seq, 1, MPI_INT64_T, next_owner_rank, TAG_TOKEN, MPI_COMM_WORLD));
+                stats.messages++;
+                stats.bytes += sizeof(seq);
+            }
+            if (verbose)
+                std::cout << hostnames[rank] << " adds '" << words[i] << "' and forwards token #" << seq << " to "
+                          << hostnames[i < total_words - 1 ? next_owner_rank : 0] << std::endl;
+        }
+    }
+
+    // Assemble the text once: every rank sends the words it owns to the root
+    int my_count = static_cast<int>(owned.size());
+    std::vector<int> counts(size), displs(size);
+    MPI_CHECK(MPI_Gather(&my_count, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, MPI_COMM_WORLD));
+    std::vector<char> gathered;
+    if (rank == 0) {
+        int total = 0;
+        for (int r = 0; r < size; ++r) {
+            displs[r] = total;
+            total += counts[r];
+        }
+        gathered.resize(total);
+    }
+    MPI_CHECK(MPI_Gatherv(owned.data(), my_count, MPI_CHAR, gathered.data(), counts.data(), displs.data(),
+                          MPI_CHAR, 0, MPI_COMM_WORLD));
+    if (rank != 0) {
+        stats.messages += 2;
+        stats.bytes += sizeof(my_count) + my_count;
+    }
+
+    std::vector<std::string> result;
+    if (rank == 0) {
+        std::vector<std::string_view> by_seq(seq);  // views into the gathered buffer
+        for (size_t at = 0; at < gathered.size();) {
+            int64_t word_seq;
+            int32_t len;
+            std::memcpy(&word_seq, &gathered[at], sizeof(word_seq));
+            std::memcpy(&len, &gathered[at + sizeof(word_seq)], sizeof(len));
+            by_seq[word_seq] = std::string_view(&gathered[at + sizeof(word_seq) + sizeof(len)], len);
+            at += sizeof(word_seq) + sizeof(len) + len;
+        }
+        size_t next = 0;
+        for (const std::vector<std::string_view>& words : sentences) {
+            std::string phrase;
+            for (size_t i = 0; i < words.size(); ++i, ++next) {
+                if (i > 0)
+                    phrase += " ";
+                phrase += by_seq[next];
+            }
+            result.push_back(phrase);
+        }
     }
+    return result;
 }
 
 /**
- * @brief Receives a std::string from a source process.
- *
- * First receives the length of the string, then the string data.
- * @param src The rank of the source process.
- * @param tag The message tag.
- * @param comm The MPI communicator.
- * @return The received string.
+ * @brief Runs one ring mode between two barriers and sums the traffic of all ranks on the root.
+ * @return The assembled sentences (only on the root); stats holds the totals on the root.
  */
-static std::string recv_string(int src, int tag, MPI_Comm comm) {
-    MPI_Status st;
-    int len;
-    MPI_CHECK(MPI_Recv(&len, 1, MPI_INT, src, tag, comm, &st));
-    std::string buf;
-    if (len > 0) {
-        buf.resize(len);
-        MPI_CHECK(MPI_Recv(&buf[0], len, MPI_CHAR, src, tag, comm, &st));
-    }
-    return buf;
+static std::vector<std::string> run_mode(bool delta, const std::vector<std::vector<std::string_view>>& sentences,
+                                         int rank, int size, const std::vector<std::string>& hostnames,
+                                         bool verbose, RingStats& stats) {
+    RingStats local;
+    MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+    double start_time = MPI_Wtime();
+    std::vector<std::string> result = delta ? run_delta_ring(sentences, rank, size, hostnames, verbose, local)
+                                            : run_full_ring(sentences, rank, size, hostnames, verbose, local);
+    local.time = MPI_Wtime() - start_time;
+
+    long long traffic[2] = {local.messages, local.bytes}, total[2];
+    MPI_CHECK(MPI_Reduce(traffic, total, 2, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD));
+    stats = local;
+    stats.messages = total[0];
+    stats.bytes = total[1];
+    return result;
 }
 
+/**
+ * @brief Prints the per-mode lines of the metrics block.
+ * @param name Mode name.
+ * @param stats Totals of the run.
+ * @param words Number of words.
+ * @param final_size Bytes of the assembled text.
+ */
+static void print_mode_metrics(const char* name, const RingStats& stats, long long words, size_t final_size) {
+    std::cout << "Mode               : " << name << '\n'
+              << "Total time         : " << stats.time << " s\n"
+              << "Avg. latency/word  : " << (words > 0 ? (stats.time / words) * 1000.0 : 0) << " ms\n"
+              << "Bandwidth          : " << (stats.time > 0 ? (final_size / stats.time) / (1024.0 * 1024.0) : 0) << " MB/s\n"
+              << "Messages           : " << stats.messages << '\n'
+              << "Bytes on wire      : " << stats.bytes << '\n';
+}
 
 // --- Main Program ---
 
@@ -158,17 +332,42 @@ int main(int argc, char** argv) {
     MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &rank));
     MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &size));
 
+    // --- 0. COMMAND LINE ---
+    bool delta = false, compare = false, valid = true;
+    std::string file_path;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--mode") && i + 1 < argc) {
+            std::string mode = argv[++i];
+            valid = valid && (mode == "full" || mode == "delta");
+            delta = mode == "delta";
+        } else if (!std::strcmp(argv[i], "--compare")) {
+            compare = true;
+        } else if (!std::strcmp(argv[i], "--file") && i + 1 < argc) {
+            file_path = argv[++i];
+        } else {
+            valid = false;
+        }
+    }
+    if (!valid) {
+        if (rank == 0)
+            std::cerr << "Usage: mpirun -np <N> ./word_ring [--mode full|delta] [--compare] [--file <text>]\n";
+        MPI_Finalize();
+        return 1;
+    }
+    // Hop-by-hop logging only makes sense for a single typed sentence
+    const bool verbose = file_path.empty();
+
     // --- 1. GATHER HOSTNAMES FROM ALL NODES ---
     char proc_name_char[MPI_MAX_PROCESSOR_NAME];
     int name_len;
     MPI_CHECK(MPI_Get_processor_name(proc_name_char, &name_len));
     
     // Buffer to receive all hostnames
-    char all_names_buffer[size * MPI_MAX_PROCESSOR_NAME];
+    std::vector<char> all_names_buffer(size * MPI_MAX_PROCESSOR_NAME);
 
     // Each process sends its name and receives the full list of names
     MPI_CHECK(MPI_Allgather(proc_name_char, MPI_MAX_PROCESSOR_NAME, MPI_CHAR,
-                            all_names_buffer, MPI_MAX_PROCESSOR_NAME, MPI_CHAR,
+                            all_names_buffer.data(), MPI_MAX_PROCESSOR_NAME, MPI_CHAR,
                             MPI_COMM_WORLD));
 
     // Convert the buffer into a list of strings for easy access
@@ -176,7 +375,6 @@ int main(int argc, char** argv) {
     for (int i = 0; i < size; ++i) {
         all_hostnames.push_back(std::string(&all_names_buffer[i * MPI_MAX_PROCESSOR_NAME]));
     }
-    std::string my_hostname = all_hostnames[rank];
 
     if (size < 1) {
         MPI_Finalize();
@@ -184,109 +382,120 @@ int main(int argc, char** argv) {
     }
     
     std::vector<std::string> all_words;
+    std::vector<int> sentence_lengths;  // Words per sentence, in order
     int total_words = 0;
+    int file_ok = 1;
 
-    // The root process (rank 0) gets the sentence from the user
+    // The root process (rank 0) gets the sentence from the user, or one sentence per line of the file
     if (rank == 0) {
-        std::cout << "Enter the sentence:\n> ";
-        std::string line;
-        std::getline(std::cin, line);
-        all_words = split_words(line);
+        if (file_path.empty()) {
+            std::cout << "Enter the sentence:\n> ";
+            std::string line;
+            std::getline(std::cin, line);
+            all_words = split_words(line);
+            sentence_lengths.push_back(static_cast<int>(all_words.size()));
+        } else {
+            std::ifstream in(file_path);
+            file_ok = in ? 1 : 0;
+            std::string line;
+            while (std::getline(in, line)) {
+                std::vector<std::string> words = split_words(line);
+                if (words.empty()) continue;
+                all_words.insert(all_words.end(), words.begin(), words.end());
+                sentence_lengths.push_back(static_cast<int>(words.size()));
+            }
+        }
         total_words = all_words.size();
     }
+    MPI_CHECK(MPI_Bcast(&file_ok, 1, MPI_INT, 0, MPI_COMM_WORLD));
+    if (!file_ok) {
+        if (rank == 0)
+            std::cerr << "Cannot open '" << file_path << "'\n";
+        MPI_Finalize();
+        return 1;
+    }
 
     // Broadcast the total number of words to all processes
     MPI_CHECK(MPI_Bcast(&total_words, 1, MPI_INT, 0, MPI_COMM_WORLD));
 
-    // Broadcast the list of words to all processes
-    if (total_words > 0) {
-        int serialized_len = 0;
-        std::string serialized_words;
-        if (rank == 0) {
-            serialized_words = serialize_vector(all_words);
-            serialized_len = serialized_words.length() + 1;
-        }
-        MPI_CHECK(MPI_Bcast(&serialized_len, 1, MPI_INT, 0, MPI_COMM_WORLD));
-        char* word_buffer = new char[serialized_len];
-        if (rank == 0) {
-            snprintf(word_buffer, serialized_len, "%s", serialized_words.c_str());
-        }
-        MPI_CHECK(MPI_Bcast(word_buffer, serialized_len, MPI_CHAR, 0, MPI_COMM_WORLD));
-        all_words = deserialize_string(std::string(word_buffer));
-        delete[] word_buffer;
+    // Broadcast the list of words to all processes, packed once; every rank then
+    // works on views into the received buffer
+    std::vector<char> packed_words;
+    if (rank == 0) {
+        packed_words = pack_words(all_words);
     }
-    
-    // Synchronize all processes before starting the timer
-    MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
-    double start_time = 0;
-    if(rank == 0) start_time = MPI_Wtime();
-
-    // --- Sequential Word-by-Word Ring Assembly ---
-    std::string current_phrase;
-    const int TAG_PHRASE = 201;
+    bcast_bytes(packed_words, 0, MPI_COMM_WORLD);
+    std::vector<std::string_view> word_views = unpack_words(packed_words);
 
-    for (int i = 0; i < total_words; ++i) {
-        int owner_rank = i % size;
-        if (rank == owner_rank) {
-            // Receive the phrase from the previous process (unless this is the first word)
-            if (i > 0) {
-                int source_rank = (i - 1) % size;
-                current_phrase = recv_string(source_rank, TAG_PHRASE, MPI_COMM_WORLD);
-            }
+    // ...and where each sentence starts
+    int sentence_count = sentence_lengths.size();
+    MPI_CHECK(MPI_Bcast(&sentence_count, 1, MPI_INT, 0, MPI_COMM_WORLD));
+    sentence_lengths.resize(sentence_count);
+    MPI_CHECK(MPI_Bcast(sentence_lengths.data(), sentence_count, MPI_INT, 0, MPI_COMM_WORLD));
+    std::vector<std::vector<std::string_view>> sentences;
+    size_t next_word = 0;
+    for (int length : sentence_lengths) {
+        if (length == 0) continue;
+        sentences.emplace_back(word_views.begin() + next_word, word_views.begin() + next_word + length);
+        next_word += length;
+    }
 
-            // Add the next word to the phrase
-            std::string my_word = all_words[i];
-            if (!current_phrase.empty()) {
-                current_phrase += " ";
-            }
-            current_phrase += my_word;
-            
-            // Log the action and send the updated phrase to the next process
-            if (i < total_words - 1) {
-                int next_owner_rank = (i + 1) % size;
-                std::cout << my_hostname << " adds '" << my_word << "' and sends '" << current_phrase << "' to " << all_hostnames[next_owner_rank] << std::endl;
-                send_string(current_phrase, next_owner_rank, TAG_PHRASE);
-            } else {
-                // For the last word, log that it's being sent back to the root node (rank 0)
-                std::cout << my_hostname << " adds '" << my_word << "' and sends '" << current_phrase << "' to " << all_hostnames[0] << std::endl;
-            }
-        }
+    if (total_words == 0) {
+        // Handle the case where no words were entered
+        if (rank == 0)
+            std::cout << "\nNo words were entered.\n";
+        MPI_CHECK(MPI_Finalize());
+        return 0;
     }
 
+    // --- Ring Assembly (the selected mode, then the other one with --compare) ---
+    RingStats stats, other_stats;
+    std::vector<std::string> final_text = run_mode(delta, sentences, rank, size, all_hostnames, verbose, stats);
+    std::vector<std::string> other_text;
+    if (compare)
+        other_text = run_mode(!delta, sentences, rank, size, all_hostnames, false, other_stats);
+
     // --- Finalization and Metrics Reporting ---
-    if (total_words > 0) {
-        int final_owner_rank = (total_words - 1) % size;
-        if (rank == final_owner_rank) {
-            // The process that added the last word reports that the ring is complete
-            std::cout << "\nThe message has completed the ring and was finalized at " << my_hostname << ".\n";
-            if (rank != 0) {
-                // If the final owner is not the root, send the final phrase to the root
-                send_string(current_phrase, 0, TAG_PHRASE);
-            }
-        }
+    if (rank == 0) {
+        size_t final_size = 0;
+        for (const std::string& phrase : final_text)
+            final_size += phrase.size();
+        final_size += final_text.size() - 1;  // line breaks between sentences
 
-        // The root process gathers the final results and prints the metrics
-        if (rank == 0) {
-            std::string final_phrase = current_phrase;
-            // If the root was not the final owner, it must receive the final phrase
-            if (final_owner_rank != 0) {
-                final_phrase = recv_string(final_owner_rank, TAG_PHRASE, MPI_COMM_WORLD);
-            }
-            
-            double total_time = MPI_Wtime() - start_time;
-            
-            std::cout << "\n--- Reconstructed Sentence ---\n" << final_phrase << "\n";
-            std::cout << "\n--- Metrics ---\n"
-                    << "Processes          : " << size << '\n'
-                    << "Words              : " << total_words << '\n'
-                    << "Final size         : " << final_phrase.size() << " bytes\n"
-                    << "Total time         : " << total_time << " s\n"
-                    << "Avg. latency/word  : " << (total_words > 0 ? (total_time / total_words) * 1000.0 : 0) << " ms\n"
-                    << "Bandwidth          : " << (total_words > 0 && total_time > 0 ? (final_phrase.size() / total_time) / (1024.0 * 1024.0) : 0) << " MB/s\n";
+        if (verbose) {
+            std::cout << "\n--- Reconstructed Sentence ---\n" << final_text[0] << "\n";
+        } else {
+            std::cout << "\n--- Reconstructed Text ---\n"
+                      << final_text.size() << " sentences, first: " << final_text[0] << "\n";
+        }
+        std::cout << "\n--- Metrics ---\n"
+                << "Processes          : " << size << '\n'
+                << "Sentences          : " << final_text.size() << '\n'
+                << "Words              : " << total_words << '\n'
+                << "Final size         : " << final_size << " bytes\n";
+        print_mode_metrics(delta ? "delta" : "full", stats, total_words, final_size);
+        if (compare) {
+            std::cout << '\n';
+            print_mode_metrics(delta ? "full" : "delta", other_stats, total_words, final_size);
+            const RingStats& full_stats = delta ? other_stats : stats;
+            const RingStats& delta_stats = delta ? stats : other_stats;
+            // Ratios always read as "delta is N times better/worse", or n/a when one side is zero
+            auto ratio = [](double full_value, double delta_value, const char* better, const char* worse) {
+                std::ostringstream oss;
+                if (full_value <= 0 || delta_value <= 0)
+                    oss << "n/a";
+                else if (delta_value <= full_value)
+                    oss << full_value / delta_value << "x " << better;
+                else
+                    oss << delta_value / full_value << "x " << worse;
+                return oss.str();
+            };
+            std::cout << "\nSame text          : " << (final_text == other_text ? "yes" : "NO") << '\n'
+                      << "Delta vs full      : " << delta_stats.bytes << " vs " << full_stats.bytes << " bytes ("
+                      << ratio(full_stats.bytes, delta_stats.bytes, "fewer", "more") << "), " << delta_stats.time
+                      << " vs " << full_stats.time << " s ("
+                      << ratio(full_stats.time, delta_stats.time, "faster", "slower") << ")\n";
         }
-    } else if (rank == 0) {
-        // Handle the case where no words were entered
-        std::cout << "\nNo words were entered.\n";
     }
 
     MPI_CHECK(MPI_Finalize());
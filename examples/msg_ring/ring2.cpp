@@ -5,6 +5,9 @@
 #include <cstdint>
 #include <vector>
 #include <cstring>
+#include <atomic>
+#include <new>
+#include <thread>
 
 // CRC32 tabla estática (polinomio 0xEDB88320)
 static uint32_t crc_table[256];
@@ -23,6 +26,19 @@ uint32_t crc32(const uint8_t* data, size_t len, uint32_t prev = 0xFFFFFFFFU) {
     return c;
 }
 
+// ---- Memoria compartida (--shm) -----------------------------------------
+// Los ranks de un mismo nodo (MPI_COMM_TYPE_SHARED) comparten una ventana
+// MPI_Win_allocate_shared. Cada segmento tiene dos ranuras del tamaño del
+// mensaje y dos contadores: la última vuelta publicada en mis ranuras y la
+// última vuelta que leí de la ranura de prev. Si prev está en el mismo nodo,
+// su bloque se lee directo de su ranura: sin mensaje y con una sola copia
+// (la que lo deja en mi ranura para reenviarlo). Entre nodos, MPI como antes.
+struct ShmHeader {
+    std::atomic<long> posted;    // última vuelta publicada
+    std::atomic<long> consumed;  // última vuelta leída de prev
+};
+const size_t SHM_HEADER = 64;    // cabecera alineada a línea de caché
+
 int main(int argc, char** argv) {
     MPI_Init(&argc, &argv);
     int rank, size; MPI_Comm_rank(MPI_COMM_WORLD, &rank); MPI_Comm_size(MPI_COMM_WORLD, &size);
@@ -30,12 +46,14 @@ int main(int argc, char** argv) {
     // ---- CLI mínima ------------------------------------------------------
     size_t msg_size = 1 << 20;   // 1 MiB
     int iters = 100;
+    bool use_shm = false;
     for (int i = 1; i < argc; ++i) {
         if (!strcmp(argv[i], "--size") && i + 1 < argc)   msg_size = std::stoul(argv[++i]);
         else if (!strcmp(argv[i], "--iters") && i + 1 < argc) iters = std::stoi(argv[++i]);
+        else if (!strcmp(argv[i], "--shm")) use_shm = true;
         else if (!strcmp(argv[i], "--help")) {
             if (rank == 0)
-                printf("Uso: mpirun -np <P> ./ring_bw [--size BYTES] [--iters N]\n");
+                printf("Uso: mpirun -np <P> ./ring_bw [--size BYTES] [--iters N] [--shm]\n");
             MPI_Finalize(); return 0;
         }
     }
@@ -50,19 +68,99 @@ int main(int argc, char** argv) {
     init_crc32();
     uint32_t crc_local = crc32(send_buf.data(), msg_size);  // CRC de mi bloque original
 
+    // ---- Ventana compartida con los ranks del nodo (--shm) ----------------
+    MPI_Comm node = MPI_COMM_NULL;
+    MPI_Win win = MPI_WIN_NULL;
+    ShmHeader *hdr = nullptr, *next_hdr = nullptr, *prev_hdr = nullptr;
+    uint8_t *slots = nullptr, *prev_slots = nullptr;
+    bool next_local = false, prev_local = false;
+    if (use_shm) {
+        MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node);
+        MPI_Group world_group, node_group;
+        MPI_Comm_group(MPI_COMM_WORLD, &world_group);
+        MPI_Comm_group(node, &node_group);
+        int ranks[2] = {next, prev}, node_ranks[2];
+        MPI_Group_translate_ranks(world_group, 2, ranks, node_group, node_ranks);
+        MPI_Group_free(&world_group);
+        MPI_Group_free(&node_group);
+
+        void *base;
+        MPI_Win_allocate_shared(SHM_HEADER + 2 * msg_size, 1, MPI_INFO_NULL, node, &base, &win);
+        hdr = new (base) ShmHeader();
+        hdr->posted = 0;
+        hdr->consumed = 0;
+        slots = static_cast<uint8_t*>(base) + SHM_HEADER;
+        memcpy(slots + msg_size, send_buf.data(), msg_size);   // vuelta 1 usa la ranura 1
+        MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+        MPI_Barrier(node);
+
+        MPI_Aint seg; int unit; void *peer;
+        if ((next_local = node_ranks[0] != MPI_UNDEFINED)) {
+            MPI_Win_shared_query(win, node_ranks[0], &seg, &unit, &peer);
+            next_hdr = static_cast<ShmHeader*>(peer);
+        }
+        if ((prev_local = node_ranks[1] != MPI_UNDEFINED)) {
+            MPI_Win_shared_query(win, node_ranks[1], &seg, &unit, &peer);
+            prev_hdr = static_cast<ShmHeader*>(peer);
+            prev_slots = static_cast<uint8_t*>(peer) + SHM_HEADER;
+        }
+    }
+
     MPI_Barrier(MPI_COMM_WORLD);           // sincronizar antes de cronometrar
     double t0 = MPI_Wtime();
 
-    for (int it = 0; it < iters; ++it) {
-        MPI_Sendrecv(send_buf.data(), msg_size, MPI_BYTE, next, 0,
-                     recv_buf.data(), msg_size, MPI_BYTE, prev, 0,
-                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    if (!use_shm) {
+        for (int it = 0; it < iters; ++it) {
+            MPI_Sendrecv(send_buf.data(), msg_size, MPI_BYTE, next, 0,
+                         recv_buf.data(), msg_size, MPI_BYTE, prev, 0,
+                         MPI_COMM_WORLD, MPI_STATUS_IGNORE);
 
-        // Actualizar CRC con el bloque recibido
-        crc_local = crc32(recv_buf.data(), msg_size, crc_local);
+            // Actualizar CRC con el bloque recibido
+            crc_local = crc32(recv_buf.data(), msg_size, crc_local);
 
-        // Copiar recv → send para la siguiente vuelta
-        send_buf.swap(recv_buf);
+            // Copiar recv → send para la siguiente vuelta
+            send_buf.swap(recv_buf);
+        }
+    } else {
+        // Vuelta n: lo que envío está en mi ranura n%2 (o en send_buf[n%2] si
+        // next está en otro nodo) y lo recibido se copia a la ranura siguiente.
+        std::vector<uint8_t> priv[2] = {recv_buf, send_buf};
+        for (long n = 1; n <= iters; ++n) {
+            int s = n & 1;
+            MPI_Request reqs[2];
+            int nreq = 0;
+            if (!prev_local)
+                MPI_Irecv(recv_buf.data(), msg_size, MPI_BYTE, prev, 0, MPI_COMM_WORLD, &reqs[nreq++]);
+            if (next_local)
+                hdr->posted.store(n, std::memory_order_release);
+            else
+                MPI_Isend(priv[s].data(), msg_size, MPI_BYTE, next, 0, MPI_COMM_WORLD, &reqs[nreq++]);
+
+            const uint8_t *in;
+            if (prev_local) {
+                while (prev_hdr->posted.load(std::memory_order_acquire) < n)
+                    std::this_thread::yield();
+                in = prev_slots + s * msg_size;
+            } else {
+                MPI_Wait(&reqs[0], MPI_STATUS_IGNORE);
+                in = recv_buf.data();
+            }
+
+            // Actualizar CRC con el bloque recibido, leído en su lugar
+            crc_local = crc32(in, msg_size, crc_local);
+
+            // Dejarlo listo para la siguiente vuelta (next debe haber leído la vuelta n-1)
+            uint8_t *out = priv[s ^ 1].data();
+            if (next_local) {
+                while (next_hdr->consumed.load(std::memory_order_acquire) < n - 1)
+                    std::this_thread::yield();
+                out = slots + (s ^ 1) * msg_size;
+            }
+            memcpy(out, in, msg_size);
+            if (prev_local)
+                hdr->consumed.store(n, std::memory_order_release);
+            MPI_Waitall(nreq, reqs, MPI_STATUSES_IGNORE);
+        }
     }
 
     double t1 = MPI_Wtime();
@@ -76,6 +174,15 @@ int main(int argc, char** argv) {
     uint32_t crc_global;
     MPI_Reduce(&crc_local, &crc_global, 1, MPI_UNSIGNED, MPI_BXOR, 0, MPI_COMM_WORLD);
 
+    // Enlaces servidos por memoria compartida
+    int shm_link = next_local, shm_links = 0;
+    MPI_Reduce(&shm_link, &shm_links, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (use_shm) {
+        MPI_Win_unlock_all(win);
+        MPI_Win_free(&win);
+        MPI_Comm_free(&node);
+    }
+
     if (rank == 0) {
         double mb_sent = (double)msg_size * iters / 1e6;
         double bw = mb_sent / t_max;
@@ -83,6 +190,10 @@ int main(int argc, char** argv) {
         printf("  Procesos      : %d\n", size);
         printf("  Tamaño mensaje: %.2f MB\n", msg_size / 1e6);
         printf("  Iteraciones   : %d\n", iters);
+        if (use_shm)
+            printf("  Transporte    : memoria compartida en %d de %d enlaces\n", shm_links, size);
+        else
+            printf("  Transporte    : mensajes MPI\n");
         printf("  Tiempo (peor) : %.4f s\n", t_max);
         printf("  BW efectivo   : %.2f MB/s\n", bw);
         printf("  CRC global    : 0x%08X\n", crc_global);
@@ -1,6 +1,6 @@
-scp ring.cpp mpi@node02:~/uss-patagon-cluster/examples/msg_ring
-scp ring.cpp mpi@node03:~/uss-patagon-cluster/examples/msg_ring
-scp ring.cpp mpi@node04:~/uss-patagon-cluster/examples/msg_ring
+scp ring.cpp message.hpp mpi@node02:~/uss-patagon-cluster/examples/msg_ring
+scp ring.cpp message.hpp mpi@node03:~/uss-patagon-cluster/examples/msg_ring
+scp ring.cpp message.hpp mpi@node04:~/uss-patagon-cluster/examples/msg_ring
 
 mpic++ ring.cpp -o ring 
 echo "node01 ok"
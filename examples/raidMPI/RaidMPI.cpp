@@ -5,12 +5,46 @@
  * Este programa implementa un sistema simple de codificación por bloques con paridad XOR
  * distribuido entre múltiples nodos usando MPI. El nodo maestro (rank 0) reparte bloques de datos 
  * y una paridad calculada al resto de nodos. Luego, simula la recuperación de un bloque fallado.
+ *
+ * Con "--write archivo" funciona como un arreglo RAID-5 real: el archivo se corta en
+ * franjas de unidades de varios MB, la paridad rota entre los ranks (raid_layout.hpp) y cada
+ * rank guarda sus unidades en un archivo de su disco local (raid_store.hpp). "--read salida"
+ * lee las unidades de todos los ranks en paralelo y reconstruye el archivo en rank 0.
+ * "--parity m" guarda m paridades Reed-Solomon por franja (raid_rs.hpp) y "--failed" lee
+ * con hasta m ranks caídos, decodificando los datos perdidos. "--recover r" reconstruye el
+ * disco completo del rank r con una reducción en árbol por trozos. "--update n" aplica n
+ * escrituras pequeñas al azar y actualiza la paridad solo con los deltas (raid_cache.hpp).
+ * "--serve n" atiende n lecturas al azar, degradadas si hay ranks caídos, mientras
+ * reconstruye el primero de ellos en un rank de repuesto con un límite de MB/s.
+ *
+ * Uso:
+ *   mpirun -np <procesos> ./raid_mpi [--failed r]         (demostración con bloques de 4 enteros)
+ *   mpirun -np <procesos> ./raid_mpi --write <archivo> [--parity m] [--unit MB] [--dir directorio]
+ *   mpirun -np <procesos> ./raid_mpi --read <salida> [--failed r1,r2,...] [--dir directorio]
+ *   mpirun -np <procesos> ./raid_mpi --recover <rank> [--chunk KiB] [--failed r1,...] [--dir directorio]
+ *   mpirun -np <procesos> ./raid_mpi --update <n> [--write-size bytes] [--cache MB] [--seed s] [--dir directorio]
+ *   mpirun -np <procesos [+ 1]> ./raid_mpi --serve <n> [--read-size bytes] [--rebuild-rate MB/s] [--failed r1,...]
  */
 
 #include <mpi.h>
 #include <iostream>
 #include <vector>
+#include <string>
+#include <map>
+#include <algorithm>
+#include <sstream>
+#include <random>
+#include <cstring>
+#include <climits>
+#include <cstdlib>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "raid_layout.hpp"
+#include "raid_store.hpp"
+#include "raid_rs.hpp"
+#include "raid_cache.hpp"
 
 using namespace std;
 
@@ -25,29 +59,63 @@ const int BLOCK_SIZE = 4;
  * @param b Segundo bloque de datos.
  */
 void xorBlocks(vector<int>& result, const vector<int>& a, const vector<int>& b) {
-    for (int i = 0; i < BLOCK_SIZE; ++i) {
-        result[i] = a[i] ^ b[i];
-    }
+    const uint8_t* sources[2] = {reinterpret_cast<const uint8_t*>(a.data()), reinterpret_cast<const uint8_t*>(b.data())};
+    xorInto(reinterpret_cast<uint8_t*>(result.data()), sources, 2, BLOCK_SIZE * sizeof(int));
 }
 
+/// Opciones de la línea de comandos
+struct Options {
+    string write_path;      ///< Archivo a guardar en el arreglo
+    string read_path;       ///< Archivo donde reconstruir el contenido del arreglo
+    string dir = "/tmp";    ///< Directorio local de cada nodo para sus unidades
+    size_t unit = 4 << 20;  ///< Bytes por unidad de franja
+    int parity = 1;         ///< Paridades por franja (1: RAID-5, 2: RAID-6, m: Reed-Solomon k+m)
+    vector<int> failed;     ///< Ranks que se simulan caídos al leer
+    int recover = -1;       ///< Rank cuyo disco se reconstruye
+    size_t chunk = 256 << 10;  ///< Bytes por trozo de la reconstrucción (0: la unidad entera)
+    long updates = 0;       ///< Escrituras pequeñas al azar a aplicar
+    size_t write_size = 4096;  ///< Bytes por escritura pequeña
+    size_t cache = 16 << 20;   ///< Bytes de la caché write-back de cada rank (0: sin caché)
+    unsigned seed = 1;      ///< Semilla de las escrituras y lecturas al azar
+    long serves = 0;        ///< Lecturas al azar del cliente en --serve
+    size_t read_size = 64 << 10;  ///< Bytes por lectura de --serve
+    double rebuild_rate = 0;      ///< MB/s máximos de la reconstrucción en el repuesto (0: sin límite)
+};
+
+/// Escrituras que el cliente reparte por lote cuando hay caché
+const long UPDATE_BATCH = 256;
+
+/// Franjas de la reconstrucción en vuelo por rank en --serve
+const int REBUILD_WINDOW = 2;
+
+/// Reducciones de trozos en vuelo durante la reconstrucción
+const int RECOVER_WINDOW = 4;
+
 /**
- * @brief Función principal del programa. Controla la inicialización, distribución, recepción y recuperación de datos.
- * 
- * @param argc Número de argumentos de línea de comandos.
- * @param argv Argumentos de línea de comandos.
- * @return int Código de retorno del programa.
+ * @brief Indica si todos los ranks terminaron bien una etapa.
+ *
+ * @param ok Resultado local.
+ * @return true si ok es true en todos los ranks.
  */
-int main(int argc, char** argv) {
-    MPI_Init(&argc, &argv);
-
-    int rank, size;
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank); ///< Identificador del proceso
-    MPI_Comm_size(MPI_COMM_WORLD, &size); ///< Número total de procesos
+bool allOk(bool ok) {
+    int local = ok, global;
+    MPI_Allreduce(&local, &global, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+    return global != 0;
+}
 
+/**
+ * @brief Demostración original: bloques de 4 enteros, paridad en el último rank y recuperación en rank 0.
+ *
+ * @param rank Identificador del proceso.
+ * @param size Número total de procesos.
+ * @param failed_rank Nodo fallado simulado (ni el maestro ni el de paridad).
+ */
+void runDemo(int rank, int size, int failed_rank) {
     char hostname[256];
     gethostname(hostname, sizeof(hostname));
 
     vector<int> data(BLOCK_SIZE);
+    vector<int> parity; ///< Solo en el último nodo
 
     if (rank == 0) {
         // --- NODO MAESTRO: Genera bloques de datos y calcula paridad ---
@@ -63,7 +131,7 @@ int main(int argc, char** argv) {
         }
 
         // Calcula la paridad XOR de todos los bloques
-        vector<int> parity(BLOCK_SIZE, 0);
+        parity.assign(BLOCK_SIZE, 0);
         for (const auto& block : blocks) {
             xorBlocks(parity, parity, block);
         }
@@ -85,11 +153,10 @@ int main(int argc, char** argv) {
         for (int val : data) cout << val << " ";
         cout << endl;
 
-        // El último nodo almacena la paridad y la reenvía luego
+        // El último nodo almacena la paridad
         if (rank == size - 1) {
-            vector<int> parity(BLOCK_SIZE);
+            parity.resize(BLOCK_SIZE);
             MPI_Recv(parity.data(), BLOCK_SIZE, MPI_INT, 0, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            MPI_Send(parity.data(), BLOCK_SIZE, MPI_INT, 0, 1, MPI_COMM_WORLD);
         }
     }
 
@@ -97,38 +164,1169 @@ int main(int argc, char** argv) {
     MPI_Barrier(MPI_COMM_WORLD);
 
     // --- SIMULACIÓN DE FALLA Y RECUPERACIÓN ---
-    int failed_rank = 2; ///< Nodo fallado simulado
-
     if (rank == 0) {
         cout << "\nSimulando falla del nodo " << failed_rank << "..." << endl;
+    }
+
+    // Cada nodo válido aporta su bloque (y el último también la paridad); el fallado y
+    // el maestro aportan ceros. El XOR se combina en árbol con MPI_Reduce en vez de
+    // recibir los bloques uno a uno en el maestro.
+    vector<int> contribution(BLOCK_SIZE, 0);
+    if (rank > 0 && rank != failed_rank) {
+        contribution = data;
+        if (rank == size - 1)
+            xorBlocks(contribution, contribution, parity);
+    }
+    vector<int> recovered(BLOCK_SIZE, 0);
+    MPI_Reduce(contribution.data(), recovered.data(), BLOCK_SIZE, MPI_INT, MPI_BXOR, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        cout << "Datos recuperados del nodo " << failed_rank << ": ";
+        for (int val : recovered) cout << val << " ";
+        cout << endl;
+    }
+}
+
+/**
+ * @brief Cuántos bytes aporta cada rank a una franja y dónde van en el búfer de rank 0.
+ *
+ * @param layout Geometría.
+ * @param s Franja.
+ * @param take Para cada posición de la franja, si participa.
+ * @param slot_offset Para cada posición, su lugar en el búfer de rank 0 (en unidades).
+ * @param counts Salida: bytes por rank.
+ * @param displs Salida: desplazamiento en el búfer de rank 0 por rank.
+ */
+void stripeCounts(const RaidLayout& layout, long s, const vector<bool>& take, const vector<int>& slot_offset,
+                  vector<int>& counts, vector<int>& displs) {
+    for (int j = 0; j < layout.ranks; ++j) {
+        int r = layout.rankOf(s, j);
+        counts[r] = take[j] ? static_cast<int>(layout.unit) : 0;
+        displs[r] = take[j] ? static_cast<int>(slot_offset[j] * layout.unit) : 0;
+    }
+}
+
+/**
+ * @brief Guarda un archivo en el arreglo: rank 0 lo lee por franjas y cada rank escribe su unidad.
+ *
+ * Para cada franja, rank 0 reparte las unidades de datos con MPI_Scatterv.
+ * Cada paridad i se obtiene con un MPI_Reduce(MPI_BXOR) sobre el rank que la
+ * guarda en esa franja: cada rank de datos aporta su unidad multiplicada por
+ * su coeficiente en GF(2^8) (raid_rs.hpp), que para la primera paridad es 1,
+ * es decir, el XOR de RAID-5. Como los ranks de paridad rotan, el cálculo y
+ * la escritura de paridad se reparten entre todos.
+ *
+ * @param opt Opciones.
+ * @param rank Identificador del proceso.
+ * @param size Número total de procesos.
+ * @return false si algún archivo no se pudo usar (lo informa rank 0).
+ */
+bool writeStore(const Options& opt, int rank, int size) {
+    RaidMeta meta;
+    meta.unit = opt.unit;
+    meta.ranks = size;
+    meta.parity = opt.parity;
 
-        vector<int> recovered(BLOCK_SIZE, 0);
-        vector<int> parity(BLOCK_SIZE, 0);
+    int in = -1;
+    if (rank == 0) {
+        in = open(opt.write_path.c_str(), O_RDONLY);
+        struct stat st;
+        if (in >= 0 && fstat(in, &st) == 0)
+            meta.bytes = static_cast<uint64_t>(st.st_size);
+    }
+    if (!allOk(rank != 0 || in >= 0)) {
+        if (rank == 0)
+            cerr << "[!] Error: no se pudo abrir '" << opt.write_path << "'." << endl;
+        return false;
+    }
+    MPI_Bcast(&meta.bytes, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
 
-        // Recibe la paridad del último nodo
-        MPI_Recv(parity.data(), BLOCK_SIZE, MPI_INT, size - 1, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    const RaidLayout layout = meta.layout();
+    const ReedSolomon rs(layout.dataUnits(), layout.parity);
+    const long stripes = layout.stripes(meta.bytes);
+    ChunkFile chunks(raidPath(opt.dir, rank, "dat"), layout.unit, true);
+    if (!allOk(chunks.ok() && saveMeta(raidPath(opt.dir, rank, "meta"), meta))) {
+        if (rank == 0)
+            cerr << "[!] Error: no se pudieron crear los archivos en '" << opt.dir << "' de todos los nodos." << endl;
+        if (in >= 0)
+            close(in);
+        return false;
+    }
 
-        // Recibe todos los bloques (excepto el fallado) y aplica XOR
-        for (int i = 1; i < size; ++i) {
-            if (i == failed_rank) continue;
+    vector<char> stripe(rank == 0 ? layout.stripeBytes() : 0);
+    vector<char> unit(layout.unit), parity(layout.unit), term(layout.unit);
+    vector<int> counts(size), displs(size), order(size);
+    vector<bool> take(size);
+    for (int j = 0; j < size; ++j) {
+        take[j] = j < layout.dataUnits();
+        order[j] = j;
+    }
+    const int words = static_cast<int>(layout.unit / sizeof(uint64_t));
+    double encode_time = 0, encoded = 0;
+    bool ok = true;
 
-            vector<int> temp(BLOCK_SIZE);
-            MPI_Recv(temp.data(), BLOCK_SIZE, MPI_INT, i, 2, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            xorBlocks(recovered, recovered, temp);
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = MPI_Wtime();
+    for (long s = 0; s < stripes; ++s) {
+        if (rank == 0) {
+            uint64_t at = static_cast<uint64_t>(s) * layout.stripeBytes();
+            long got = preadAll(in, stripe.data(), stripe.size(), at);
+            ok = ok && got >= 0;
+            if (got >= 0 && static_cast<size_t>(got) < stripe.size())
+                memset(stripe.data() + got, 0, stripe.size() - got);  // relleno de la última franja
         }
 
-        // Aplica XOR con la paridad para recuperar los datos faltantes
-        xorBlocks(recovered, recovered, parity);
+        // Unidades de datos a sus ranks; los de paridad no reciben nada
+        stripeCounts(layout, s, take, order, counts, displs);
+        const int slot = layout.slotOf(s, rank);
+        const bool holds_parity = layout.holdsParity(s, rank);
+        if (holds_parity)
+            memset(unit.data(), 0, layout.unit);
+        MPI_Scatterv(stripe.data(), counts.data(), displs.data(), MPI_BYTE, unit.data(), counts[rank], MPI_BYTE,
+                     0, MPI_COMM_WORLD);
 
-        cout << "Datos recuperados del nodo " << failed_rank << ": ";
-        for (int val : recovered) cout << val << " ";
+        // Paridad i de la franja en su dueño: XOR de los aportes C[i][j] * dato j
+        for (int i = 0; i < layout.parity; ++i) {
+            const char* contribution = unit.data();
+            if (i > 0 && !holds_parity) {
+                double t = MPI_Wtime();
+                gfMul(rs.coefficient(i, slot), reinterpret_cast<const uint8_t*>(unit.data()),
+                      reinterpret_cast<uint8_t*>(term.data()), layout.unit);
+                encode_time += MPI_Wtime() - t;
+                encoded += layout.unit;
+                contribution = term.data();
+            }
+            const int root = layout.rankOf(s, layout.dataUnits() + i);
+            MPI_Reduce(contribution, parity.data(), words, MPI_UINT64_T, MPI_BXOR, root, MPI_COMM_WORLD);
+            if (rank == root)
+                ok = ok && chunks.write(s, parity.data());
+        }
+        if (!holds_parity)
+            ok = ok && chunks.write(s, unit.data());
+    }
+    ok = ok && chunks.sync();
+    double local = MPI_Wtime() - start, elapsed;
+    MPI_Reduce(&local, &elapsed, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    double work[2] = {encoded, encode_time}, total[2];
+    MPI_Reduce(work, total, 2, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (in >= 0)
+        close(in);
+
+    if (!allOk(ok)) {
+        if (rank == 0)
+            cerr << "[!] Error: falló la lectura de '" << opt.write_path << "' o la escritura de las unidades." << endl;
+        return false;
+    }
+    if (rank == 0) {
+        double mb = meta.bytes / 1e6;
+        cout << "Archivo guardado : " << opt.write_path << " (" << mb << " MB)" << endl;
+        cout << "Geometría        : " << size << " ranks, " << layout.dataUnits() << " datos + " << layout.parity
+             << " paridad(es) rotativas, unidad de " << layout.unit / double(1 << 20) << " MiB, " << stripes << " franjas" << endl;
+        cout << "Escritura        : " << elapsed << " s, " << (elapsed > 0 ? mb / elapsed : 0) << " MB/s" << endl;
+        if (layout.parity > 1)
+            cout << "Codificación GF  : kernel " << gfDispatch().name << ", "
+                 << (total[1] > 0 ? total[0] / total[1] / 1e9 : 0) << " GB/s por núcleo" << endl;
+    }
+    return true;
+}
+
+/**
+ * @brief Lee el arreglo: cada rank lee sus unidades en paralelo y rank 0 arma el archivo.
+ *
+ * Para cada franja, los ranks con datos leen su unidad del disco local al
+ * mismo tiempo y rank 0 las junta en orden con MPI_Gatherv. Si hay ranks
+ * fallados (--failed), en las franjas donde falta algún dato se piden en su
+ * lugar las primeras paridades sobrevivientes hasta juntar k unidades y rank 0
+ * decodifica los datos perdidos con Reed-Solomon.
+ *
+ * @param opt Opciones.
+ * @param rank Identificador del proceso.
+ * @param size Número total de procesos.
+ * @return false si falta el arreglo, hay demasiadas fallas o no se pudo escribir la salida (lo informa rank 0).
+ */
+bool readStore(const Options& opt, int rank, int size) {
+    vector<bool> failed(size, false);
+    for (int r : opt.failed)
+        failed[r] = true;
+    int source = 0;
+    while (source < size && failed[source])
+        ++source;
+
+    // Los discos de los ranks caídos pueden no estar: los metadatos vienen del primer sobreviviente
+    RaidMeta meta;
+    bool found = source < size && (failed[rank] || (loadMeta(raidPath(opt.dir, rank, "meta"), meta) && meta.ranks == size));
+    if (source < size)
+        MPI_Bcast(&meta, sizeof(meta), MPI_BYTE, source, MPI_COMM_WORLD);
+    if (!allOk(found)) {
+        if (rank == 0)
+            cerr << "[!] Error: no hay un arreglo de " << size << " ranks en '" << opt.dir << "' de todos los nodos." << endl;
+        return false;
+    }
+    if (static_cast<int>(opt.failed.size()) > meta.parity) {
+        if (rank == 0)
+            cerr << "[!] Error: el arreglo soporta " << meta.parity << " falla(s) y se pidieron " << opt.failed.size() << "." << endl;
+        return false;
+    }
+
+    const RaidLayout layout = meta.layout();
+    const int k = layout.dataUnits();
+    const ReedSolomon rs(k, layout.parity);
+    const long stripes = layout.stripes(meta.bytes);
+    ChunkFile chunks(raidPath(opt.dir, rank, "dat"), layout.unit, false);
+    int out = -1;
+    if (rank == 0)
+        out = open(opt.read_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (!allOk((failed[rank] || chunks.ok()) && (rank != 0 || out >= 0))) {
+        if (rank == 0)
+            cerr << "[!] Error: no se pudo abrir '" << opt.read_path << "' o las unidades locales." << endl;
+        if (out >= 0)
+            close(out);
+        return false;
+    }
+
+    // Datos en las posiciones 0..k-1 y las paridades que los reemplazan a continuación
+    vector<char> stripe(rank == 0 ? layout.unit * size : 0);
+    vector<char> unit(layout.unit);
+    vector<int> counts(size), displs(size), place(size);
+    vector<bool> take(size);
+    map<vector<int>, vector<uint8_t>> rows_cache;  ///< Coeficientes por patrón de posiciones disponibles
+    long degraded = 0;
+    double decode_time = 0;
+    bool ok = true;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = MPI_Wtime();
+    for (long s = 0; s < stripes; ++s) {
+        // Las primeras k posiciones sobrevivientes, datos primero
+        vector<int> available, missing;
+        int extra = k;
+        for (int j = 0; j < size; ++j) {
+            bool alive = !failed[layout.rankOf(s, j)];
+            take[j] = alive && static_cast<int>(available.size()) < k;
+            if (take[j]) {
+                available.push_back(j);
+                place[j] = j < k ? j : extra++;
+            } else if (j < k) {
+                missing.push_back(j);
+            }
+        }
+        stripeCounts(layout, s, take, place, counts, displs);
+
+        if (take[layout.slotOf(s, rank)])
+            ok = chunks.read(s, unit.data()) && ok;
+        MPI_Gatherv(unit.data(), counts[rank], MPI_BYTE, stripe.data(), counts.data(), displs.data(), MPI_BYTE,
+                    0, MPI_COMM_WORLD);
+
+        if (rank == 0 && !missing.empty()) {
+            double t = MPI_Wtime();
+            auto cached = rows_cache.find(available);
+            if (cached == rows_cache.end()) {
+                vector<uint8_t> rows;
+                rs.recoveryRows(available, missing, rows);
+                cached = rows_cache.emplace(available, rows).first;
+            }
+            vector<const uint8_t*> sources;
+            vector<uint8_t*> outputs;
+            for (int j : available)
+                sources.push_back(reinterpret_cast<const uint8_t*>(stripe.data()) + place[j] * layout.unit);
+            for (int j : missing)
+                outputs.push_back(reinterpret_cast<uint8_t*>(stripe.data()) + j * layout.unit);
+            rs.reconstruct(cached->second, sources.data(), outputs.data(), static_cast<int>(missing.size()), layout.unit);
+            decode_time += MPI_Wtime() - t;
+            ++degraded;
+        }
+
+        if (rank == 0) {
+            uint64_t at = static_cast<uint64_t>(s) * layout.stripeBytes();
+            size_t n = static_cast<size_t>(min<uint64_t>(layout.stripeBytes(), meta.bytes - at));
+            ok = pwriteAll(out, stripe.data(), n, at) && ok;
+        }
+    }
+    double local = MPI_Wtime() - start, elapsed;
+    MPI_Reduce(&local, &elapsed, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    if (out >= 0)
+        close(out);
+
+    if (!allOk(ok)) {
+        if (rank == 0)
+            cerr << "[!] Error: falló la lectura de las unidades o la escritura de '" << opt.read_path << "'." << endl;
+        return false;
+    }
+    if (rank == 0) {
+        double mb = meta.bytes / 1e6;
+        cout << "Archivo leído    : " << opt.read_path << " (" << mb << " MB, " << stripes << " franjas)" << endl;
+        cout << "Lectura          : " << elapsed << " s, " << (elapsed > 0 ? mb / elapsed : 0) << " MB/s" << endl;
+        if (!opt.failed.empty()) {
+            cout << "Ranks fallados   :";
+            for (int r : opt.failed)
+                cout << " " << r;
+            cout << " (" << degraded << " franjas reconstruidas";
+            if (degraded > 0)
+                cout << ", decodificación " << (layout.parity == 1 ? xorDispatch().name : gfDispatch().name) << " a "
+                     << (decode_time > 0 ? degraded * layout.stripeBytes() / decode_time / 1e9 : 0) << " GB/s";
+            cout << ")" << endl;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Reconstruye todas las unidades de un rank perdido sobre su disco de reemplazo.
+ *
+ * La unidad perdida de cada franja es una combinación de k unidades
+ * sobrevivientes (el XOR de todas en RAID-5). Cada sobreviviente calcula su
+ * término y los términos se suman con MPI_Ireduce(MPI_BXOR) hacia el rank
+ * reconstruido, que así recibe un solo flujo en vez de uno por nodo y no hace
+ * los XOR en serie: la reducción en árbol los reparte entre los nodos. La
+ * unidad se corta en trozos de --chunk KiB con hasta RECOVER_WINDOW
+ * reducciones en vuelo, de modo que la transferencia de un trozo se solapa
+ * con el XOR del anterior.
+ *
+ * Los sobrevivientes elegidos dependen solo de la rotación (s mod P), así que
+ * hay un comunicador por rotación con esos k ranks y el reconstruido.
+ *
+ * @param opt Opciones.
+ * @param rank Identificador del proceso.
+ * @param size Número total de procesos.
+ * @return false si no hay suficientes sobrevivientes o falló algún archivo (lo informa rank 0).
+ */
+bool recoverStore(const Options& opt, int rank, int size) {
+    vector<bool> failed(size, false);
+    failed[opt.recover] = true;
+    for (int r : opt.failed)
+        failed[r] = true;
+    int source = 0;
+    while (source < size && failed[source])
+        ++source;
+
+    // El disco del rank reconstruido se perdió: los metadatos vienen de un sobreviviente
+    RaidMeta meta;
+    bool found = source < size && (failed[rank] || (loadMeta(raidPath(opt.dir, rank, "meta"), meta) && meta.ranks == size));
+    if (source < size)
+        MPI_Bcast(&meta, sizeof(meta), MPI_BYTE, source, MPI_COMM_WORLD);
+    const int lost = static_cast<int>(count(failed.begin(), failed.end(), true));
+    if (!allOk(found) || lost > meta.parity) {
+        if (rank == 0)
+            cerr << "[!] Error: no hay un arreglo de " << size << " ranks en '" << opt.dir << "' que soporte "
+                 << lost << " falla(s)." << endl;
+        return false;
+    }
+
+    const RaidLayout layout = meta.layout();
+    const int k = layout.dataUnits();
+    const ReedSolomon rs(k, layout.parity);
+    const long stripes = layout.stripes(meta.bytes);
+    const bool target = rank == opt.recover;
+
+    // Por rotación: comunicador de los k sobrevivientes elegidos más el reconstruido (rank 0 en él)
+    const int rotations = static_cast<int>(min<long>(size, stripes));
+    vector<MPI_Comm> comms(rotations, MPI_COMM_NULL);
+    vector<uint8_t> coefficient(rotations, 0);
+    for (int r = 0; r < rotations; ++r) {
+        vector<int> available;
+        for (int j = 0; j < size && static_cast<int>(available.size()) < k; ++j)
+            if (!failed[layout.rankOf(r, j)])
+                available.push_back(j);
+        vector<uint8_t> rows;
+        rs.recoveryRows(available, vector<int>(1, layout.slotOf(r, opt.recover)), rows);
+        int color = target ? 0 : MPI_UNDEFINED;
+        for (int t = 0; t < k; ++t)
+            if (layout.rankOf(r, available[t]) == rank) {
+                color = 0;
+                coefficient[r] = rows[t];
+            }
+        MPI_Comm_split(MPI_COMM_WORLD, color, target ? -1 : rank, &comms[r]);
+    }
+
+    ChunkFile chunks(raidPath(opt.dir, rank, "dat"), layout.unit, target);
+    bool ready = failed[rank] && !target ? true : chunks.ok();
+    if (target)
+        ready = ready && saveMeta(raidPath(opt.dir, rank, "meta"), meta);
+    if (!allOk(ready)) {
+        if (rank == 0)
+            cerr << "[!] Error: no se pudieron abrir las unidades en '" << opt.dir << "'." << endl;
+        for (MPI_Comm& c : comms)
+            if (c != MPI_COMM_NULL)
+                MPI_Comm_free(&c);
+        return false;
+    }
+
+    const size_t chunk = opt.chunk == 0 ? layout.unit : min(opt.chunk, layout.unit);
+    const int pieces = static_cast<int>((layout.unit + chunk - 1) / chunk);
+    vector<char> unit(layout.unit), term(layout.unit);
+    vector<MPI_Request> requests(RECOVER_WINDOW, MPI_REQUEST_NULL);
+    double compute = 0;
+    bool ok = true;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = MPI_Wtime();
+    for (long s = 0; s < stripes; ++s) {
+        MPI_Comm comm = comms[s % size];
+        if (comm == MPI_COMM_NULL)
+            continue;
+        if (target)
+            memset(unit.data(), 0, layout.unit);
+        else
+            ok = chunks.read(s, unit.data()) && ok;
+
+        for (int c = 0; c < pieces; ++c) {
+            size_t at = c * chunk, len = min(chunk, layout.unit - at);
+            MPI_Request& request = requests[c % RECOVER_WINDOW];
+            MPI_Wait(&request, MPI_STATUS_IGNORE);
+
+            const char* mine = unit.data() + at;
+            if (!target && coefficient[s % size] != 1) {
+                double t = MPI_Wtime();
+                gfMul(coefficient[s % size], reinterpret_cast<const uint8_t*>(unit.data() + at),
+                      reinterpret_cast<uint8_t*>(term.data() + at), len);
+                compute += MPI_Wtime() - t;
+                mine = term.data() + at;
+            }
+            const int words = static_cast<int>(len / sizeof(uint64_t));
+            MPI_Ireduce(target ? MPI_IN_PLACE : mine, target ? unit.data() + at : nullptr, words, MPI_UINT64_T,
+                        MPI_BXOR, 0, comm, &request);
+        }
+        MPI_Waitall(RECOVER_WINDOW, requests.data(), MPI_STATUSES_IGNORE);
+        if (target)
+            ok = chunks.write(s, unit.data()) && ok;
+    }
+    if (target)
+        ok = chunks.sync() && ok;
+    double local = MPI_Wtime() - start, elapsed;
+    MPI_Reduce(&local, &elapsed, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    for (MPI_Comm& c : comms)
+        if (c != MPI_COMM_NULL)
+            MPI_Comm_free(&c);
+
+    if (!allOk(ok)) {
+        if (rank == 0)
+            cerr << "[!] Error: falló la lectura de las unidades sobrevivientes o la escritura de las reconstruidas." << endl;
+        return false;
+    }
+    if (rank == 0) {
+        double mb = static_cast<double>(stripes) * layout.unit / 1e6;
+        cout << "Rank reconstruido: " << opt.recover << " (" << mb << " MB en " << stripes << " unidades)" << endl;
+        cout << "Reducción        : árbol MPI_Ireduce, trozos de " << chunk / 1024 << " KiB, " << RECOVER_WINDOW
+             << " en vuelo" << endl;
+        cout << "Reconstrucción   : " << elapsed << " s, " << (elapsed > 0 ? mb / elapsed : 0) << " MB/s" << endl;
+    }
+    return true;
+}
+
+/// Encabezado de cada tramo en los mensajes de actualización; le siguen sus bytes
+struct Piece {
+    int64_t stripe;  ///< Franja
+    uint64_t at;     ///< Desplazamiento dentro de la unidad
+    uint64_t bytes;  ///< Bytes que siguen al encabezado
+};
+
+/// Agrega un tramo con sus bytes al mensaje de un destino
+void appendPiece(vector<char>& message, long stripe, size_t at, const void* data, size_t n) {
+    Piece piece = {stripe, at, n};
+    size_t used = message.size();
+    message.resize(used + sizeof(piece) + n);
+    memcpy(message.data() + used, &piece, sizeof(piece));
+    memcpy(message.data() + used + sizeof(piece), data, n);
+}
+
+/**
+ * @brief Manda outgoing[r] a cada rank r con MPI_Alltoallv.
+ *
+ * MPI_Alltoallv cuenta en int: un vaciado manda cada byte sucio una vez por
+ * unidad de paridad y un rank de paridad lo recibe de hasta P - 1 ranks, lo
+ * que puede pasar de INT_MAX. Por eso los mensajes viajan en rondas de a lo
+ * más INT_MAX / P bytes por par de ranks, y cada rank junta lo recibido de
+ * cada origen antes de concatenarlo.
+ *
+ * @return Los mensajes recibidos, concatenados por rank de origen.
+ */
+vector<char> exchangePieces(const vector<vector<char>>& outgoing, int size) {
+    vector<uint64_t> send_bytes(size), recv_bytes(size);
+    for (int r = 0; r < size; ++r)
+        send_bytes[r] = outgoing[r].size();
+    MPI_Alltoall(send_bytes.data(), 1, MPI_UINT64_T, recv_bytes.data(), 1, MPI_UINT64_T, MPI_COMM_WORLD);
+
+    const uint64_t round = INT_MAX / size;
+    uint64_t largest = max(*max_element(send_bytes.begin(), send_bytes.end()),
+                           *max_element(recv_bytes.begin(), recv_bytes.end())),
+             rounds;
+    largest = (largest + round - 1) / round;
+    MPI_Allreduce(&largest, &rounds, 1, MPI_UINT64_T, MPI_MAX, MPI_COMM_WORLD);
+
+    vector<vector<char>> from(size);
+    vector<int> send_counts(size), recv_counts(size), send_displs(size), recv_displs(size);
+    vector<char> send, received;
+    for (uint64_t i = 0; i < max<uint64_t>(rounds, 1); ++i) {
+        const uint64_t begin = i * round;
+        send.clear();
+        int total = 0;
+        for (int r = 0; r < size; ++r) {
+            send_displs[r] = static_cast<int>(send.size());
+            send_counts[r] = static_cast<int>(send_bytes[r] > begin ? min(round, send_bytes[r] - begin) : 0);
+            send.insert(send.end(), outgoing[r].begin() + min<uint64_t>(begin, send_bytes[r]),
+                        outgoing[r].begin() + min<uint64_t>(begin, send_bytes[r]) + send_counts[r]);
+            recv_displs[r] = total;
+            recv_counts[r] = static_cast<int>(recv_bytes[r] > begin ? min(round, recv_bytes[r] - begin) : 0);
+            total += recv_counts[r];
+        }
+        received.resize(total);
+        MPI_Alltoallv(send.data(), send_counts.data(), send_displs.data(), MPI_BYTE, received.data(),
+                      recv_counts.data(), recv_displs.data(), MPI_BYTE, MPI_COMM_WORLD);
+        if (rounds <= 1)
+            return received;
+        for (int r = 0; r < size; ++r)
+            from[r].insert(from[r].end(), received.begin() + recv_displs[r],
+                           received.begin() + recv_displs[r] + recv_counts[r]);
+    }
+    received.clear();
+    for (int r = 0; r < size; ++r)
+        received.insert(received.end(), from[r].begin(), from[r].end());
+    return received;
+}
+
+/**
+ * @brief Recorre los tramos de un mensaje recibido.
+ * @param message Tramos concatenados por appendPiece.
+ * @param visit Función llamada con (encabezado, bytes) de cada tramo.
+ */
+template <typename Visit>
+void forEachPiece(const vector<char>& message, Visit visit) {
+    for (size_t at = 0; at + sizeof(Piece) <= message.size();) {
+        Piece piece;
+        memcpy(&piece, message.data() + at, sizeof(piece));
+        visit(piece, reinterpret_cast<const uint8_t*>(message.data() + at + sizeof(piece)));
+        at += sizeof(piece) + piece.bytes;
+    }
+}
+
+/// Contadores de las escrituras pequeñas de un rank
+struct UpdateStats {
+    double client = 0;   ///< Bytes que rank 0 mandó a otros ranks de datos
+    double deltas = 0;   ///< Bytes de delta mandados a los ranks de paridad
+    double stripes = 0;  ///< Franjas cuya primera paridad se actualizó, sumando todos los vaciados
+    double flushes = 0;  ///< Vaciados de la caché
+};
+
+/**
+ * @brief Vacía la caché write-back de todos los ranks (colectiva).
+ *
+ * Cada rank lee el dato viejo de sus tramos sucios, escribe el nuevo y manda
+ * a cada rank de paridad de la franja el delta viejo XOR nuevo, multiplicado
+ * por su coeficiente. Los deltas de una franja que llegan de distintos ranks
+ * de datos caen en la misma zona de la unidad de paridad, así que se juntan
+ * en tramos y cada tramo de paridad se lee y reescribe una sola vez.
+ *
+ * @return false si falló alguna lectura o escritura local.
+ */
+bool flushCache(const RaidLayout& layout, const ReedSolomon& rs, ChunkFile& chunks, WriteBackCache& cache, int rank,
+                int size, UpdateStats& stats) {
+    const int k = layout.dataUnits();
+    vector<vector<char>> deltas(size);
+    vector<uint8_t> delta, term;
+    bool ok = true;
+    for (const auto& stripe : cache.stripes()) {
+        const long s = stripe.first;
+        const int slot = layout.slotOf(s, rank);
+        for (const auto& extent : stripe.second) {
+            const size_t at = extent.first, n = extent.second.size();
+            delta.resize(n);
+            ok = chunks.readAt(s, at, delta.data(), n) && ok;
+            xorAdd(delta.data(), extent.second.data(), n);
+            ok = chunks.writeAt(s, at, extent.second.data(), n) && ok;
+            for (int i = 0; i < layout.parity; ++i) {
+                const uint8_t c = rs.coefficient(i, slot);
+                const uint8_t* scaled = delta.data();
+                if (c != 1) {
+                    term.resize(n);
+                    gfMul(c, delta.data(), term.data(), n);
+                    scaled = term.data();
+                }
+                appendPiece(deltas[layout.rankOf(s, k + i)], s, at, scaled, n);
+                stats.deltas += n;
+            }
+        }
+    }
+    cache.clear();
+
+    // Deltas recibidos, por franja; cada grupo de tramos que se solapan o tocan es una sola lectura-escritura
+    vector<char> received = exchangePieces(deltas, size);
+    map<long, vector<pair<Piece, const uint8_t*>>> pieces;
+    forEachPiece(received, [&](const Piece& piece, const uint8_t* data) {
+        pieces[piece.stripe].emplace_back(piece, data);
+    });
+    vector<uint8_t> parity;
+    for (auto& stripe : pieces) {
+        auto& list = stripe.second;
+        sort(list.begin(), list.end(), [](const pair<Piece, const uint8_t*>& a, const pair<Piece, const uint8_t*>& b) {
+            return a.first.at < b.first.at;
+        });
+        if (layout.parityRank(stripe.first) == rank)
+            ++stats.stripes;
+        for (size_t first = 0; first < list.size();) {
+            size_t lo = list[first].first.at, hi = lo + list[first].first.bytes, last = first + 1;
+            while (last < list.size() && list[last].first.at <= hi) {
+                hi = max<size_t>(hi, list[last].first.at + list[last].first.bytes);
+                ++last;
+            }
+            parity.resize(hi - lo);
+            ok = chunks.readAt(stripe.first, lo, parity.data(), hi - lo) && ok;
+            for (size_t p = first; p < last; ++p)
+                xorAdd(parity.data() + (list[p].first.at - lo), list[p].second, list[p].first.bytes);
+            ok = chunks.writeAt(stripe.first, lo, parity.data(), hi - lo) && ok;
+            first = last;
+        }
+    }
+    ++stats.flushes;
+    return ok;
+}
+
+/**
+ * @brief Siguiente escritura al azar del cliente: desplazamiento en el archivo y bytes nuevos.
+ * @param rng Generador, con la misma semilla en cada ejecución.
+ * @param bytes Tamaño del archivo guardado.
+ * @param data Bytes nuevos (su tamaño es el de la escritura, a lo más bytes).
+ * @return Desplazamiento en el archivo.
+ */
+uint64_t nextWrite(mt19937_64& rng, uint64_t bytes, vector<uint8_t>& data) {
+    uint64_t offset = rng() % (bytes - data.size() + 1);
+    for (size_t i = 0; i < data.size(); i += sizeof(uint64_t)) {
+        uint64_t word = rng();
+        memcpy(data.data() + i, &word, min(sizeof(word), data.size() - i));
+    }
+    return offset;
+}
+
+/**
+ * @brief Aplica escrituras pequeñas al azar sobre el archivo guardado, actualizando la paridad por deltas.
+ *
+ * Rank 0 hace de cliente: genera las escrituras por lotes, las corta en
+ * tramos de unidad y manda cada tramo al rank que guarda ese dato. Cada rank
+ * los junta en su caché write-back (raid_cache.hpp) y, cuando la de algún
+ * rank se llena, todos la vacían con flushCache. Así la red y el disco
+ * mueven solo los bytes que cambiaron más sus deltas, en vez de franjas
+ * completas, y las zonas escritas varias veces llegan una sola vez a la
+ * paridad. Con --cache 0 cada escritura se vacía apenas llega.
+ *
+ * @param opt Opciones.
+ * @param rank Identificador del proceso.
+ * @param size Número total de procesos.
+ * @return false si falta el arreglo o falló algún archivo (lo informa rank 0).
+ */
+bool updateStore(const Options& opt, int rank, int size) {
+    RaidMeta meta;
+    bool found = loadMeta(raidPath(opt.dir, rank, "meta"), meta) && meta.ranks == size;
+    if (!allOk(found && meta.bytes >= opt.write_size)) {
+        if (rank == 0)
+            cerr << "[!] Error: no hay un arreglo de " << size << " ranks en '" << opt.dir
+                 << "' con al menos " << opt.write_size << " bytes." << endl;
+        return false;
+    }
+    const RaidLayout layout = meta.layout();
+    const ReedSolomon rs(layout.dataUnits(), layout.parity);
+    ChunkFile chunks(raidPath(opt.dir, rank, "dat"), layout.unit, false);
+    if (!allOk(chunks.ok())) {
+        if (rank == 0)
+            cerr << "[!] Error: no se pudieron abrir las unidades en '" << opt.dir << "'." << endl;
+        return false;
+    }
+
+    WriteBackCache cache(opt.cache);
+    // Escrituras del próximo lote: las que caben en la caché más llena, para no pasarse de --cache
+    auto batchFor = [&](size_t dirty) {
+        if (opt.cache == 0)
+            return 1L;
+        size_t room = opt.cache > dirty ? opt.cache - dirty : 0;
+        return max(1L, min(UPDATE_BATCH, static_cast<long>(room / opt.write_size)));
+    };
+    long batch = batchFor(0);
+    mt19937_64 rng(opt.seed);
+    vector<uint8_t> data(opt.write_size);
+    UpdateStats stats;
+    bool ok = true;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = MPI_Wtime();
+    for (long done = 0; done < opt.updates;) {
+        batch = min(batch, opt.updates - done);
+        // El cliente corta cada escritura en tramos de unidad para sus dueños
+        vector<vector<char>> outgoing(size);
+        for (long w = done; rank == 0 && w < done + batch; ++w) {
+            uint64_t offset = nextWrite(rng, meta.bytes, data);
+            for (size_t used = 0; used < data.size();) {
+                uint64_t in_stripe = (offset + used) % layout.stripeBytes();
+                long s = static_cast<long>((offset + used) / layout.stripeBytes());
+                size_t at = in_stripe % layout.unit;
+                size_t n = min(data.size() - used, layout.unit - at);
+                int owner = layout.rankOf(s, static_cast<int>(in_stripe / layout.unit));
+                appendPiece(outgoing[owner], s, at, data.data() + used, n);
+                if (owner != 0)
+                    stats.client += n;
+                used += n;
+            }
+        }
+        forEachPiece(exchangePieces(outgoing, size), [&](const Piece& piece, const uint8_t* bytes) {
+            cache.put(piece.stripe, piece.at, bytes, piece.bytes);
+        });
+
+        done += batch;
+
+        // Se vacía si alguna caché se llenó; el próximo lote se ajusta al espacio de la más llena
+        unsigned long state[2] = {cache.full() || done >= opt.updates, cache.dirtyBytes()}, any[2];
+        MPI_Allreduce(state, any, 2, MPI_UNSIGNED_LONG, MPI_MAX, MPI_COMM_WORLD);
+        if (any[0]) {
+            ok = flushCache(layout, rs, chunks, cache, rank, size, stats) && ok;
+            any[1] = 0;
+        }
+        batch = batchFor(any[1]);
+    }
+    ok = chunks.sync() && ok;
+    double local = MPI_Wtime() - start, elapsed;
+    MPI_Reduce(&local, &elapsed, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    double counters[4] = {stats.client, stats.deltas, stats.stripes, static_cast<double>(cache.absorbed())}, total[4];
+    MPI_Reduce(counters, total, 4, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    if (!allOk(ok)) {
+        if (rank == 0)
+            cerr << "[!] Error: falló la lectura o escritura de las unidades." << endl;
+        return false;
+    }
+    if (rank == 0) {
+        double mb = static_cast<double>(opt.updates) * opt.write_size / 1e6;
+        double full = total[2] * layout.unit * layout.dataUnits() * (1 + layout.parity) / 1e6;
+        cout << "Escrituras       : " << opt.updates << " de " << opt.write_size << " bytes al azar (" << mb
+             << " MB) en " << elapsed << " s, " << (elapsed > 0 ? opt.updates / elapsed : 0) << " escrituras/s, "
+             << (elapsed > 0 ? mb / elapsed : 0) << " MB/s" << endl;
+        cout << "Caché write-back : " << opt.cache / double(1 << 20) << " MiB por rank, " << stats.flushes << " vaciados, "
+             << total[3] / 1e6 << " MB pisados antes de llegar a la paridad" << endl;
+        cout << "Tráfico          : " << total[0] / 1e6 << " MB del cliente + " << total[1] / 1e6
+             << " MB de deltas (reescribir las " << total[2] << " franjas tocadas: " << full << " MB)" << endl;
+    }
+    return true;
+}
+
+/// Etiquetas de los mensajes de --serve
+enum ServeTag { TAG_REQUEST = 1, TAG_REPLY, TAG_REBUILD, TAG_REBUILT, TAG_DONE };
+
+/// Pedido del cliente: un tramo de una unidad, multiplicado por coef antes de responder
+struct ReadRequest {
+    int64_t stripe;
+    uint64_t at;     ///< Desplazamiento dentro de la unidad
+    uint64_t bytes;
+    int32_t coef;    ///< 1 para una lectura normal; el de la fila de recuperación en modo degradado
+};
+
+/**
+ * @brief Quiénes y con qué coeficientes reconstruyen las posiciones perdidas de cada rotación.
+ *
+ * Las franjas s y s + P tienen la misma rotación, así que basta con una
+ * entrada por rotación: los ranks de las primeras k posiciones sobrevivientes
+ * y, para cada posición perdida, sus k coeficientes.
+ */
+struct Recovery {
+    vector<int> ranks;                ///< Ranks que aportan, en el orden de las filas
+    map<int, vector<uint8_t>> rows;   ///< Posición perdida → k coeficientes
+};
+
+/**
+ * @brief Lecturas al azar del cliente mientras, en paralelo, se reconstruye un rank caído en un repuesto.
+ *
+ * Cada rank corre un bucle sin bloquearse: atiende los pedidos de lectura,
+ * avanza su parte de la reconstrucción y, si es el cliente, sus propias
+ * lecturas. Una lectura de un dato perdido se pide a los k sobrevivientes de
+ * su franja, que responden su tramo ya multiplicado por el coeficiente, y el
+ * cliente lo decodifica con XOR. La reconstrucción manda al repuesto (el rank
+ * extra, si se lanzaron P + 1 procesos) la unidad de cada sobreviviente
+ * multiplicada por su coeficiente, franja por franja, sin pasar de
+ * --rebuild-rate MB/s para que las lecturas no esperen detrás de ella. El
+ * repuesto las junta y escribe las unidades del rank caído.
+ *
+ * @param opt Opciones.
+ * @param rank Identificador del proceso.
+ * @param size Número total de procesos.
+ * @return false si falta el arreglo, hay demasiadas fallas o falló algún archivo (lo informa rank 0).
+ */
+bool serveStore(const Options& opt, int rank, int size) {
+    // Los metadatos vienen de un rank con arreglo: el repuesto no tiene
+    RaidMeta meta;
+    bool found = rank == size - 1 || (loadMeta(raidPath(opt.dir, rank, "meta"), meta) && meta.ranks >= size - 1);
+    MPI_Bcast(&meta, sizeof(meta), MPI_BYTE, 0, MPI_COMM_WORLD);
+    const int ranks = meta.ranks;
+    const bool has_spare = size == ranks + 1;
+    bool valid = found && (size == ranks || has_spare) && static_cast<int>(opt.failed.size()) <= meta.parity &&
+                 (!has_spare || !opt.failed.empty()) && meta.bytes >= opt.read_size;
+    for (int r : opt.failed)
+        valid = valid && r < ranks;
+    if (!allOk(valid)) {
+        if (rank == 0)
+            cerr << "[!] Error: hace falta un arreglo en '" << opt.dir << "' con " << size << " ranks (o " << size - 1
+                 << " más un repuesto y --failed), a lo más " << meta.parity << " falla(s) y al menos "
+                 << opt.read_size << " bytes." << endl;
+        return false;
+    }
+
+    const RaidLayout layout = meta.layout();
+    const int k = layout.dataUnits();
+    const ReedSolomon rs(k, layout.parity);
+    const long stripes = layout.stripes(meta.bytes);
+    vector<bool> failed(size, false);
+    for (int r : opt.failed)
+        failed[r] = true;
+    const int spare = has_spare ? ranks : -1;
+    const int lost = has_spare ? opt.failed[0] : -1;  ///< Rank que se reconstruye en el repuesto
+    int client = 0;
+    while (failed[client])
+        ++client;
+
+    vector<Recovery> recovery(ranks);
+    for (int r = 0; r < ranks; ++r) {
+        vector<int> available, missing;
+        for (int j = 0; j < ranks; ++j) {
+            if (failed[layout.rankOf(r, j)])
+                missing.push_back(j);
+            else if (static_cast<int>(available.size()) < k)
+                available.push_back(j);
+        }
+        for (int j : available)
+            recovery[r].ranks.push_back(layout.rankOf(r, j));
+        for (int j : missing)
+            rs.recoveryRows(available, vector<int>(1, j), recovery[r].rows[j]);
+    }
+
+    // El repuesto recibe las unidades del rank perdido; los caídos no abren nada
+    const bool storage = rank < ranks && !failed[rank];
+    ChunkFile chunks(raidPath(opt.dir, rank == spare ? lost : rank, "dat"), layout.unit, rank == spare);
+    bool ready = !storage && rank != spare ? true : chunks.ok();
+    if (rank == spare)
+        ready = ready && saveMeta(raidPath(opt.dir, lost, "meta"), meta);
+    if (!allOk(ready)) {
+        if (rank == 0)
+            cerr << "[!] Error: no se pudieron abrir las unidades en '" << opt.dir << "'." << endl;
+        return false;
+    }
+
+    // Parte de la reconstrucción de este rank: franjas a las que aporta (o todas, en el repuesto)
+    vector<long> mine;
+    for (long s = 0; has_spare && s < stripes; ++s) {
+        const vector<int>& from = recovery[s % ranks].ranks;
+        if (rank == spare || find(from.begin(), from.end(), rank) != from.end())
+            mine.push_back(s);
+    }
+    const double rate = opt.rebuild_rate * 1e6;  ///< Bytes reconstruidos por segundo como máximo (0: sin límite)
+    struct Slot {
+        long stripe = -1;
+        vector<vector<char>> buffers;
+        vector<MPI_Request> requests;
+    };
+    vector<Slot> window(REBUILD_WINDOW);
+    for (Slot& slot : window) {
+        int parts = rank == spare ? k : 1;
+        slot.buffers.assign(parts, vector<char>(layout.unit));
+        slot.requests.assign(parts, MPI_REQUEST_NULL);
+    }
+    size_t next = 0, finished = 0;  ///< Próxima franja de mine por empezar y franjas ya terminadas
+
+    // Estado del cliente: una lectura a la vez, con sus tramos pedidos en vuelo
+    mt19937_64 rng(opt.seed);
+    vector<uint8_t> buffer(opt.read_size);
+    vector<vector<uint8_t>> parts;  ///< Aportes recibidos de los tramos degradados, uno por sobreviviente
+    vector<uint8_t*> merges;        ///< Destino del XOR de cada aporte
+    vector<MPI_Request> pending;
+    vector<double> latency, latency_rebuild;
+    long reads = 0, degraded = 0;
+    double issued = 0, rebuilt_at = -1, first_read = 0, last_read = 0;
+    bool reading = false;
+    uint64_t checksum = 1469598103934665603ULL;  // FNV-1a de todos los bytes leídos
+
+    bool done = false, ok = true;
+    vector<char> scratch(layout.unit);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    const double start = MPI_Wtime();
+    double rebuild_end = start;
+    for (;;) {
+        // 1. Pedidos de lectura (en cualquier rank con unidades)
+        int flag;
+        MPI_Status status;
+        MPI_Iprobe(MPI_ANY_SOURCE, TAG_REQUEST, MPI_COMM_WORLD, &flag, &status);
+        if (flag) {
+            ReadRequest request;
+            MPI_Recv(&request, sizeof(request), MPI_BYTE, status.MPI_SOURCE, TAG_REQUEST, MPI_COMM_WORLD,
+                     MPI_STATUS_IGNORE);
+            vector<uint8_t> raw(request.bytes), piece(request.bytes);
+            ok = chunks.readAt(request.stripe, request.at, raw.data(), request.bytes) && ok;
+            gfMul(static_cast<uint8_t>(request.coef), raw.data(), piece.data(), request.bytes);
+            MPI_Send(piece.data(), static_cast<int>(request.bytes), MPI_BYTE, status.MPI_SOURCE, TAG_REPLY,
+                     MPI_COMM_WORLD);
+        }
+        if (!done && rank != client) {
+            MPI_Iprobe(client, TAG_DONE, MPI_COMM_WORLD, &flag, MPI_STATUS_IGNORE);
+            if (flag) {
+                MPI_Recv(nullptr, 0, MPI_BYTE, client, TAG_DONE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                done = true;
+            }
+        }
+
+        // 2. Reconstrucción: terminar las franjas en vuelo y empezar otra si el límite lo permite
+        for (Slot& slot : window) {
+            if (slot.stripe < 0)
+                continue;
+            int complete;
+            MPI_Testall(static_cast<int>(slot.requests.size()), slot.requests.data(), &complete, MPI_STATUSES_IGNORE);
+            if (!complete)
+                continue;
+            if (rank == spare) {
+                vector<const uint8_t*> sources;
+                for (const vector<char>& b : slot.buffers)
+                    sources.push_back(reinterpret_cast<const uint8_t*>(b.data()));
+                xorInto(reinterpret_cast<uint8_t*>(scratch.data()), sources.data(), k, layout.unit);
+                ok = chunks.write(slot.stripe, scratch.data()) && ok;
+            }
+            slot.stripe = -1;
+            if (++finished == mine.size()) {
+                rebuild_end = MPI_Wtime();
+                if (rank == spare)
+                    MPI_Send(nullptr, 0, MPI_BYTE, client, TAG_REBUILT, MPI_COMM_WORLD);
+            }
+        }
+        if (next < mine.size() && (rate == 0 || (mine[next] + 1) * layout.unit <= rate * (MPI_Wtime() - start))) {
+            auto free_slot = find_if(window.begin(), window.end(), [](const Slot& slot) { return slot.stripe < 0; });
+            if (free_slot != window.end()) {
+                const long s = mine[next++];
+                const Recovery& from = recovery[s % ranks];
+                free_slot->stripe = s;
+                if (rank == spare) {
+                    for (int t = 0; t < k; ++t)
+                        MPI_Irecv(free_slot->buffers[t].data(), static_cast<int>(layout.unit), MPI_BYTE,
+                                  from.ranks[t], TAG_REBUILD, MPI_COMM_WORLD, &free_slot->requests[t]);
+                } else {
+                    const int t = static_cast<int>(find(from.ranks.begin(), from.ranks.end(), rank) - from.ranks.begin());
+                    const uint8_t c = from.rows.at(layout.slotOf(s, lost))[t];
+                    char* unit = free_slot->buffers[0].data();
+                    ok = chunks.read(s, c == 1 ? unit : scratch.data()) && ok;
+                    if (c != 1)
+                        gfMul(c, reinterpret_cast<const uint8_t*>(scratch.data()), reinterpret_cast<uint8_t*>(unit),
+                              layout.unit);
+                    MPI_Isend(unit, static_cast<int>(layout.unit), MPI_BYTE, spare, TAG_REBUILD, MPI_COMM_WORLD,
+                              &free_slot->requests[0]);
+                }
+            }
+        }
+
+        // 3. Cliente: terminar la lectura en vuelo o pedir la siguiente
+        if (rank == client) {
+            if (has_spare && rebuilt_at < 0) {
+                MPI_Iprobe(spare, TAG_REBUILT, MPI_COMM_WORLD, &flag, MPI_STATUS_IGNORE);
+                if (flag) {
+                    MPI_Recv(nullptr, 0, MPI_BYTE, spare, TAG_REBUILT, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                    rebuilt_at = MPI_Wtime();
+                }
+            }
+            int complete = 1;
+            if (reading)
+                MPI_Testall(static_cast<int>(pending.size()), pending.data(), &complete, MPI_STATUSES_IGNORE);
+            if (reading && complete) {
+                for (size_t p = 0; p < parts.size(); ++p)
+                    xorAdd(merges[p], parts[p].data(), parts[p].size());
+                for (uint8_t b : buffer)
+                    checksum = (checksum ^ b) * 1099511628211ULL;
+                last_read = MPI_Wtime();
+                (has_spare && rebuilt_at < 0 ? latency_rebuild : latency).push_back(last_read - issued);
+                reading = false;
+            }
+            if (!reading && reads < opt.serves) {
+                // Cada tramo de unidad va a su dueño o, si está caído, a los k sobrevivientes de la franja
+                uint64_t offset = rng() % (meta.bytes - opt.read_size + 1);
+                issued = MPI_Wtime();
+                if (reads == 0)
+                    first_read = issued;
+                parts.clear();
+                merges.clear();
+                pending.clear();
+                bool any_degraded = false;
+                for (size_t used = 0; used < buffer.size();) {
+                    uint64_t in_stripe = (offset + used) % layout.stripeBytes();
+                    long s = static_cast<long>((offset + used) / layout.stripeBytes());
+                    size_t at = in_stripe % layout.unit, n = min(buffer.size() - used, layout.unit - at);
+                    int slot = static_cast<int>(in_stripe / layout.unit), owner = layout.rankOf(s, slot);
+                    uint8_t* dst = buffer.data() + used;
+                    vector<pair<int, uint8_t>> sources(1, make_pair(owner, uint8_t(1)));
+                    if (failed[owner]) {
+                        any_degraded = true;
+                        memset(dst, 0, n);
+                        const Recovery& from = recovery[s % ranks];
+                        sources.clear();
+                        for (int t = 0; t < k; ++t)
+                            sources.emplace_back(from.ranks[t], from.rows.at(slot)[t]);
+                    }
+                    for (auto& source : sources) {
+                        if (source.first == rank) {
+                            // Tramo propio: se lee del disco local sin pasar por MPI
+                            ok = chunks.readAt(s, at, scratch.data(), n) && ok;
+                            if (failed[owner])
+                                gfMulAdd(source.second, reinterpret_cast<const uint8_t*>(scratch.data()), dst, n);
+                            else
+                                memcpy(dst, scratch.data(), n);
+                            continue;
+                        }
+                        uint8_t* target = dst;
+                        if (failed[owner]) {
+                            parts.emplace_back(n);
+                            merges.push_back(dst);
+                            target = parts.back().data();
+                        }
+                        pending.push_back(MPI_REQUEST_NULL);
+                        MPI_Irecv(target, static_cast<int>(n), MPI_BYTE, source.first, TAG_REPLY, MPI_COMM_WORLD,
+                                  &pending.back());
+                        ReadRequest request = {s, at, n, source.second};
+                        MPI_Send(&request, sizeof(request), MPI_BYTE, source.first, TAG_REQUEST, MPI_COMM_WORLD);
+                    }
+                    used += n;
+                }
+                degraded += any_degraded;
+                ++reads;
+                reading = true;
+            }
+            if (!reading && reads == opt.serves && !done) {
+                for (int r = 0; r < size; ++r)
+                    if (r != rank)
+                        MPI_Send(nullptr, 0, MPI_BYTE, r, TAG_DONE, MPI_COMM_WORLD);
+                done = true;
+            }
+        }
+        // El cliente espera además el aviso del repuesto, para no dejar el mensaje sin recibir
+        if (done && finished == mine.size() && (rank != client || !has_spare || rebuilt_at >= 0))
+            break;
+    }
+    if (rank == spare)
+        ok = chunks.sync() && ok;
+    double rebuild_local = rank == spare ? rebuild_end - start : 0, rebuild_time;
+    MPI_Reduce(&rebuild_local, &rebuild_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    if (!allOk(ok)) {
+        if (rank == 0)
+            cerr << "[!] Error: falló la lectura o escritura de las unidades." << endl;
+        return false;
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank == client) {
+        double elapsed = last_read - first_read;
+        double mb = static_cast<double>(reads) * opt.read_size / 1e6;
+        cout << "Lecturas         : " << reads << " de " << opt.read_size << " bytes al azar, " << degraded
+             << " degradadas, " << (elapsed > 0 ? reads / elapsed : 0) << " lecturas/s, "
+             << (elapsed > 0 ? mb / elapsed : 0) << " MB/s" << endl;
+        auto report = [](const char* label, vector<double>& samples) {
+            if (samples.empty())
+                return;
+            sort(samples.begin(), samples.end());
+            auto at = [&](double q) { return samples[static_cast<size_t>(q * (samples.size() - 1))] * 1e3; };
+            cout << label << samples.size() << " lecturas, p50 " << at(0.5) << " ms, p95 " << at(0.95)
+                 << " ms, p99 " << at(0.99) << " ms, máx " << samples.back() * 1e3 << " ms" << endl;
+        };
+        report("Latencia durante : ", latency_rebuild);
+        report(has_spare ? "Latencia después : " : "Latencia         : ", latency);
+        cout << "Suma FNV-1a      : " << hex << checksum << dec << endl;
+    }
+    if (rank == 0 && has_spare) {
+        double mb = static_cast<double>(stripes) * layout.unit / 1e6;
+        cout << "Reconstrucción   : rank " << lost << " en el repuesto (rank " << spare << "), " << mb << " MB en "
+             << rebuild_time << " s, " << (rebuild_time > 0 ? mb / rebuild_time : 0) << " MB/s";
+        if (rate > 0)
+            cout << " (límite " << opt.rebuild_rate << " MB/s)";
         cout << endl;
-    } 
-    else if (rank != failed_rank) {
-        // Nodos válidos envían sus datos al maestro para recuperación
-        MPI_Send(data.data(), BLOCK_SIZE, MPI_INT, 0, 2, MPI_COMM_WORLD);
     }
+    return true;
+}
+
+/**
+ * @brief Función principal del programa. Controla la inicialización, distribución, recepción y recuperación de datos.
+ * 
+ * @param argc Número de argumentos de línea de comandos.
+ * @param argv Argumentos de línea de comandos.
+ * @return int Código de retorno del programa.
+ */
+int main(int argc, char** argv) {
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank); ///< Identificador del proceso
+    MPI_Comm_size(MPI_COMM_WORLD, &size); ///< Número total de procesos
+
+    Options opt;
+    bool valid = true;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--write") && i + 1 < argc)
+            opt.write_path = argv[++i];
+        else if (!strcmp(argv[i], "--read") && i + 1 < argc)
+            opt.read_path = argv[++i];
+        else if (!strcmp(argv[i], "--dir") && i + 1 < argc)
+            opt.dir = argv[++i];
+        else if (!strcmp(argv[i], "--unit") && i + 1 < argc)
+            opt.unit = static_cast<size_t>(atof(argv[++i]) * (1 << 20)) / 4096 * 4096;  // múltiplo de 4 KiB
+        else if (!strcmp(argv[i], "--parity") && i + 1 < argc)
+            opt.parity = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--recover") && i + 1 < argc)
+            opt.recover = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--chunk") && i + 1 < argc)
+            opt.chunk = static_cast<size_t>(atoi(argv[++i])) * 1024;
+        else if (!strcmp(argv[i], "--update") && i + 1 < argc)
+            opt.updates = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--write-size") && i + 1 < argc)
+            opt.write_size = static_cast<size_t>(atol(argv[++i]));
+        else if (!strcmp(argv[i], "--cache") && i + 1 < argc)
+            opt.cache = static_cast<size_t>(atof(argv[++i]) * (1 << 20));
+        else if (!strcmp(argv[i], "--serve") && i + 1 < argc)
+            opt.serves = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--read-size") && i + 1 < argc)
+            opt.read_size = static_cast<size_t>(atol(argv[++i]));
+        else if (!strcmp(argv[i], "--rebuild-rate") && i + 1 < argc)
+            opt.rebuild_rate = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            opt.seed = static_cast<unsigned>(atol(argv[++i]));
+        else if (!strcmp(argv[i], "--failed") && i + 1 < argc) {
+            stringstream list(argv[++i]);
+            string item;
+            while (getline(list, item, ','))
+                opt.failed.push_back(atoi(item.c_str()));
+        } else
+            valid = false;
+    }
+    for (int r : opt.failed)
+        valid = valid && r >= 0 && r < size && count(opt.failed.begin(), opt.failed.end(), r) == 1;
+    const int modes = !opt.write_path.empty() + !opt.read_path.empty() + (opt.recover >= 0) + (opt.updates > 0) + (opt.serves > 0);
+    valid = valid && opt.parity >= 1 && opt.parity < size && size <= 256 && modes <= 1 && opt.recover < size &&
+            (opt.failed.empty() || !opt.read_path.empty() || opt.recover >= 0 || opt.serves > 0 || modes == 0) &&
+            count(opt.failed.begin(), opt.failed.end(), opt.recover) == 0 && opt.chunk % 4096 == 0 &&
+            opt.updates >= 0 && opt.write_size >= 1 && opt.write_size <= (1 << 20) && opt.cache <= (256 << 20) &&
+            opt.serves >= 0 && opt.read_size >= 1 && opt.read_size <= (1 << 20) && opt.rebuild_rate >= 0;
+    // La demostración recupera un nodo de datos: no el maestro ni el último, que guarda la paridad
+    if (modes == 0)
+        valid = valid && opt.failed.size() <= 1 && (opt.failed.empty() || (opt.failed[0] >= 1 && opt.failed[0] < size - 1));
+    // Los desplazamientos de MPI_Scatterv/MPI_Gatherv son int: la franja debe bajar de 2 GiB
+    if (!valid || opt.unit == 0 || size < 2 || opt.unit * static_cast<size_t>(size - 1) >= (1ULL << 31)) {
+        if (rank == 0)
+            cerr << "[!] Error: uso: raid_mpi [--write archivo [--parity m] | --read salida [--failed r1,r2,...] | "
+                    "--recover r [--chunk KiB] [--failed ...] | --update n [--write-size bytes] [--cache MB] [--seed s] | "
+                    "--serve n [--read-size bytes] [--rebuild-rate MB/s] [--failed ...]] "
+                    "[--unit MB] [--dir directorio], con 1 <= m < procesos <= 256, trozos múltiplos de 4 KiB, "
+                    "escrituras y lecturas de hasta 1 MiB, caché de hasta 256 MB y franjas de menos de 2 GiB." << endl;
+        MPI_Finalize();
+        return 1;
+    }
+
+    bool ok = true;
+    if (!opt.write_path.empty())
+        ok = writeStore(opt, rank, size);
+    else if (!opt.read_path.empty())
+        ok = readStore(opt, rank, size);
+    else if (opt.recover >= 0)
+        ok = recoverStore(opt, rank, size);
+    else if (opt.updates > 0)
+        ok = updateStore(opt, rank, size);
+    else if (opt.serves > 0)
+        ok = serveStore(opt, rank, size);
+    else
+        runDemo(rank, size, opt.failed.empty() ? 2 : opt.failed[0]);
 
     MPI_Finalize();
-    return 0;
+    return ok ? 0 : 1;
 }
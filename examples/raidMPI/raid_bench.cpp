@@ -0,0 +1,104 @@
+/**
+ * @file raid_bench.cpp
+ * @brief Mide los GB/s de los kernels de paridad en un solo núcleo, sin MPI.
+ *
+ * Para cada tamaño de unidad y número de fuentes k mide:
+ * - XOR de k fuentes con el kernel escalar y con el de la CPU (raid_xor.hpp).
+ * - Codificación Reed-Solomon k+2 y decodificación de 2 datos perdidos (raid_rs.hpp).
+ *
+ * Los GB/s cuentan los bytes de las fuentes, como una unidad de franja por
+ * fuente. Con unidades que no caben en caché el XOR debería acercarse al
+ * ancho de banda de memoria del nodo.
+ *
+ * Uso:
+ *   ./raid_bench [segundos por medida]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "raid_rs.hpp"
+
+using namespace std;
+
+/**
+ * @brief Repite una operación hasta juntar el tiempo pedido.
+ * @param seconds Tiempo mínimo de medida.
+ * @param bytes Bytes de fuentes que procesa cada repetición.
+ * @param op Operación a medir.
+ * @return GB/s.
+ */
+template <typename Op>
+double measure(double seconds, size_t bytes, Op op) {
+    op();  // calienta cachés y páginas
+    long reps = 0;
+    auto start = chrono::steady_clock::now();
+    double elapsed = 0;
+    do {
+        op();
+        ++reps;
+        elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    } while (elapsed < seconds);
+    return static_cast<double>(bytes) * reps / elapsed / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+    const double seconds = argc > 1 ? atof(argv[1]) : 0.2;
+    const size_t sizes[] = {4 << 10, 64 << 10, 1 << 20, 16 << 20};
+    const int counts[] = {2, 4, 8, 16};
+
+    cout << "Kernel XOR: " << xorDispatch().name << ", kernel GF: " << gfDispatch().name << " (GB/s por núcleo)"
+         << endl;
+    cout << setw(10) << "unidad" << setw(8) << "k" << setw(12) << "xor esc." << setw(12) << "xor simd" << setw(12)
+         << "rs cod." << setw(12) << "rs dec." << endl;
+    cout << fixed << setprecision(2);
+
+    for (size_t n : sizes) {
+        for (int k : counts) {
+            // Unidades contiguas y alineadas a 64 bytes, como las de un buffer de franja
+            const size_t stride = (n + 63) / 64 * 64;
+            vector<uint8_t> arena(stride * (k + 2) + 64);
+            uint8_t* base = arena.data() + (64 - reinterpret_cast<uintptr_t>(arena.data()) % 64) % 64;
+            vector<const uint8_t*> data(k);
+            for (int j = 0; j < k; ++j) {
+                data[j] = base + j * stride;
+                for (size_t i = 0; i < n; ++i)
+                    base[j * stride + i] = static_cast<uint8_t>(i * 131 + j * 7);
+            }
+            uint8_t* parity[2] = {base + k * stride, base + (k + 1) * stride};
+            const size_t bytes = n * k;
+
+            double scalar = measure(seconds, bytes, [&] { xorInto(xorScalar, parity[0], data.data(), k, n); });
+            double simd = measure(seconds, bytes, [&] { xorInto(parity[0], data.data(), k, n); });
+
+            const ReedSolomon rs(k, 2);
+            double encode = measure(seconds, bytes, [&] { rs.encode(data.data(), parity, n); });
+
+            // Se pierden los dos primeros datos: se decodifican desde el resto y las paridades
+            vector<int> available, missing = {0, 1};
+            vector<const uint8_t*> sources;
+            for (int j = 2; j < k + 2; ++j) {
+                available.push_back(j);
+                sources.push_back(j < k ? data[j] : parity[j - k]);
+            }
+            vector<uint8_t> rows;
+            rs.recoveryRows(available, missing, rows);
+            vector<uint8_t> lost(2 * n);
+            uint8_t* outputs[2] = {lost.data(), lost.data() + n};
+            double decode = measure(seconds, bytes, [&] { rs.reconstruct(rows, sources.data(), outputs, 2, n); });
+            if (!equal(outputs[0], outputs[0] + n, data[0]) || !equal(outputs[1], outputs[1] + n, data[1])) {
+                cerr << "[!] Error: la decodificación no recupera los datos (unidad " << n << ", k " << k << ")."
+                     << endl;
+                return 1;
+            }
+
+            cout << setw(10) << (n >= (1 << 20) ? to_string(n >> 20) + " MiB" : to_string(n >> 10) + " KiB")
+                 << setw(8) << k << setw(12) << scalar << setw(12) << simd << setw(12) << encode << setw(12) << decode
+                 << endl;
+        }
+    }
+    return 0;
+}
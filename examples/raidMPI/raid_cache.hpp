@@ -0,0 +1,95 @@
+/**
+ * @file raid_cache.hpp
+ * @brief Caché write-back de un rank: junta las escrituras pequeñas de cada franja antes de tocar la paridad.
+ *
+ * Cada escritura pequeña obliga a leer el dato viejo, mandar el delta
+ * (viejo XOR nuevo) a los ranks de paridad y reescribir la paridad. Si la
+ * misma zona se escribe varias veces, o se escriben zonas vecinas, conviene
+ * hacer ese trabajo una sola vez: la caché guarda los bytes nuevos de la
+ * unidad local de cada franja como tramos disjuntos, fusionando los que se
+ * solapan o se tocan, y solo se vacía cuando se llena.
+ */
+
+#ifndef RAID_CACHE_HPP
+#define RAID_CACHE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+
+/**
+ * @brief Tramos sucios de las unidades locales, por franja.
+ */
+class WriteBackCache {
+public:
+    /// Tramos de una franja: desplazamiento dentro de la unidad → bytes nuevos
+    typedef std::map<size_t, std::vector<uint8_t>> Extents;
+
+    /// @param capacity Bytes sucios a partir de los cuales full() pide vaciarla
+    explicit WriteBackCache(size_t capacity) : capacity_(capacity) {}
+
+    /**
+     * @brief Guarda bytes nuevos de la unidad local de una franja.
+     * @param stripe Franja.
+     * @param at Desplazamiento dentro de la unidad.
+     * @param data Bytes nuevos.
+     * @param n Cantidad de bytes.
+     */
+    void put(long stripe, size_t at, const uint8_t* data, size_t n) {
+        Extents& extents = stripes_[stripe];
+        size_t begin = at, end = at + n;
+
+        // Primer tramo que se solapa o toca [at, at + n)
+        auto it = extents.upper_bound(at);
+        if (it != extents.begin() && std::prev(it)->first + std::prev(it)->second.size() >= at)
+            --it;
+        auto last = it;
+        while (last != extents.end() && last->first <= end) {
+            begin = std::min(begin, last->first);
+            end = std::max(end, last->first + last->second.size());
+            ++last;
+        }
+
+        // Tramo fusionado: los viejos primero y los bytes nuevos encima
+        std::vector<uint8_t> merged(end - begin);
+        size_t covered = 0;
+        for (auto e = it; e != last; ++e) {
+            memcpy(merged.data() + (e->first - begin), e->second.data(), e->second.size());
+            covered += e->second.size();
+        }
+        memcpy(merged.data() + (at - begin), data, n);
+        absorbed_ += n + covered - merged.size();
+        dirty_ += merged.size() - covered;
+        extents.erase(it, last);
+        extents.emplace(begin, std::move(merged));
+    }
+
+    /// Bytes sucios guardados
+    size_t dirtyBytes() const { return dirty_; }
+
+    /// Si hay que vaciarla
+    bool full() const { return dirty_ >= capacity_; }
+
+    /// Bytes que no llegan a la paridad porque otra escritura los pisó mientras estaban en la caché
+    size_t absorbed() const { return absorbed_; }
+
+    /// Tramos sucios por franja, en orden
+    const std::map<long, Extents>& stripes() const { return stripes_; }
+
+    /// Olvida los tramos ya escritos
+    void clear() {
+        stripes_.clear();
+        dirty_ = 0;
+    }
+
+private:
+    size_t capacity_;
+    size_t dirty_ = 0;
+    size_t absorbed_ = 0;
+    std::map<long, Extents> stripes_;
+};
+
+#endif
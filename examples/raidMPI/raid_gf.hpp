@@ -0,0 +1,206 @@
+/**
+ * @file raid_gf.hpp
+ * @brief Aritmética en GF(2^8) y el kernel dst ^= c * src con tablas partidas en SIMD.
+ *
+ * La multiplicación de un byte b por una constante c se separa en sus dos
+ * nibbles: c * b = c * (b & 15) ^ c * (b & 0xf0), así que basta con dos
+ * tablas de 16 entradas por constante. Una instrucción de búsqueda en tabla
+ * de 16 bytes (PSHUFB en SSSE3/AVX2, TBL en NEON) resuelve 16 o 32 bytes a la
+ * vez. El kernel se elige al ejecutar según la CPU (AVX2, SSSE3 o escalar en
+ * x86; NEON en ARM), de modo que el mismo binario corre en toda la red.
+ */
+
+#ifndef RAID_GF_HPP
+#define RAID_GF_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "raid_xor.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RAID_GF_X86 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RAID_GF_NEON 1
+#endif
+
+/// Polinomio de reducción x^8 + x^4 + x^3 + x^2 + 1 (el de RAID-6 en Linux)
+constexpr unsigned GF_POLY = 0x11d;
+
+/**
+ * @brief Tablas de logaritmos, exponenciales y tablas partidas de cada constante.
+ */
+struct GfTables {
+    uint8_t exp[512];        ///< exp[i] = 2^i, duplicada para no reducir el índice
+    uint8_t log[256];        ///< log[x] para x != 0
+    uint8_t split[256][32];  ///< Para cada c: c * nibble bajo (16 bytes) y c * nibble alto (16 bytes)
+
+    GfTables() {
+        unsigned x = 1;
+        for (int i = 0; i < 255; ++i) {
+            exp[i] = exp[i + 255] = static_cast<uint8_t>(x);
+            log[x] = static_cast<uint8_t>(i);
+            x <<= 1;
+            if (x & 0x100)
+                x ^= GF_POLY;
+        }
+        exp[510] = exp[511] = exp[0];
+        log[0] = 0;
+        for (int c = 0; c < 256; ++c)
+            for (int n = 0; n < 16; ++n) {
+                split[c][n] = mul(static_cast<uint8_t>(c), static_cast<uint8_t>(n));
+                split[c][16 + n] = mul(static_cast<uint8_t>(c), static_cast<uint8_t>(n << 4));
+            }
+    }
+
+    /// Producto en GF(2^8)
+    uint8_t mul(uint8_t a, uint8_t b) const { return a && b ? exp[log[a] + log[b]] : 0; }
+
+    /// Inverso multiplicativo (a != 0)
+    uint8_t inv(uint8_t a) const { return exp[255 - log[a]]; }
+};
+
+/// Tablas compartidas, construidas en el primer uso
+inline const GfTables& gfTables() {
+    static const GfTables tables;
+    return tables;
+}
+
+/// Kernel dst[i] ^= c * src[i], con las tablas partidas de c
+typedef void (*GfKernel)(const uint8_t* split, const uint8_t* src, uint8_t* dst, size_t n);
+
+/// Versión escalar, usada también para las colas de las versiones SIMD
+inline void gfMulAddScalar(const uint8_t* split, const uint8_t* src, uint8_t* dst, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        dst[i] ^= split[src[i] & 15] ^ split[16 + (src[i] >> 4)];
+}
+
+#if RAID_GF_X86
+__attribute__((target("ssse3"))) inline void gfMulAddSsse3(const uint8_t* split, const uint8_t* src, uint8_t* dst,
+                                                           size_t n) {
+    const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(split));
+    const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(split + 16));
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i p = _mm_xor_si128(_mm_shuffle_epi8(lo, _mm_and_si128(s, mask)),
+                                  _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi64(s, 4), mask)));
+        __m128i* d = reinterpret_cast<__m128i*>(dst + i);
+        _mm_storeu_si128(d, _mm_xor_si128(_mm_loadu_si128(d), p));
+    }
+    gfMulAddScalar(split, src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2"))) inline void gfMulAddAvx2(const uint8_t* split, const uint8_t* src, uint8_t* dst,
+                                                         size_t n) {
+    const __m256i lo = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(split)));
+    const __m256i hi = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(split + 16)));
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        // Dos vectores por vuelta para no esperar la latencia de cada búsqueda
+        __m256i s0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i s1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 32));
+        __m256i p0 = _mm256_xor_si256(_mm256_shuffle_epi8(lo, _mm256_and_si256(s0, mask)),
+                                      _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi64(s0, 4), mask)));
+        __m256i p1 = _mm256_xor_si256(_mm256_shuffle_epi8(lo, _mm256_and_si256(s1, mask)),
+                                      _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi64(s1, 4), mask)));
+        __m256i* d = reinterpret_cast<__m256i*>(dst + i);
+        _mm256_storeu_si256(d, _mm256_xor_si256(_mm256_loadu_si256(d), p0));
+        _mm256_storeu_si256(d + 1, _mm256_xor_si256(_mm256_loadu_si256(d + 1), p1));
+    }
+    gfMulAddSsse3(split, src + i, dst + i, n - i);
+}
+#endif
+
+#if RAID_GF_NEON
+inline void gfMulAddNeon(const uint8_t* split, const uint8_t* src, uint8_t* dst, size_t n) {
+    const uint8x16_t mask = vdupq_n_u8(0x0f);
+    size_t i = 0;
+#if defined(__aarch64__)
+    const uint8x16_t lo = vld1q_u8(split), hi = vld1q_u8(split + 16);
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t s = vld1q_u8(src + i);
+        uint8x16_t p = veorq_u8(vqtbl1q_u8(lo, vandq_u8(s, mask)), vqtbl1q_u8(hi, vshrq_n_u8(s, 4)));
+        vst1q_u8(dst + i, veorq_u8(vld1q_u8(dst + i), p));
+    }
+#else
+    // ARMv7: TBL de 8 bytes sobre una tabla de 16 (dos registros D)
+    const uint8x8x2_t lo = {{vld1_u8(split), vld1_u8(split + 8)}};
+    const uint8x8x2_t hi = {{vld1_u8(split + 16), vld1_u8(split + 24)}};
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t s = vld1q_u8(src + i);
+        uint8x16_t l = vandq_u8(s, mask), h = vshrq_n_u8(s, 4);
+        uint8x16_t p = vcombine_u8(veor_u8(vtbl2_u8(lo, vget_low_u8(l)), vtbl2_u8(hi, vget_low_u8(h))),
+                                   veor_u8(vtbl2_u8(lo, vget_high_u8(l)), vtbl2_u8(hi, vget_high_u8(h))));
+        vst1q_u8(dst + i, veorq_u8(vld1q_u8(dst + i), p));
+    }
+#endif
+    gfMulAddScalar(split, src + i, dst + i, n - i);
+}
+#endif
+
+/**
+ * @brief Kernel elegido para esta CPU.
+ */
+struct GfDispatch {
+    GfKernel kernel;
+    const char* name;
+
+    GfDispatch() : kernel(gfMulAddScalar), name("escalar") {
+#if RAID_GF_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            kernel = gfMulAddAvx2;
+            name = "avx2";
+        } else if (__builtin_cpu_supports("ssse3")) {
+            kernel = gfMulAddSsse3;
+            name = "ssse3";
+        }
+#elif RAID_GF_NEON
+        kernel = gfMulAddNeon;
+        name = "neon";
+#endif
+    }
+};
+
+/// Kernel de la CPU actual, elegido en el primer uso
+inline const GfDispatch& gfDispatch() {
+    static const GfDispatch dispatch;
+    return dispatch;
+}
+
+/**
+ * @brief dst ^= c * src sobre n bytes.
+ * @param c Constante.
+ * @param src Origen.
+ * @param dst Destino acumulado.
+ * @param n Bytes.
+ */
+inline void gfMulAdd(uint8_t c, const uint8_t* src, uint8_t* dst, size_t n) {
+    if (c == 0)
+        return;
+    if (c == 1) {
+        xorAdd(dst, src, n);  // multiplicar por 1 es copiar: basta el XOR
+        return;
+    }
+    gfDispatch().kernel(gfTables().split[c], src, dst, n);
+}
+
+/**
+ * @brief dst = c * src sobre n bytes (src y dst no se solapan).
+ */
+inline void gfMul(uint8_t c, const uint8_t* src, uint8_t* dst, size_t n) {
+    if (c == 1) {
+        memcpy(dst, src, n);
+        return;
+    }
+    memset(dst, 0, n);
+    gfMulAdd(c, src, dst, n);
+}
+
+#endif
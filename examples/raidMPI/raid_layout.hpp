@@ -0,0 +1,53 @@
+/**
+ * @file raid_layout.hpp
+ * @brief Geometría de las franjas: qué rank guarda cada unidad de datos y de paridad.
+ *
+ * El archivo se corta en franjas de k = ranks - parity unidades de datos más
+ * parity unidades de paridad; cada rank guarda exactamente una unidad de cada
+ * franja, en la posición stripe * unit de su archivo local. La paridad rota
+ * entre los ranks como en RAID-5 "left-symmetric": la franja 0 la guarda el
+ * último rank, la franja 1 el penúltimo, etc., y los datos siguen a la
+ * paridad. Así ningún rank concentra la paridad ni sus escrituras.
+ */
+
+#ifndef RAID_LAYOUT_HPP
+#define RAID_LAYOUT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Reparto de las unidades de cada franja entre los ranks.
+ *
+ * Las posiciones de una franja se numeran 0..k-1 para los datos y
+ * k..ranks-1 para las paridades. La posición j de la franja s la guarda el
+ * rank (j - s) mod ranks.
+ */
+struct RaidLayout {
+    int ranks = 0;      ///< Ranks que guardan unidades
+    int parity = 1;     ///< Unidades de paridad por franja
+    size_t unit = 0;    ///< Bytes por unidad
+
+    /// Unidades de datos por franja
+    int dataUnits() const { return ranks - parity; }
+
+    /// Bytes de datos por franja
+    size_t stripeBytes() const { return unit * static_cast<size_t>(dataUnits()); }
+
+    /// Franjas necesarias para guardar bytes de datos (la última va rellena con ceros)
+    long stripes(uint64_t bytes) const { return static_cast<long>((bytes + stripeBytes() - 1) / stripeBytes()); }
+
+    /// Rank que guarda la posición j de la franja s
+    int rankOf(long s, int j) const { return static_cast<int>(((j - s) % ranks + ranks) % ranks); }
+
+    /// Posición de la franja s que guarda el rank
+    int slotOf(long s, int rank) const { return static_cast<int>((rank + s) % ranks); }
+
+    /// Si el rank guarda paridad en la franja s
+    bool holdsParity(long s, int rank) const { return slotOf(s, rank) >= dataUnits(); }
+
+    /// Rank que guarda la primera paridad de la franja s
+    int parityRank(long s) const { return rankOf(s, dataUnits()); }
+};
+
+#endif
@@ -0,0 +1,186 @@
+/**
+ * @file raid_rs.hpp
+ * @brief Código Reed-Solomon k+m sistemático sobre GF(2^8) (raid_gf.hpp).
+ *
+ * Las k unidades de datos se guardan tal cual y las m paridades son
+ * combinaciones lineales de ellas con los coeficientes de una matriz de
+ * Cauchy, en la que toda submatriz cuadrada es invertible: cualquier
+ * conjunto de k unidades sobrevivientes (datos o paridades) basta para
+ * recuperar las demás, así que el arreglo soporta m fallas simultáneas. Las
+ * columnas se escalan para que la primera paridad sea el XOR de los datos,
+ * con lo que m = 1 es exactamente RAID-5 y m = 2 es P + Q.
+ */
+
+#ifndef RAID_RS_HPP
+#define RAID_RS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "raid_gf.hpp"
+
+/// Bytes procesados por vuelta al codificar: las fuentes y destinos del bloque caben en caché
+constexpr size_t RS_BLOCK = 64 * 1024;
+
+/**
+ * @brief Codificador / decodificador k+m.
+ *
+ * Las posiciones 0..k-1 son los datos y k..k+m-1 las paridades, como en
+ * RaidLayout.
+ */
+class ReedSolomon {
+public:
+    /**
+     * @brief Construye la matriz de codificación.
+     * @param k Unidades de datos.
+     * @param m Unidades de paridad (k + m <= 256).
+     */
+    ReedSolomon(int k, int m) : k_(k), m_(m), coding_(static_cast<size_t>(m) * k) {
+        const GfTables& gf = gfTables();
+        // Cauchy: 1 / (x_i + y_j) con x_i = k + i, y_j = j, todos distintos
+        for (int i = 0; i < m; ++i)
+            for (int j = 0; j < k; ++j)
+                coding_[i * k + j] = gf.inv(static_cast<uint8_t>((k + i) ^ j));
+        // Escalar la columna j por 1 / C[0][j] deja la primera fila en unos
+        for (int j = 0; j < k; ++j) {
+            uint8_t scale = gf.inv(coding_[j]);
+            for (int i = 0; i < m; ++i)
+                coding_[i * k + j] = gf.mul(coding_[i * k + j], scale);
+        }
+    }
+
+    int dataUnits() const { return k_; }
+    int parityUnits() const { return m_; }
+
+    /// Coeficiente del dato j en la paridad i
+    uint8_t coefficient(int i, int j) const { return coding_[i * k_ + j]; }
+
+    /**
+     * @brief Calcula las m paridades de k unidades de datos.
+     * @param data k punteros a los datos.
+     * @param parity m punteros a las paridades (se sobrescriben).
+     * @param n Bytes por unidad.
+     */
+    void encode(const uint8_t* const* data, uint8_t* const* parity, size_t n) const {
+        for (int i = 0; i < m_; ++i)
+            if (allOnes(&coding_[i * k_]))
+                xorInto(parity[i], data, k_, n);
+        for (size_t at = 0; at < n; at += RS_BLOCK) {
+            size_t len = std::min(RS_BLOCK, n - at);
+            for (int i = 0; i < m_; ++i) {
+                if (allOnes(&coding_[i * k_]))
+                    continue;
+                gfMul(coefficient(i, 0), data[0] + at, parity[i] + at, len);
+                for (int j = 1; j < k_; ++j)
+                    gfMulAdd(coefficient(i, j), data[j] + at, parity[i] + at, len);
+            }
+        }
+    }
+
+    /**
+     * @brief Coeficientes que reconstruyen unidades a partir de k sobrevivientes.
+     * @param available k posiciones disponibles, distintas.
+     * @param wanted Posiciones a reconstruir.
+     * @param rows Salida: wanted.size() filas de k coeficientes sobre available.
+     * @return false si available no tiene k posiciones válidas y distintas.
+     */
+    bool recoveryRows(const std::vector<int>& available, const std::vector<int>& wanted, std::vector<uint8_t>& rows) const {
+        if (static_cast<int>(available.size()) != k_)
+            return false;
+        // Filas de la matriz generadora [I; C] de las posiciones disponibles
+        std::vector<uint8_t> a(static_cast<size_t>(k_) * k_), inv(static_cast<size_t>(k_) * k_, 0);
+        for (int r = 0; r < k_; ++r) {
+            generatorRow(available[r], &a[r * k_]);
+            inv[r * k_ + r] = 1;
+        }
+        if (!invert(a, inv))
+            return false;
+
+        // fila(w) = G[w] * A^-1, porque unidad(w) = G[w] * datos = G[w] * A^-1 * disponibles
+        const GfTables& gf = gfTables();
+        rows.assign(wanted.size() * k_, 0);
+        std::vector<uint8_t> g(k_);
+        for (size_t w = 0; w < wanted.size(); ++w) {
+            generatorRow(wanted[w], g.data());
+            for (int j = 0; j < k_; ++j)
+                for (int t = 0; t < k_; ++t)
+                    rows[w * k_ + t] ^= gf.mul(g[j], inv[j * k_ + t]);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Reconstruye unidades con las filas de recoveryRows.
+     * @param rows Coeficientes, outputs filas de k.
+     * @param sources k unidades disponibles, en el orden de available.
+     * @param outputs Unidades reconstruidas.
+     * @param count Número de unidades a reconstruir.
+     * @param n Bytes por unidad.
+     */
+    void reconstruct(const std::vector<uint8_t>& rows, const uint8_t* const* sources, uint8_t* const* outputs,
+                     int count, size_t n) const {
+        for (int w = 0; w < count; ++w)
+            if (allOnes(&rows[w * k_]))
+                xorInto(outputs[w], sources, k_, n);
+        for (size_t at = 0; at < n; at += RS_BLOCK) {
+            size_t len = std::min(RS_BLOCK, n - at);
+            for (int w = 0; w < count; ++w) {
+                if (allOnes(&rows[w * k_]))
+                    continue;
+                std::fill(outputs[w] + at, outputs[w] + at + len, 0);
+                for (int t = 0; t < k_; ++t)
+                    gfMulAdd(rows[w * k_ + t], sources[t] + at, outputs[w] + at, len);
+            }
+        }
+    }
+
+private:
+    /// Si la fila es toda unos: la combinación es un XOR puro y va en una sola pasada
+    bool allOnes(const uint8_t* row) const {
+        return std::all_of(row, row + k_, [](uint8_t c) { return c == 1; });
+    }
+
+    /// Fila de [I; C] de la posición slot
+    void generatorRow(int slot, uint8_t* row) const {
+        for (int j = 0; j < k_; ++j)
+            row[j] = slot < k_ ? (j == slot) : coefficient(slot - k_, j);
+    }
+
+    /// Gauss-Jordan en GF(2^8): a pasa a I e inv a a^-1
+    bool invert(std::vector<uint8_t>& a, std::vector<uint8_t>& inv) const {
+        const GfTables& gf = gfTables();
+        for (int c = 0; c < k_; ++c) {
+            int pivot = c;
+            while (pivot < k_ && a[pivot * k_ + c] == 0)
+                ++pivot;
+            if (pivot == k_)
+                return false;
+            for (int j = 0; j < k_; ++j) {
+                std::swap(a[c * k_ + j], a[pivot * k_ + j]);
+                std::swap(inv[c * k_ + j], inv[pivot * k_ + j]);
+            }
+            uint8_t scale = gf.inv(a[c * k_ + c]);
+            for (int j = 0; j < k_; ++j) {
+                a[c * k_ + j] = gf.mul(a[c * k_ + j], scale);
+                inv[c * k_ + j] = gf.mul(inv[c * k_ + j], scale);
+            }
+            for (int r = 0; r < k_; ++r) {
+                uint8_t f = a[r * k_ + c];
+                if (r == c || f == 0)
+                    continue;
+                for (int j = 0; j < k_; ++j) {
+                    a[r * k_ + j] ^= gf.mul(f, a[c * k_ + j]);
+                    inv[r * k_ + j] ^= gf.mul(f, inv[c * k_ + j]);
+                }
+            }
+        }
+        return true;
+    }
+
+    int k_, m_;
+    std::vector<uint8_t> coding_;  ///< Matriz C, m filas de k
+};
+
+#endif
@@ -0,0 +1,175 @@
+/**
+ * @file raid_store.hpp
+ * @brief Archivo local de cada rank con sus unidades y los metadatos del arreglo.
+ *
+ * Cada rank guarda sus unidades en un archivo del disco de su nodo
+ * (raid_<rank>.dat dentro del directorio elegido), una por franja y en orden,
+ * junto a un archivo raid_<rank>.meta con el tamaño del archivo original y la
+ * geometría. Con los metadatos de cualquier rank basta para volver a leer.
+ */
+
+#ifndef RAID_STORE_HPP
+#define RAID_STORE_HPP
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <string>
+
+#include "raid_layout.hpp"
+
+/// Marca de los archivos de metadatos
+const uint64_t RAID_MAGIC = 0x3144494152495041ULL;  // "APIRAID1"
+
+/**
+ * @brief Metadatos del arreglo, iguales en todos los ranks.
+ */
+struct RaidMeta {
+    uint64_t magic = RAID_MAGIC;
+    uint64_t bytes = 0;     ///< Tamaño del archivo original
+    uint64_t unit = 0;      ///< Bytes por unidad
+    int32_t ranks = 0;      ///< Ranks del arreglo
+    int32_t parity = 1;     ///< Unidades de paridad por franja
+
+    /// Geometría descrita por los metadatos
+    RaidLayout layout() const {
+        RaidLayout l;
+        l.ranks = ranks;
+        l.parity = parity;
+        l.unit = unit;
+        return l;
+    }
+};
+
+/**
+ * @brief Ruta de un archivo del rank en el directorio local.
+ * @param dir Directorio local del nodo.
+ * @param rank Rank dueño del archivo.
+ * @param ext Extensión ("dat" o "meta").
+ */
+inline std::string raidPath(const std::string& dir, int rank, const char* ext) {
+    return dir + "/raid_" + std::to_string(rank) + "." + ext;
+}
+
+/**
+ * @brief Lee exactamente n bytes desde offset (menos solo si el archivo se acaba).
+ * @return Bytes leídos, o -1 si hubo error.
+ */
+inline long preadAll(int fd, void* buf, size_t n, uint64_t offset) {
+    size_t done = 0;
+    while (done < n) {
+        ssize_t r = pread(fd, static_cast<char*>(buf) + done, n - done, static_cast<off_t>(offset + done));
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r < 0)
+            return -1;
+        if (r == 0)
+            break;
+        done += static_cast<size_t>(r);
+    }
+    return static_cast<long>(done);
+}
+
+/**
+ * @brief Escribe exactamente n bytes en offset.
+ * @return true si se escribió todo.
+ */
+inline bool pwriteAll(int fd, const void* buf, size_t n, uint64_t offset) {
+    size_t done = 0;
+    while (done < n) {
+        ssize_t w = pwrite(fd, static_cast<const char*>(buf) + done, n - done, static_cast<off_t>(offset + done));
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            return false;
+        done += static_cast<size_t>(w);
+    }
+    return true;
+}
+
+/**
+ * @brief Archivo local con las unidades de un rank, una por franja.
+ */
+class ChunkFile {
+public:
+    /**
+     * @brief Abre (o crea) el archivo de unidades.
+     * @param path Ruta del archivo.
+     * @param unit Bytes por unidad.
+     * @param create Si se crea vacío en lugar de abrir el existente.
+     */
+    ChunkFile(const std::string& path, size_t unit, bool create)
+        : unit_(unit) {
+        fd_ = create ? open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) : open(path.c_str(), O_RDWR);
+    }
+
+    ~ChunkFile() {
+        if (fd_ >= 0)
+            close(fd_);
+    }
+
+    ChunkFile(const ChunkFile&) = delete;
+    ChunkFile& operator=(const ChunkFile&) = delete;
+
+    /// Si el archivo se pudo abrir
+    bool ok() const { return fd_ >= 0; }
+
+    /// Lee la unidad de la franja s
+    bool read(long s, void* buf) const { return preadAll(fd_, buf, unit_, offset(s)) == static_cast<long>(unit_); }
+
+    /// Escribe la unidad de la franja s
+    bool write(long s, const void* buf) { return pwriteAll(fd_, buf, unit_, offset(s)); }
+
+    /**
+     * @brief Lee solo una parte de la unidad de la franja s.
+     * @param s Franja.
+     * @param at Desplazamiento dentro de la unidad.
+     * @param buf Destino.
+     * @param n Bytes.
+     */
+    bool readAt(long s, size_t at, void* buf, size_t n) const {
+        return preadAll(fd_, buf, n, offset(s) + at) == static_cast<long>(n);
+    }
+
+    /// Escribe solo una parte de la unidad de la franja s (mismos parámetros que readAt)
+    bool writeAt(long s, size_t at, const void* buf, size_t n) { return pwriteAll(fd_, buf, n, offset(s) + at); }
+
+    /// Fuerza los datos al disco
+    bool sync() { return fdatasync(fd_) == 0; }
+
+private:
+    uint64_t offset(long s) const { return static_cast<uint64_t>(s) * unit_; }
+
+    int fd_;
+    size_t unit_;
+};
+
+/**
+ * @brief Guarda los metadatos del rank.
+ * @return true si se escribieron.
+ */
+inline bool saveMeta(const std::string& path, const RaidMeta& meta) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+    bool ok = pwriteAll(fd, &meta, sizeof(meta), 0) && fdatasync(fd) == 0;
+    close(fd);
+    return ok;
+}
+
+/**
+ * @brief Lee los metadatos del rank.
+ * @return true si el archivo existe y es válido.
+ */
+inline bool loadMeta(const std::string& path, RaidMeta& meta) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    bool ok = preadAll(fd, &meta, sizeof(meta), 0) == static_cast<long>(sizeof(meta)) && meta.magic == RAID_MAGIC;
+    close(fd);
+    return ok;
+}
+
+#endif
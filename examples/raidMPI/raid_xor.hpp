@@ -0,0 +1,246 @@
+/**
+ * @file raid_xor.hpp
+ * @brief XOR de N fuentes sobre un destino en una sola pasada, con SIMD y stores no temporales.
+ *
+ * La paridad de RAID-5 es solo XOR, así que su costo es el de mover la
+ * memoria: leer cada fuente una vez y escribir el destino una vez. Para eso
+ * el kernel carga la misma posición de todas las fuentes, las combina en
+ * registros y escribe el resultado, en vez de recorrer el destino una vez
+ * por fuente. Con muchas fuentes se trabaja por bloques de XOR_BLOCK bytes y
+ * de a XOR_FANIN fuentes, de modo que el destino parcial quede en L1 y el
+ * prefetcher no tenga que seguir más flujos de los que soporta. Con bloques
+ * grandes la escritura final usa stores no temporales, que no traen al caché
+ * líneas que no se van a volver a leer. El kernel (AVX2, SSE2 o escalar en
+ * x86; NEON en ARM) se elige al ejecutar como en raid_gf.hpp.
+ */
+
+#ifndef RAID_XOR_HPP
+#define RAID_XOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RAID_XOR_X86 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RAID_XOR_NEON 1
+#endif
+
+/// Bytes que se procesan por bloque cuando hay más de XOR_FANIN fuentes
+constexpr size_t XOR_BLOCK = 16 * 1024;
+
+/// Fuentes que el kernel combina en una pasada
+constexpr int XOR_FANIN = 8;
+
+/// Desde este tamaño el destino se escribe con stores no temporales
+constexpr size_t XOR_STREAM_BYTES = 1 << 20;
+
+/**
+ * @brief Kernel dst = src[0] ^ ... ^ src[count - 1] sobre n bytes.
+ *
+ * dst puede coincidir con src[0] (acumular). stream pide stores no
+ * temporales; el kernel los usa solo si dst está alineado.
+ */
+typedef void (*XorKernel)(uint8_t* dst, const uint8_t* const* src, int count, size_t n, bool stream);
+
+/// Bytes [from, n) de a palabras de 64 bits; también es la cola de las versiones SIMD
+inline void xorTail(uint8_t* dst, const uint8_t* const* src, int count, size_t from, size_t n) {
+    size_t i = from;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t acc, word;
+        memcpy(&acc, src[0] + i, 8);
+        for (int j = 1; j < count; ++j) {
+            memcpy(&word, src[j] + i, 8);
+            acc ^= word;
+        }
+        memcpy(dst + i, &acc, 8);
+    }
+    for (; i < n; ++i) {
+        uint8_t acc = src[0][i];
+        for (int j = 1; j < count; ++j)
+            acc ^= src[j][i];
+        dst[i] = acc;
+    }
+}
+
+/// Versión escalar
+inline void xorScalar(uint8_t* dst, const uint8_t* const* src, int count, size_t n, bool) {
+    xorTail(dst, src, count, 0, n);
+}
+
+#if RAID_XOR_X86
+__attribute__((target("sse2"))) inline void xorSse2(uint8_t* dst, const uint8_t* const* src, int count, size_t n,
+                                                    bool stream) {
+    stream = stream && (reinterpret_cast<uintptr_t>(dst) & 15) == 0;
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        const __m128i* s = reinterpret_cast<const __m128i*>(src[0] + i);
+        __m128i a0 = _mm_loadu_si128(s), a1 = _mm_loadu_si128(s + 1);
+        __m128i a2 = _mm_loadu_si128(s + 2), a3 = _mm_loadu_si128(s + 3);
+        for (int j = 1; j < count; ++j) {
+            s = reinterpret_cast<const __m128i*>(src[j] + i);
+            a0 = _mm_xor_si128(a0, _mm_loadu_si128(s));
+            a1 = _mm_xor_si128(a1, _mm_loadu_si128(s + 1));
+            a2 = _mm_xor_si128(a2, _mm_loadu_si128(s + 2));
+            a3 = _mm_xor_si128(a3, _mm_loadu_si128(s + 3));
+        }
+        __m128i* d = reinterpret_cast<__m128i*>(dst + i);
+        if (stream) {
+            _mm_stream_si128(d, a0);
+            _mm_stream_si128(d + 1, a1);
+            _mm_stream_si128(d + 2, a2);
+            _mm_stream_si128(d + 3, a3);
+        } else {
+            _mm_storeu_si128(d, a0);
+            _mm_storeu_si128(d + 1, a1);
+            _mm_storeu_si128(d + 2, a2);
+            _mm_storeu_si128(d + 3, a3);
+        }
+    }
+    if (stream)
+        _mm_sfence();
+    xorTail(dst, src, count, i, n);
+}
+
+__attribute__((target("avx2"))) inline void xorAvx2(uint8_t* dst, const uint8_t* const* src, int count, size_t n,
+                                                    bool stream) {
+    stream = stream && (reinterpret_cast<uintptr_t>(dst) & 31) == 0;
+    size_t i = 0;
+    for (; i + 128 <= n; i += 128) {
+        // Cuatro vectores por vuelta para tener varias cargas en vuelo
+        const __m256i* s = reinterpret_cast<const __m256i*>(src[0] + i);
+        __m256i a0 = _mm256_loadu_si256(s), a1 = _mm256_loadu_si256(s + 1);
+        __m256i a2 = _mm256_loadu_si256(s + 2), a3 = _mm256_loadu_si256(s + 3);
+        for (int j = 1; j < count; ++j) {
+            s = reinterpret_cast<const __m256i*>(src[j] + i);
+            a0 = _mm256_xor_si256(a0, _mm256_loadu_si256(s));
+            a1 = _mm256_xor_si256(a1, _mm256_loadu_si256(s + 1));
+            a2 = _mm256_xor_si256(a2, _mm256_loadu_si256(s + 2));
+            a3 = _mm256_xor_si256(a3, _mm256_loadu_si256(s + 3));
+        }
+        __m256i* d = reinterpret_cast<__m256i*>(dst + i);
+        if (stream) {
+            _mm256_stream_si256(d, a0);
+            _mm256_stream_si256(d + 1, a1);
+            _mm256_stream_si256(d + 2, a2);
+            _mm256_stream_si256(d + 3, a3);
+        } else {
+            _mm256_storeu_si256(d, a0);
+            _mm256_storeu_si256(d + 1, a1);
+            _mm256_storeu_si256(d + 2, a2);
+            _mm256_storeu_si256(d + 3, a3);
+        }
+    }
+    if (stream)
+        _mm_sfence();
+    xorTail(dst, src, count, i, n);
+}
+#endif
+
+#if RAID_XOR_NEON
+/// NEON no tiene stores no temporales con intrínsecos portables: stream se ignora
+inline void xorNeon(uint8_t* dst, const uint8_t* const* src, int count, size_t n, bool) {
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        uint8x16_t a0 = vld1q_u8(src[0] + i), a1 = vld1q_u8(src[0] + i + 16);
+        uint8x16_t a2 = vld1q_u8(src[0] + i + 32), a3 = vld1q_u8(src[0] + i + 48);
+        for (int j = 1; j < count; ++j) {
+            const uint8_t* s = src[j] + i;
+            a0 = veorq_u8(a0, vld1q_u8(s));
+            a1 = veorq_u8(a1, vld1q_u8(s + 16));
+            a2 = veorq_u8(a2, vld1q_u8(s + 32));
+            a3 = veorq_u8(a3, vld1q_u8(s + 48));
+        }
+        vst1q_u8(dst + i, a0);
+        vst1q_u8(dst + i + 16, a1);
+        vst1q_u8(dst + i + 32, a2);
+        vst1q_u8(dst + i + 48, a3);
+    }
+    xorTail(dst, src, count, i, n);
+}
+#endif
+
+/**
+ * @brief Kernel elegido para esta CPU.
+ */
+struct XorDispatch {
+    XorKernel kernel;
+    const char* name;
+
+    XorDispatch() : kernel(xorScalar), name("escalar") {
+#if RAID_XOR_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            kernel = xorAvx2;
+            name = "avx2";
+        } else if (__builtin_cpu_supports("sse2")) {
+            kernel = xorSse2;
+            name = "sse2";
+        }
+#elif RAID_XOR_NEON
+        kernel = xorNeon;
+        name = "neon";
+#endif
+    }
+};
+
+/// Kernel de la CPU actual, elegido en el primer uso
+inline const XorDispatch& xorDispatch() {
+    static const XorDispatch dispatch;
+    return dispatch;
+}
+
+/**
+ * @brief dst = src[0] ^ ... ^ src[count - 1] sobre n bytes, con el kernel dado.
+ *
+ * Hasta XOR_FANIN fuentes se combinan en una sola pasada. Con más, cada
+ * bloque de XOR_BLOCK bytes se acumula en dst de a XOR_FANIN - 1 fuentes
+ * mientras sigue en L1. Solo la última escritura de cada bloque es no
+ * temporal.
+ *
+ * @param kernel Kernel a usar.
+ * @param dst Destino; puede ser src[0].
+ * @param src Fuentes.
+ * @param count Número de fuentes (al menos 1).
+ * @param n Bytes.
+ */
+inline void xorInto(XorKernel kernel, uint8_t* dst, const uint8_t* const* src, int count, size_t n) {
+    const bool stream = n >= XOR_STREAM_BYTES;
+    if (count <= XOR_FANIN) {
+        kernel(dst, src, count, n, stream);
+        return;
+    }
+    const uint8_t* group[XOR_FANIN];
+    for (size_t at = 0; at < n; at += XOR_BLOCK) {
+        size_t len = std::min(XOR_BLOCK, n - at);
+        int j = 0;
+        while (j < count) {
+            // La primera pasada parte de src[0]; las siguientes acumulan sobre dst
+            int g = 0;
+            if (j > 0)
+                group[g++] = dst + at;
+            while (g < XOR_FANIN && j < count)
+                group[g++] = src[j++] + at;
+            kernel(dst + at, group, g, len, stream && j == count);
+        }
+    }
+}
+
+/// dst = src[0] ^ ... ^ src[count - 1] con el kernel de la CPU actual
+inline void xorInto(uint8_t* dst, const uint8_t* const* src, int count, size_t n) {
+    xorInto(xorDispatch().kernel, dst, src, count, n);
+}
+
+/**
+ * @brief dst ^= src sobre n bytes.
+ */
+inline void xorAdd(uint8_t* dst, const uint8_t* src, size_t n) {
+    const uint8_t* both[2] = {dst, src};
+    xorDispatch().kernel(dst, both, 2, n, false);
+}
+
+#endif
@@ -0,0 +1,12 @@
+scp RaidMPI.cpp *.hpp mpi@node02:~/uss-patagon-cluster/examples/raidMPI
+scp RaidMPI.cpp *.hpp mpi@node03:~/uss-patagon-cluster/examples/raidMPI
+scp RaidMPI.cpp *.hpp mpi@node04:~/uss-patagon-cluster/examples/raidMPI
+
+mpic++ -O3 RaidMPI.cpp -o raid_mpi
+echo "node01 ok"
+ssh node02 mpic++ -O3 ~/uss-patagon-cluster/examples/raidMPI/RaidMPI.cpp -o ~/uss-patagon-cluster/examples/raidMPI/raid_mpi
+echo "node02 ok"
+ssh node03 mpic++ -O3 ~/uss-patagon-cluster/examples/raidMPI/RaidMPI.cpp -o ~/uss-patagon-cluster/examples/raidMPI/raid_mpi
+echo "node03 ok"
+ssh node04 mpic++ -O3 ~/uss-patagon-cluster/examples/raidMPI/RaidMPI.cpp -o ~/uss-patagon-cluster/examples/raidMPI/raid_mpi
+echo "node04 ok"